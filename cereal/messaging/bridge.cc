@@ -1,4 +1,6 @@
 #include <cassert>
+#include <cstring>
+#include <sstream>
 
 #include "cereal/messaging/msgq_to_zmq.h"
 #include "cereal/services.h"
@@ -19,8 +21,41 @@ static std::vector<std::string> get_services(const std::string &whitelist_str, b
   return service_list;
 }
 
+static std::vector<std::string> split(const std::string &s, char delim) {
+  std::vector<std::string> ret;
+  std::stringstream ss(s);
+  for (std::string item; std::getline(ss, item, delim);) {
+    ret.push_back(item);
+  }
+  return ret;
+}
+
+// ZMQ_BRIDGE_POLICY="can:latest,modelV2:rate=5:zstd=3"
+static std::map<std::string, BridgePolicy> parse_policies(const std::string &policy_str) {
+  std::map<std::string, BridgePolicy> policies;
+  for (const auto &entry : split(policy_str, ',')) {
+    auto fields = split(entry, ':');
+    if (fields.empty() || fields[0].empty()) continue;
+
+    BridgePolicy &policy = policies[fields[0]];
+    for (int i = 1; i < fields.size(); ++i) {
+      const std::string &field = fields[i];
+      if (field == "latest") {
+        policy.latest_only = true;
+      } else if (util::starts_with(field, "rate=")) {
+        policy.max_rate = std::atof(field.c_str() + 5);
+      } else if (util::starts_with(field, "zstd=")) {
+        policy.zstd_level = std::atoi(field.c_str() + 5);
+      } else {
+        printf("unknown bridge policy [%s] for %s\n", field.c_str(), fields[0].c_str());
+      }
+    }
+  }
+  return policies;
+}
+
 void msgq_to_zmq(const std::vector<std::string> &endpoints, const std::string &ip) {
-  MsgqToZmq bridge;
+  MsgqToZmq bridge(parse_policies(util::getenv("ZMQ_BRIDGE_POLICY", "")), util::getenv("ZMQ_BRIDGE_STATS", 0));
   bridge.run(endpoints, ip);
 }
 
@@ -40,10 +75,26 @@ void zmq_to_msgq(const std::vector<std::string> &endpoints, const std::string &i
     sub2pub[sub_sock] = pub_sock;
   }
 
+  std::string decompressed;
   while (!do_exit) {
     for (auto sub_sock : poller->poll(100)) {
       std::unique_ptr<Message> msg(sub_sock->receive(true));
-      if (msg) {
+      if (!msg) continue;
+
+      // the sending bridge may be configured to compress this service
+      uint32_t magic = 0;
+      if (msg->getSize() >= sizeof(magic)) {
+        memcpy(&magic, msg->getData(), sizeof(magic));
+      }
+      if (magic == ZSTD_FRAME_MAGIC) {
+        auto size = ZSTD_getFrameContentSize(msg->getData(), msg->getSize());
+        if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN) continue;
+
+        decompressed.resize(size);
+        size_t ret = ZSTD_decompress(decompressed.data(), decompressed.size(), msg->getData(), msg->getSize());
+        if (ZSTD_isError(ret)) continue;
+        sub2pub[sub_sock]->send(decompressed.data(), ret);
+      } else {
         sub2pub[sub_sock]->sendMessage(msg.get());
       }
     }
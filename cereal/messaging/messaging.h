@@ -33,16 +33,24 @@ public:
   cereal::Event::Reader &operator[](const char *name) const;
 
 private:
+  struct SubMessage;
   bool all_(const std::vector<const char *> &service_list, bool valid, bool alive);
+  SubMessage *find(SubSocket *socket) const;
+  SubMessage *find(const char *name) const;
+  void receive(SubMessage *m, uint64_t current_time);
+  void update_alive(uint64_t current_time);
+
   Poller *poller_ = nullptr;
-  struct SubMessage;
-  std::map<SubSocket *, SubMessage *> messages_;
-  std::map<std::string, SubMessage *> services_;
+  // services are resolved to slots once, update() only walks this vector
+  std::vector<SubMessage *> messages_;
+  std::map<std::string, SubMessage *, std::less<>> services_;
 };
 
 class MessageBuilder : public capnp::MallocMessageBuilder {
 public:
   MessageBuilder() = default;
+  // build into a caller-owned zeroed segment, see FirstSegment
+  explicit MessageBuilder(kj::ArrayPtr<capnp::word> first_segment) : capnp::MallocMessageBuilder(first_segment) {}
 
   cereal::Event::Builder initEvent(bool valid = true) {
     cereal::Event::Builder event = initRoot<cereal::Event>();
@@ -100,3 +108,28 @@ private:
   kj::Array<capnp::word> aligned_buf;
   size_t words_size;
 };
+
+// Zeroed first segment that is reused across MessageBuilders. MallocMessageBuilder zeroes
+// the used part again on destruction, so the segment is ready for the next message.
+// fit() records the size of the last message; the segment only grows on the next get(),
+// so messages of a steady size are built without any heap allocation.
+class FirstSegment {
+public:
+  kj::ArrayPtr<capnp::word> get() {
+    if (segment.size() < words_size) {
+      segment = kj::heapArray<capnp::word>(words_size);
+      memset(segment.begin(), 0, segment.size() * sizeof(capnp::word));
+    }
+    return segment;
+  }
+  inline void fit(MessageBuilder &msg) {
+    size_t words = msg.getSerializedSize() / sizeof(capnp::word);
+    if (words > words_size) {
+      // leave headroom so a slowly growing message doesn't reallocate every time
+      words_size = words + words / 4;
+    }
+  }
+private:
+  kj::Array<capnp::word> segment;
+  size_t words_size = capnp::SUGGESTED_FIRST_SEGMENT_WORDS;
+};
@@ -1,12 +1,14 @@
 #include "cereal/messaging/msgq_to_zmq.h"
 
+#include <algorithm>
 #include <cassert>
 
+#include "common/timing.h"
 #include "common/util.h"
 
 extern ExitHandler do_exit;
 
-// Max messages to process per socket per poll
+// Max messages to process per socket per poll, so one busy socket can't starve the others
 constexpr int MAX_MESSAGES_PER_SOCKET = 50;
 
 static std::string recv_zmq_msg(void *sock) {
@@ -25,13 +27,16 @@ void MsgqToZmq::run(const std::vector<std::string> &endpoints, const std::string
   msgq_context = std::make_unique<MSGQContext>();
 
   // Create ZMQPubSockets for each endpoint
-  for (const auto &endpoint : endpoints) {
-    auto &socket_pair = socket_pairs.emplace_back();
-    socket_pair.endpoint = endpoint;
-    socket_pair.pub_sock = std::make_unique<ZMQPubSocket>();
-    int ret = socket_pair.pub_sock->connect(zmq_context.get(), endpoint);
+  for (const auto &name : endpoints) {
+    auto &endpoint = endpoints_.emplace_back(std::make_unique<Endpoint>());
+    endpoint->name = name;
+    if (auto it = policies.find(name); it != policies.end()) {
+      endpoint->policy = it->second;
+    }
+    endpoint->pub_sock = std::make_unique<ZMQPubSocket>();
+    int ret = endpoint->pub_sock->connect(zmq_context.get(), name);
     if (ret != 0) {
-      printf("Failed to create ZMQ publisher for [%s]: %s\n", endpoint.c_str(), zmq_strerror(zmq_errno()));
+      printf("Failed to create ZMQ publisher for [%s]: %s\n", name.c_str(), zmq_strerror(zmq_errno()));
       return;
     }
   }
@@ -40,38 +45,147 @@ void MsgqToZmq::run(const std::vector<std::string> &endpoints, const std::string
   std::thread thread(&MsgqToZmq::zmqMonitorThread, this);
 
   // Main loop for processing messages
+  double last_stats_time = seconds_since_boot();
   while (!do_exit) {
-    {
-      std::unique_lock lk(mutex);
-      cv.wait(lk, [this]() { return do_exit || !sub2pub.empty(); });
-      if (do_exit) break;
-
-      for (auto sub_sock : msgq_poller->poll(100)) {
-        // Process messages for each socket
-        ZMQPubSocket *pub_sock = sub2pub.at(sub_sock);
-        for (int i = 0; i < MAX_MESSAGES_PER_SOCKET; ++i) {
-          auto msg = std::unique_ptr<Message>(sub_sock->receive(true));
-          if (!msg) break;
-
-          while (pub_sock->sendMessage(msg.get()) == -1) {
-            if (errno != EINTR) break;
-          }
-        }
-      }
+    if (generation != active_generation) {
+      updateSubscriptions();
+    }
+
+    if (subscriptions.empty()) {
+      std::unique_lock lk(idle_mutex);
+      idle_cv.wait_for(lk, std::chrono::milliseconds(100), [this]() { return do_exit || generation != active_generation; });
+      continue;
+    }
+
+    // the timeout only bounds how long it takes to pick up new subscriptions
+    auto ready = msgq_poller->poll(100);
+    const double poll_time = seconds_since_boot();
+    for (auto sub_sock : ready) {
+      forward(*sub2subscription.at(sub_sock), poll_time);
+    }
+
+    if (stats_interval_s > 0 && poll_time - last_stats_time > stats_interval_s) {
+      printStats();
+      last_stats_time = poll_time;
     }
-    util::sleep_for(1);  // Give zmqMonitorThread a chance to acquire the mutex
   }
 
   thread.join();
 }
 
+void MsgqToZmq::forward(Subscription &sub, double poll_time) {
+  Endpoint *endpoint = sub.endpoint;
+  const BridgePolicy &policy = endpoint->policy;
+
+  std::vector<std::unique_ptr<Message>> batch;
+  for (int i = 0; i < MAX_MESSAGES_PER_SOCKET; ++i) {
+    auto msg = std::unique_ptr<Message>(sub.sub_sock->receive(true));
+    if (!msg) break;
+    batch.push_back(std::move(msg));
+  }
+  if (batch.empty()) return;
+
+  size_t dropped = 0;
+  if (policy.latest_only && batch.size() > 1) {
+    dropped += batch.size() - 1;
+    batch.erase(batch.begin(), batch.end() - 1);
+  }
+  if (policy.max_rate > 0) {
+    // forward at most one message per interval, keep the newest
+    if (poll_time < sub.next_send_time) {
+      endpoint->stats.dropped += dropped + batch.size();
+      return;
+    }
+    dropped += batch.size() - 1;
+    batch.erase(batch.begin(), batch.end() - 1);
+    sub.next_send_time = std::max(sub.next_send_time + 1.0 / policy.max_rate, poll_time);
+  }
+  endpoint->stats.dropped += dropped;
+
+  // send the whole batch as one multipart message, subscribers receive one part per message
+  void *sock = endpoint->pub_sock->sock;
+  std::string compressed;
+  size_t bytes = 0;
+  for (size_t i = 0; i < batch.size(); ++i) {
+    const char *data = batch[i]->getData();
+    size_t size = batch[i]->getSize();
+    if (policy.zstd_level > 0) {
+      compressed.resize(ZSTD_compressBound(size));
+      size_t ret = ZSTD_compressCCtx(sub.zstd_ctx.get(), compressed.data(), compressed.size(), data, size, policy.zstd_level);
+      if (!ZSTD_isError(ret)) {
+        data = compressed.data();
+        size = ret;
+      }
+    }
+
+    const int flags = ZMQ_DONTWAIT | (i + 1 < batch.size() ? ZMQ_SNDMORE : 0);
+    while (zmq_send(sock, data, size, flags) == -1) {
+      if (errno != EINTR) break;
+    }
+    bytes += size;
+  }
+
+  const uint64_t latency_us = (seconds_since_boot() - poll_time) * 1e6;
+  BridgeStats &stats = endpoint->stats;
+  stats.msgs += batch.size();
+  stats.bytes += bytes;
+  stats.batches++;
+  stats.latency_sum_us += latency_us;
+  if (latency_us > stats.latency_max_us) {
+    stats.latency_max_us = latency_us;
+  }
+}
+
+void MsgqToZmq::updateSubscriptions() {
+  active_generation = generation;
+
+  for (auto &endpoint : endpoints_) {
+    const bool connected = endpoint->connected_clients > 0;
+    auto it = subscriptions.find(endpoint.get());
+    if (connected && it == subscriptions.end()) {
+      // Create new MSGQ subscriber socket on this thread, msgq signals the thread that subscribed
+      auto sub = std::make_unique<Subscription>();
+      sub->endpoint = endpoint.get();
+      sub->sub_sock = std::make_unique<MSGQSubSocket>();
+      sub->sub_sock->connect(msgq_context.get(), endpoint->name, "127.0.0.1");
+      if (endpoint->policy.zstd_level > 0) {
+        sub->zstd_ctx.reset(ZSTD_createCCtx());
+      }
+      subscriptions[endpoint.get()] = std::move(sub);
+    } else if (!connected && it != subscriptions.end()) {
+      subscriptions.erase(it);
+    }
+  }
+
+  // swap in a poller for the new set
+  auto poller = std::make_unique<MSGQPoller>();
+  sub2subscription.clear();
+  for (auto &[endpoint, sub] : subscriptions) {
+    poller->registerSocket(sub->sub_sock.get());
+    sub2subscription[sub->sub_sock.get()] = sub.get();
+  }
+  msgq_poller = std::move(poller);
+}
+
+void MsgqToZmq::printStats() {
+  for (auto &endpoint : endpoints_) {
+    BridgeStats &stats = endpoint->stats;
+    uint64_t batches = stats.batches.exchange(0);
+    if (batches == 0) continue;
+
+    printf("[%s] %lu msgs, %lu bytes, %lu dropped, %lu batches, latency avg %lu us, max %lu us\n",
+           endpoint->name.c_str(), stats.msgs.exchange(0), stats.bytes.exchange(0), stats.dropped.exchange(0),
+           batches, stats.latency_sum_us.exchange(0) / batches, stats.latency_max_us.exchange(0));
+  }
+}
+
 void MsgqToZmq::zmqMonitorThread() {
   std::vector<zmq_pollitem_t> pollitems;
 
   // Set up ZMQ monitor for each pub socket
-  for (int i = 0; i < socket_pairs.size(); ++i) {
+  for (int i = 0; i < endpoints_.size(); ++i) {
     std::string addr = "inproc://op-bridge-monitor-" + std::to_string(i);
-    zmq_socket_monitor(socket_pairs[i].pub_sock->sock, addr.c_str(), ZMQ_EVENT_ACCEPTED | ZMQ_EVENT_DISCONNECTED);
+    zmq_socket_monitor(endpoints_[i]->pub_sock->sock, addr.c_str(), ZMQ_EVENT_ACCEPTED | ZMQ_EVENT_DISCONNECTED);
 
     void *monitor_socket = zmq_socket(zmq_context->getRawContext(), ZMQ_PAIR);
     zmq_connect(monitor_socket, addr.c_str());
@@ -81,11 +195,6 @@ void MsgqToZmq::zmqMonitorThread() {
   while (!do_exit) {
     int ret = zmq_poll(pollitems.data(), pollitems.size(), 1000);
     if (ret < 0) {
-      if (errno == EINTR) {
-        // Due to frequent EINTR signals from msgq, introduce a brief delay (200 ms)
-        // to reduce CPU usage during retry attempts.
-        util::sleep_for(200);
-      }
       continue;
     }
 
@@ -101,44 +210,28 @@ void MsgqToZmq::zmqMonitorThread() {
         frame = recv_zmq_msg(pollitems[i].socket);
         if (frame.empty()) continue;
 
-        std::unique_lock lk(mutex);
-        auto &pair = socket_pairs[i];
+        auto &endpoint = endpoints_[i];
+        bool changed = false;
         if (event_type & ZMQ_EVENT_ACCEPTED) {
-          printf("socket [%s] connected\n", pair.endpoint.c_str());
-          if (++pair.connected_clients == 1) {
-            // Create new MSGQ subscriber socket and map to ZMQ publisher
-            pair.sub_sock = std::make_unique<MSGQSubSocket>();
-            pair.sub_sock->connect(msgq_context.get(), pair.endpoint, "127.0.0.1");
-            sub2pub[pair.sub_sock.get()] = pair.pub_sock.get();
-            registerSockets();
-          }
+          printf("socket [%s] connected\n", endpoint->name.c_str());
+          changed = ++endpoint->connected_clients == 1;
         } else if (event_type & ZMQ_EVENT_DISCONNECTED) {
-          printf("socket [%s] disconnected\n", pair.endpoint.c_str());
-          if (pair.connected_clients == 0 || --pair.connected_clients == 0) {
-            // Remove MSGQ subscriber socket from mapping and reset it
-            sub2pub.erase(pair.sub_sock.get());
-            pair.sub_sock.reset(nullptr);
-            registerSockets();
-          }
+          printf("socket [%s] disconnected\n", endpoint->name.c_str());
+          changed = endpoint->connected_clients == 0 || --endpoint->connected_clients == 0;
+        }
+
+        if (changed) {
+          generation++;
+          idle_cv.notify_one();
         }
-        cv.notify_one();
       }
     }
   }
 
   // Clean up monitor sockets
   for (int i = 0; i < pollitems.size(); ++i) {
-    zmq_socket_monitor(socket_pairs[i].pub_sock->sock, nullptr, 0);
+    zmq_socket_monitor(endpoints_[i]->pub_sock->sock, nullptr, 0);
     zmq_close(pollitems[i].socket);
   }
-  cv.notify_one();
-}
-
-void MsgqToZmq::registerSockets() {
-  msgq_poller = std::make_unique<MSGQPoller>();
-  for (const auto &socket_pair : socket_pairs) {
-    if (socket_pair.sub_sock) {
-      msgq_poller->registerSocket(socket_pair.sub_sock.get());
-    }
-  }
+  idle_cv.notify_one();
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <map>
 #include <memory>
@@ -7,31 +8,70 @@
 #include <string>
 #include <vector>
 
+#include <zstd.h>
+
 #define private public
 #include "msgq/impl_msgq.h"
 #include "msgq/impl_zmq.h"
 
+// zstd compressed messages start with the zstd frame magic, which a capnp segment table never does
+constexpr uint32_t ZSTD_FRAME_MAGIC = 0xFD2FB528;
+
+struct BridgePolicy {
+  float max_rate = 0;        // forwarded messages per second, 0 for unlimited
+  bool latest_only = false;  // only forward the newest of the messages queued since the last poll
+  int zstd_level = 0;        // compress each message, 0 disables. the receiving side must decompress
+};
+
+struct BridgeStats {
+  std::atomic<uint64_t> msgs = 0, bytes = 0, dropped = 0, batches = 0;
+  std::atomic<uint64_t> latency_sum_us = 0, latency_max_us = 0;  // from poll wakeup until the batch is sent
+};
+
 class MsgqToZmq {
 public:
-  MsgqToZmq() {}
+  MsgqToZmq(const std::map<std::string, BridgePolicy> &policies = {}, int stats_interval_s = 0)
+      : policies(policies), stats_interval_s(stats_interval_s) {}
   void run(const std::vector<std::string> &endpoints, const std::string &ip);
 
 protected:
-  void registerSockets();
-  void zmqMonitorThread();
-
-  struct SocketPair {
-    std::string endpoint;
+  struct Endpoint {
+    std::string name;
+    BridgePolicy policy;
     std::unique_ptr<ZMQPubSocket> pub_sock;
+    std::atomic<int> connected_clients = 0;
+    BridgeStats stats;
+  };
+
+  // owned by the forwarding thread, so msgq wakes up the thread that polls
+  struct Subscription {
+    Endpoint *endpoint;
     std::unique_ptr<MSGQSubSocket> sub_sock;
-    int connected_clients = 0;
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> zstd_ctx{nullptr, ZSTD_freeCCtx};
+    double next_send_time = 0;
   };
 
+  void zmqMonitorThread();
+  void updateSubscriptions();
+  void forward(Subscription &sub, double poll_time);
+  void printStats();
+
+  std::map<std::string, BridgePolicy> policies;
+  int stats_interval_s;
+
   std::unique_ptr<MSGQContext> msgq_context;
   std::unique_ptr<ZMQContext> zmq_context;
-  std::mutex mutex;
-  std::condition_variable cv;
+  std::vector<std::unique_ptr<Endpoint>> endpoints_;
+
+  // the monitor thread only bumps the generation, the forwarding thread swaps in a
+  // new poller and subscription set when it sees a new one. no locks on the message path
+  std::atomic<uint64_t> generation = 0;
+  uint64_t active_generation = 0;
   std::unique_ptr<MSGQPoller> msgq_poller;
-  std::map<SubSocket *, ZMQPubSocket *> sub2pub;
-  std::vector<SocketPair> socket_pairs;
+  std::map<Endpoint *, std::unique_ptr<Subscription>> subscriptions;
+  std::map<SubSocket *, Subscription *> sub2subscription;
+
+  // only used to sleep while nobody is connected
+  std::mutex idle_mutex;
+  std::condition_variable idle_cv;
 };
@@ -1,7 +1,10 @@
 #include <assert.h>
 #include <stdlib.h>
-#include <string>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 #include "cereal/services.h"
 #include "cereal/messaging/messaging.h"
@@ -36,16 +39,18 @@ struct SubMaster::SubMessage {
   float freq = 0.0f;
   bool updated = false, alive = false, valid = false, ignore_alive;
   uint64_t rcv_time = 0, rcv_frame = 0;
-  void *allocated_msg_reader = nullptr;
   bool is_polled = false;
-  capnp::FlatArrayMessageReader *msg_reader = nullptr;
-  AlignedBuffer aligned_buf;
+  // double buffered, so the event from the previous update stays readable while the next one is received
+  int cur = 0;
+  AlignedBuffer aligned_buf[2];
+  std::optional<capnp::FlatArrayMessageReader> msg_reader[2];
   cereal::Event::Reader event;
 };
 
 SubMaster::SubMaster(const std::vector<const char *> &service_list, const std::vector<const char *> &poll,
                      const char *address, const std::vector<const char *> &ignore_alive) {
   poller_ = Poller::create();
+  messages_.reserve(service_list.size());
   for (auto name : service_list) {
     assert(services.count(std::string(name)) > 0);
 
@@ -59,45 +64,62 @@ SubMaster::SubMaster(const std::vector<const char *> &service_list, const std::v
       .socket = socket,
       .freq = serv.frequency,
       .ignore_alive = inList(ignore_alive, name),
-      .allocated_msg_reader = malloc(sizeof(capnp::FlatArrayMessageReader)),
       .is_polled = is_polled};
-    m->msg_reader = new (m->allocated_msg_reader) capnp::FlatArrayMessageReader({});
-    messages_[socket] = m;
+    messages_.push_back(m);
     services_[name] = m;
   }
 }
 
-void SubMaster::update(int timeout) {
-  for (auto &kv : messages_) kv.second->updated = false;
+SubMaster::SubMessage *SubMaster::find(SubSocket *socket) const {
+  // a handful of services, a linear scan beats any lookup structure
+  for (auto m : messages_) {
+    if (m->socket == socket) return m;
+  }
+  return nullptr;
+}
 
-  auto sockets = poller_->poll(timeout);
+SubMaster::SubMessage *SubMaster::find(const char *name) const {
+  auto it = services_.find(name);
+  if (it == services_.end()) throw std::out_of_range(name);
+  return it->second;
+}
 
-  // add non-polled sockets for non-blocking receive
-  for (auto &kv : messages_) {
-    SubMessage *m = kv.second;
-    SubSocket *s = kv.first;
-    if (!m->is_polled) sockets.push_back(s);
-  }
+void SubMaster::receive(SubMessage *m, uint64_t current_time) {
+  std::unique_ptr<Message> msg(m->socket->receive(true));
+  if (!msg) return;
 
-  uint64_t current_time = nanos_since_boot();
+  // replace the older of the two buffers
+  m->cur ^= 1;
+  capnp::ReaderOptions options;
+  options.traversalLimitInWords = kj::maxValue; // Don't limit
+  auto &reader = m->msg_reader[m->cur];
+  reader.emplace(m->aligned_buf[m->cur].align(msg.get()), options);
+
+  m->event = reader->getRoot<cereal::Event>();
+  m->updated = true;
+  m->rcv_time = current_time;
+  m->rcv_frame = frame;
+  m->valid = m->event.getValid();
+  if (SIMULATION) m->alive = true;
+}
 
-  std::vector<std::pair<std::string, cereal::Event::Reader>> messages;
+void SubMaster::update(int timeout) {
+  for (auto m : messages_) m->updated = false;
 
-  for (auto s : sockets) {
-    Message *msg = s->receive(true);
-    if (msg == nullptr) continue;
+  auto sockets = poller_->poll(timeout);
 
-    SubMessage *m = messages_.at(s);
+  uint64_t current_time = nanos_since_boot();
+  if (++frame == UINT64_MAX) frame = 1;
 
-    m->msg_reader->~FlatArrayMessageReader();
-    capnp::ReaderOptions options;
-    options.traversalLimitInWords = kj::maxValue; // Don't limit
-    m->msg_reader = new (m->allocated_msg_reader) capnp::FlatArrayMessageReader(m->aligned_buf.align(msg), options);
-    delete msg;
-    messages.push_back({m->name, m->msg_reader->getRoot<cereal::Event>()});
+  for (auto s : sockets) {
+    if (SubMessage *m = find(s)) receive(m, current_time);
+  }
+  // non-polled sockets get a non-blocking receive
+  for (auto m : messages_) {
+    if (!m->is_polled) receive(m, current_time);
   }
 
-  update_msgs(current_time, messages);
+  update_alive(current_time);
 }
 
 void SubMaster::update_msgs(uint64_t current_time, const std::vector<std::pair<std::string, cereal::Event::Reader>> &messages){
@@ -117,9 +139,12 @@ void SubMaster::update_msgs(uint64_t current_time, const std::vector<std::pair<s
     if (SIMULATION) m->alive = true;
   }
 
+  update_alive(current_time);
+}
+
+void SubMaster::update_alive(uint64_t current_time) {
   if (!SIMULATION) {
-    for (auto &kv : messages_) {
-      SubMessage *m = kv.second;
+    for (auto m : messages_) {
       m->alive = (m->freq <= (1e-5) || ((current_time - m->rcv_time) * (1e-9)) < (10.0 / m->freq));
     }
   }
@@ -127,8 +152,7 @@ void SubMaster::update_msgs(uint64_t current_time, const std::vector<std::pair<s
 
 bool SubMaster::all_(const std::vector<const char *> &service_list, bool valid, bool alive) {
   int found = 0;
-  for (auto &kv : messages_) {
-    SubMessage *m = kv.second;
+  for (auto m : messages_) {
     if (service_list.size() == 0 || inList(service_list, m->name.c_str())) {
       found += (!valid || m->valid) && (!alive || (m->alive || m->ignore_alive));
     }
@@ -150,35 +174,32 @@ void SubMaster::drain() {
 }
 
 bool SubMaster::updated(const char *name) const {
-  return services_.at(name)->updated;
+  return find(name)->updated;
 }
 
 bool SubMaster::alive(const char *name) const {
-  return services_.at(name)->alive;
+  return find(name)->alive;
 }
 
 bool SubMaster::valid(const char *name) const {
-  return services_.at(name)->valid;
+  return find(name)->valid;
 }
 
 uint64_t SubMaster::rcv_frame(const char *name) const {
-  return services_.at(name)->rcv_frame;
+  return find(name)->rcv_frame;
 }
 
 uint64_t SubMaster::rcv_time(const char *name) const {
-  return services_.at(name)->rcv_time;
+  return find(name)->rcv_time;
 }
 
 cereal::Event::Reader &SubMaster::operator[](const char *name) const {
-  return services_.at(name)->event;
+  return find(name)->event;
 }
 
 SubMaster::~SubMaster() {
   delete poller_;
-  for (auto &kv : messages_) {
-    SubMessage *m = kv.second;
-    m->msg_reader->~FlatArrayMessageReader();
-    free(m->allocated_msg_reader);
+  for (auto m : messages_) {
     delete m->socket;
     delete m;
   }
@@ -0,0 +1,224 @@
+// Compares SubMaster::update against the previous string keyed implementation.
+// Every iteration publishes one message on each service and times a single update(0).
+// msgq allocates the Message and its data for every receive and the result of every poll, so
+// "msgq" does just those on the same sockets. After warmup SubMaster must not allocate beyond it,
+// the benchmark fails otherwise.
+//
+// usage: bench_submaster [--services N] [--size BYTES] [--iterations N]
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "common/tests/alloc_counter.h"
+#include "common/timing.h"
+
+// SubMaster::update as it was before services were resolved to slots
+class LegacySubMaster {
+public:
+  LegacySubMaster(const std::vector<const char *> &service_list) : context(Context::create()), poller(Poller::create()) {
+    for (auto name : service_list) {
+      SubSocket *socket = SubSocket::create(context.get(), name, "127.0.0.1", true);
+      assert(socket != nullptr);
+      poller->registerSocket(socket);
+      SubMessage *m = new SubMessage{.name = name, .socket = socket, .allocated_msg_reader = malloc(sizeof(capnp::FlatArrayMessageReader))};
+      m->msg_reader = new (m->allocated_msg_reader) capnp::FlatArrayMessageReader({});
+      messages[socket] = m;
+      services[name] = m;
+    }
+  }
+  ~LegacySubMaster() {
+    for (auto &[socket, m] : messages) {
+      m->msg_reader->~FlatArrayMessageReader();
+      free(m->allocated_msg_reader);
+      delete socket;
+      delete m;
+    }
+  }
+
+  void update(int timeout) {
+    for (auto &kv : messages) kv.second->updated = false;
+
+    std::vector<std::pair<std::string, cereal::Event::Reader>> msgs;
+    for (auto s : poller->poll(timeout)) {
+      Message *msg = s->receive(true);
+      if (msg == nullptr) continue;
+
+      SubMessage *m = messages.at(s);
+      m->msg_reader->~FlatArrayMessageReader();
+      capnp::ReaderOptions options;
+      options.traversalLimitInWords = kj::maxValue;
+      m->msg_reader = new (m->allocated_msg_reader) capnp::FlatArrayMessageReader(m->aligned_buf.align(msg), options);
+      delete msg;
+      msgs.push_back({m->name, m->msg_reader->getRoot<cereal::Event>()});
+    }
+
+    for (auto &[name, event] : msgs) {
+      auto it = services.find(name);
+      if (it == services.end()) continue;
+      it->second->event = event;
+      it->second->updated = true;
+      it->second->valid = event.getValid();
+    }
+  }
+
+  bool updated(const char *name) const { return services.at(name)->updated; }
+
+private:
+  struct SubMessage {
+    std::string name;
+    SubSocket *socket;
+    bool updated = false, valid = false;
+    void *allocated_msg_reader;
+    capnp::FlatArrayMessageReader *msg_reader;
+    AlignedBuffer aligned_buf;
+    cereal::Event::Reader event;
+  };
+  std::unique_ptr<Context> context;
+  std::unique_ptr<Poller> poller;
+  std::map<SubSocket *, SubMessage *> messages;
+  std::map<std::string, SubMessage *> services;
+};
+
+// the allocations of msgq itself: a poll and a receive per socket, nothing kept
+class MsgqReceiver {
+public:
+  MsgqReceiver(const std::vector<const char *> &service_list) : context(Context::create()), poller(Poller::create()) {
+    for (auto name : service_list) {
+      SubSocket *socket = SubSocket::create(context.get(), name, "127.0.0.1", true);
+      assert(socket != nullptr);
+      poller->registerSocket(socket);
+      sockets[name] = std::unique_ptr<SubSocket>(socket);
+    }
+    received.reserve(service_list.size());
+  }
+
+  void update(int timeout) {
+    received.clear();
+    for (auto s : poller->poll(timeout)) {
+      if (std::unique_ptr<Message> msg{s->receive(true)}) received.push_back(s);
+    }
+  }
+
+  bool updated(const char *name) const {
+    return std::find(received.begin(), received.end(), sockets.at(name).get()) != received.end();
+  }
+
+private:
+  std::unique_ptr<Context> context;
+  std::unique_ptr<Poller> poller;
+  std::map<std::string, std::unique_ptr<SubSocket>> sockets;
+  std::vector<SubSocket *> received;
+};
+
+struct Result {
+  double avg_us, p99_us;
+  uint64_t allocs;  // after warmup
+  double allocs_per_update;
+  uint64_t missed;
+};
+
+template <class SM>
+static Result run(SM &sm, PubMaster &pm, const std::vector<const char *> &service_list,
+                  const kj::ArrayPtr<capnp::byte> bytes, int iterations) {
+  // the first iterations size the receive buffers
+  const int warmup = std::min(iterations / 10, 100);
+  std::vector<double> times;
+  times.reserve(iterations);
+  uint64_t allocs = 0, missed = 0;
+  for (int i = 0; i < iterations; ++i) {
+    for (auto name : service_list) {
+      pm.send(name, bytes.begin(), bytes.size());
+    }
+
+    const uint64_t allocs_start = alloc_count;
+    const uint64_t start = nanos_since_boot();
+    sm.update(0);
+    const uint64_t end = nanos_since_boot();
+    if (i >= warmup) allocs += alloc_count - allocs_start;
+
+    for (auto name : service_list) {
+      missed += !sm.updated(name);
+    }
+    times.push_back((end - start) / 1e3);
+  }
+
+  std::sort(times.begin() + warmup, times.end());
+  double sum = 0;
+  for (auto it = times.begin() + warmup; it != times.end(); ++it) sum += *it;
+  const int n = iterations - warmup;
+  return {sum / n, times[warmup + (size_t)(0.99 * (n - 1))], allocs, (double)allocs / n, missed};
+}
+
+static void print(const char *name, const Result &r) {
+  printf("%-8s update avg %7.2f us, p99 %7.2f us, %6.2f allocations/update, %lu missed\n",
+         name, r.avg_us, r.p99_us, r.allocs_per_update, r.missed);
+}
+
+int main(int argc, char *argv[]) {
+  const std::vector<const char *> all_services = {
+    "carState", "carControl", "controlsState", "selfdriveState", "modelV2", "radarState",
+    "longitudinalPlan", "livePose", "liveCalibration", "deviceState", "liveLocationKalman",
+  };
+  int num_services = 8, size = 1024, iterations = 10000;
+
+  const option opts[] = {
+    {"services", required_argument, nullptr, 's'},
+    {"size", required_argument, nullptr, 'b'},
+    {"iterations", required_argument, nullptr, 'n'},
+    {nullptr, 0, nullptr, 0},
+  };
+  for (int opt; (opt = getopt_long(argc, argv, "", opts, nullptr)) != -1;) {
+    switch (opt) {
+      case 's': num_services = std::clamp(atoi(optarg), 1, (int)all_services.size()); break;
+      case 'b': size = std::max(atoi(optarg), 0); break;
+      case 'n': iterations = std::max(atoi(optarg), 100); break;
+      default:
+        fprintf(stderr, "usage: %s [--services N] [--size BYTES] [--iterations N]\n", argv[0]);
+        return 1;
+    }
+  }
+  const std::vector<const char *> service_list(all_services.begin(), all_services.begin() + num_services);
+
+  // the payload is a can list padded to roughly the requested size, SubMaster doesn't look at the content
+  MessageBuilder msg;
+  auto can = msg.initEvent().initCan(std::max(size / 24, 1));
+  for (auto c : can) {
+    c.setAddress(0x100);
+  }
+  auto bytes = msg.toBytes();
+
+  PubMaster pm(service_list);
+  printf("%d services, %zu bytes per message, %d iterations\n", num_services, bytes.size(), iterations);
+  Result msgq, slots;
+  {
+    MsgqReceiver sm(service_list);
+    msgq = run(sm, pm, service_list, bytes, iterations);
+    print("msgq", msgq);
+  }
+  {
+    LegacySubMaster sm(service_list);
+    print("legacy", run(sm, pm, service_list, bytes, iterations));
+  }
+  {
+    SubMaster sm(service_list);
+    slots = run(sm, pm, service_list, bytes, iterations);
+    print("slots", slots);
+  }
+
+  if (slots.missed > 0 || slots.allocs > msgq.allocs) {
+    fprintf(stderr, "FAIL: SubMaster missed %lu messages and allocated %lu times beyond msgq after warmup\n",
+            slots.missed, slots.allocs - std::min(slots.allocs, msgq.allocs));
+    return 1;
+  }
+  return 0;
+}
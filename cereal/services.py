@@ -89,6 +89,7 @@ _services: dict[str, tuple] = {
   "carStateSP": (True, 100., 10),
   "liveMapDataSP": (True, 1., 1),
   "modelDataV2SP": (True, 20.),
+  "uiProfileSP": (True, 1., 1),
   "liveLocationKalman": (True, 20.),
 
   # debug
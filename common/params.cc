@@ -1,15 +1,23 @@
 #include "common/params.h"
 
 #include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
 #include <sys/file.h>
+#ifndef __APPLE__
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <csignal>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include "common/params_keys.h"
-#include "common/queue.h"
 #include "common/swaglog.h"
 #include "common/util.h"
 #include "system/hardware/hw.h"
@@ -88,6 +96,277 @@ private:
   int fd_ = -1;
 };
 
+// Process-wide read-through cache of param values, shared by all Params instances.
+// Entries are invalidated by inotify events on the params directories. Pending events
+// are drained before every lookup, so once a put() in any process has returned, the
+// next get() never serves the old value. Falls back to plain file reads without inotify.
+class ParamsCache {
+public:
+  using Callback = std::function<void(const std::string &key)>;
+
+  static ParamsCache &instance() {
+    // leaked on purpose, the watcher thread may still run during static destruction
+    static ParamsCache *cache = new ParamsCache();
+    return *cache;
+  }
+
+  std::string get(const std::string &dir, const std::string &key) {
+    std::unique_lock lk(lock);
+    drain();
+    WatchedDir *d = watchDir(dir);
+    if (!d) {
+      lk.unlock();
+      return util::read_file(dir + "/" + key);
+    }
+
+    auto [it, inserted] = d->entries.try_emplace(key);
+    if (inserted) it->second.version = ++version_counter;
+    if (it->second.valid) return it->second.value;
+
+    // read without holding the lock, only cache the value if nothing changed meanwhile
+    const uint64_t version = it->second.version;
+    lk.unlock();
+    std::string value = util::read_file(dir + "/" + key);
+    lk.lock();
+    drain();
+    if ((d = findDir(dir))) {
+      if (auto e = d->entries.find(key); e != d->entries.end() && e->second.version == version) {
+        e->second.value = value;
+        e->second.valid = true;
+      }
+    }
+    return value;
+  }
+
+  uint64_t changeCount() {
+    std::lock_guard lk(lock);
+    return changes;
+  }
+
+  // wait until any params directory changed after change count seen, or until timeout
+  void waitForChange(uint64_t seen, int timeout_ms) {
+    std::unique_lock lk(lock);
+    if (fd < 0) {
+      lk.unlock();
+      util::sleep_for(timeout_ms);
+      return;
+    }
+    startThread();
+    drain();
+    cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [&] { return changes != seen; });
+  }
+
+  int addWatch(const std::string &dir, const std::string &key, Callback callback) {
+    std::lock_guard lk(lock);
+    if (!watchDir(dir)) return -1;
+    startThread();
+    watches[++watch_id] = {dir, key, std::move(callback)};
+    return watch_id;
+  }
+
+  // once this returns the callback doesn't run anymore, unless called from the callback itself
+  void removeWatch(int id) {
+    std::unique_lock lk(lock);
+    watches.erase(id);
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [id](auto &p) { return p.first == id; }), pending.end());
+    if (std::this_thread::get_id() != watcher_thread_id) {
+      cv.wait(lk, [&] { return running_watch != id; });
+    }
+  }
+
+private:
+  struct Entry {
+    std::string value;
+    bool valid = false;
+    uint64_t version = 0;
+  };
+  struct WatchedDir {
+    std::string path;
+    std::unordered_map<std::string, Entry> entries;
+  };
+  struct Watch {
+    std::string dir;
+    std::string key;
+    Callback callback;
+  };
+
+  ParamsCache() {
+    init();
+    pthread_atfork([] { instance().lock.lock(); },
+                   [] { instance().lock.unlock(); },
+                   [] { instance().resetAfterFork(); });
+  }
+
+  void init() {
+#ifndef __APPLE__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0 || wake_fd < 0) {
+      LOGE("params cache disabled, inotify unavailable, errno=%d", errno);
+      if (fd >= 0) close(fd);
+      fd = -1;
+    }
+#endif
+  }
+
+  // the child has a copy of the inotify fd that would steal the parent's events
+  void resetAfterFork() {
+    if (fd >= 0) close(fd);
+    if (wake_fd >= 0) close(wake_fd);
+    fd = wake_fd = -1;
+    dirs.clear();
+    wds.clear();
+    watches.clear();
+    pending.clear();
+    thread_running = false;
+    watcher_thread_id = {};
+    running_watch = 0;
+    init();
+    lock.unlock();
+  }
+
+  WatchedDir *findDir(const std::string &path) {
+    auto it = wds.find(path);
+    return it != wds.end() ? &dirs[it->second] : nullptr;
+  }
+
+  WatchedDir *watchDir(const std::string &path) {
+    if (fd < 0) return nullptr;
+    if (WatchedDir *d = findDir(path)) return d;
+
+#ifndef __APPLE__
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO |
+                          IN_DELETE_SELF | IN_MOVE_SELF;
+    int wd = inotify_add_watch(fd, path.c_str(), mask);
+    if (wd < 0) {
+      LOGE("failed to watch params directory %s, errno=%d", path.c_str(), errno);
+      return nullptr;
+    }
+    wds[path] = wd;
+    WatchedDir &d = dirs[wd];
+    if (d.path.empty()) d.path = path;
+    return &d;
+#else
+    return nullptr;
+#endif
+  }
+
+  void invalidate(int wd, WatchedDir &d, const char *key) {
+    for (auto &[name, e] : d.entries) {
+      if (!key || name == key) {
+        e.valid = false;
+        e.value.clear();
+        e.version = ++version_counter;
+      }
+    }
+    for (auto &[id, w] : watches) {
+      auto it = wds.find(w.dir);
+      if (it != wds.end() && it->second == wd && (!key || w.key == key)) {
+        pending.push_back({id, w.key});
+      }
+    }
+  }
+
+  void drain() {
+#ifndef __APPLE__
+    if (fd < 0) return;
+
+    alignas(inotify_event) char buf[4096];
+    size_t prev_pending = pending.size();
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+      for (char *p = buf; p < buf + len; p += sizeof(inotify_event) + ((inotify_event *)p)->len) {
+        const inotify_event *ev = (const inotify_event *)p;
+        changes++;
+        if (ev->mask & IN_Q_OVERFLOW) {
+          // events were lost, nothing cached can be trusted
+          for (auto &[wd, d] : dirs) invalidate(wd, d, nullptr);
+          continue;
+        }
+
+        auto it = dirs.find(ev->wd);
+        if (it == dirs.end()) continue;
+        invalidate(it->first, it->second, (ev->len > 0 && !(ev->mask & IN_ISDIR)) ? ev->name : nullptr);
+
+        if (ev->mask & IN_IGNORED) {
+          // directory was removed, it's watched again on the next access
+          for (auto w = wds.begin(); w != wds.end();) {
+            w = w->second == ev->wd ? wds.erase(w) : std::next(w);
+          }
+          dirs.erase(it);
+        }
+      }
+      cv.notify_all();
+    }
+
+    if (pending.size() != prev_pending) {
+      uint64_t one = 1;
+      (void)!write(wake_fd, &one, sizeof(one));
+    }
+#endif
+  }
+
+  void startThread() {
+    if (thread_running) return;
+    thread_running = true;
+    std::thread t(&ParamsCache::watcherThread, this);
+    watcher_thread_id = t.get_id();
+    t.detach();
+  }
+
+  void watcherThread() {
+    util::set_thread_name("params_watcher");
+    const int inotify_fd = fd, event_fd = wake_fd;
+    while (true) {
+      pollfd fds[] = {{.fd = inotify_fd, .events = POLLIN}, {.fd = event_fd, .events = POLLIN}};
+      if (poll(fds, std::size(fds), -1) < 0 && errno != EINTR) break;
+      if (fds[1].revents & POLLIN) {
+        uint64_t cnt;
+        (void)!read(event_fd, &cnt, sizeof(cnt));
+      }
+
+      std::vector<std::pair<int, std::string>> callbacks;
+      {
+        std::lock_guard lk(lock);
+        drain();
+        callbacks.swap(pending);
+      }
+      for (auto &[id, key] : callbacks) {
+        // the watch may have been removed since the change was queued
+        Callback callback;
+        {
+          std::lock_guard lk(lock);
+          auto w = watches.find(id);
+          if (w == watches.end()) continue;
+          callback = w->second.callback;
+          running_watch = id;
+        }
+        callback(key);
+        {
+          std::lock_guard lk(lock);
+          running_watch = 0;
+        }
+        cv.notify_all();
+      }
+    }
+  }
+
+  int fd = -1;
+  int wake_fd = -1;
+  std::mutex lock;
+  std::condition_variable cv;
+  uint64_t changes = 0;
+  uint64_t version_counter = 0;
+  std::unordered_map<int, WatchedDir> dirs;  // by inotify watch descriptor
+  std::unordered_map<std::string, int> wds;  // watch descriptors by path
+  std::map<int, Watch> watches;
+  int watch_id = 0;
+  std::vector<std::pair<int, std::string>> pending;  // watch id and key
+  bool thread_running = false;
+  std::thread::id watcher_thread_id;
+  int running_watch = 0;
+};
+
 } // namespace
 
 
@@ -97,10 +376,15 @@ Params::Params(const std::string &path) {
 }
 
 Params::~Params() {
-  if (future.valid()) {
-    future.wait();
+  if (writer.joinable()) {
+    {
+      std::lock_guard lk(writer_lock);
+      writer_exit = true;
+    }
+    writer_cv.notify_all();
+    writer.join();
   }
-  assert(queue.empty());
+  assert(pending_writes.empty());
 }
 
 std::vector<std::string> Params::allKeys(ParamKeyFlag flag) const {
@@ -130,40 +414,57 @@ std::optional<std::string> Params::getKeyDefaultValue(const std::string &key) {
 }
 
 int Params::put(const char* key, const char* value, size_t value_size) {
+  return writeBatch({{key, std::string(value, value_size)}});
+}
+
+int Params::writeBatch(const std::map<std::string, std::string> &values) {
   // Information about safely and atomically writing a file: https://lwn.net/Articles/457667/
-  // 1) Create temp file
-  // 2) Write data to temp file
-  // 3) fsync() the temp file
-  // 4) rename the temp file to the real name
-  // 5) fsync() the containing directory
-  std::string tmp_path = params_path + "/.tmp_value_XXXXXX";
-  int tmp_fd = mkstemp((char*)tmp_path.c_str());
-  if (tmp_fd < 0) return -1;
+  // 1) Create temp files
+  // 2) Write data to temp files
+  // 3) fsync() the temp files
+  // 4) rename the temp files to the real names
+  // 5) fsync() the containing directory once for all of them
+  std::vector<std::pair<std::string, std::string>> tmp_paths;  // (tmp path, key)
+  int result = 0;
+  for (const auto &[key, value] : values) {
+    std::string tmp_path = params_path + "/.tmp_value_XXXXXX";
+    int tmp_fd = mkstemp((char*)tmp_path.c_str());
+    if (tmp_fd < 0) {
+      result = -1;
+      break;
+    }
+    tmp_paths.push_back({tmp_path, key});
 
-  int result = -1;
-  do {
     // Write value to temp.
-    ssize_t bytes_written = HANDLE_EINTR(write(tmp_fd, value, value_size));
-    if (bytes_written < 0 || (size_t)bytes_written != value_size) {
+    ssize_t bytes_written = HANDLE_EINTR(write(tmp_fd, value.data(), value.size()));
+    if (bytes_written < 0 || (size_t)bytes_written != value.size()) {
       result = -20;
-      break;
+    } else {
+      // fsync to force persist the changes.
+      result = HANDLE_EINTR(fsync(tmp_fd));
     }
+    close(tmp_fd);
+    if (result < 0) break;
+  }
 
-    // fsync to force persist the changes.
-    if ((result = HANDLE_EINTR(fsync(tmp_fd))) < 0) break;
-
+  if (result == 0) {
     FileLock file_lock(params_path + "/.lock");
 
-    // Move temp into place.
-    if ((result = rename(tmp_path.c_str(), getParamPath(key).c_str())) < 0) break;
+    // Move temps into place.
+    for (const auto &[tmp_path, key] : tmp_paths) {
+      if ((result = rename(tmp_path.c_str(), getParamPath(key).c_str())) < 0) break;
+    }
 
     // fsync parent directory
-    result = fsync_dir(getParamPath());
-  } while (false);
+    if (result == 0) {
+      result = fsync_dir(getParamPath());
+    }
+  }
 
-  close(tmp_fd);
   if (result != 0) {
-    ::unlink(tmp_path.c_str());
+    for (const auto &p : tmp_paths) {
+      ::unlink(p.first.c_str());
+    }
   }
   return result;
 }
@@ -178,8 +479,9 @@ int Params::remove(const std::string &key) {
 }
 
 std::string Params::get(const std::string &key, bool block) {
+  ParamsCache &cache = ParamsCache::instance();
   if (!block) {
-    return util::read_file(getParamPath(key));
+    return cache.get(getParamPath(), key);
   } else {
     // blocking read until successful
     params_do_exit = 0;
@@ -188,10 +490,12 @@ std::string Params::get(const std::string &key, bool block) {
 
     std::string value;
     while (!params_do_exit) {
-      if (value = util::read_file(getParamPath(key)); !value.empty()) {
+      uint64_t changes = cache.changeCount();
+      if (value = cache.get(getParamPath(), key); !value.empty()) {
         break;
       }
-      util::sleep_for(100);  // 0.1 s
+      // wakes up on the next change, the timeout is for checking params_do_exit
+      cache.waitForChange(changes, 100);
     }
 
     std::signal(SIGINT, prev_handler_sigint);
@@ -200,6 +504,14 @@ std::string Params::get(const std::string &key, bool block) {
   }
 }
 
+int Params::addWatch(const std::string &key, std::function<void(const std::string &)> callback) {
+  return ParamsCache::instance().addWatch(getParamPath(), key, std::move(callback));
+}
+
+void Params::removeWatch(int id) {
+  ParamsCache::instance().removeWatch(id);
+}
+
 std::map<std::string, std::string> Params::readAll() {
   FileLock file_lock(params_path + "/.lock");
   return util::read_files_in_dir(getParamPath());
@@ -227,18 +539,55 @@ void Params::clearAll(ParamKeyFlag key_flag) {
 }
 
 void Params::putNonBlocking(const std::string &key, const std::string &val) {
-   queue.push(std::make_pair(key, val));
-  // start thread on demand
-  if (!future.valid() || future.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
-    future = std::async(std::launch::async, &Params::asyncWriteThread, this);
+  {
+    std::lock_guard lk(writer_lock);
+    if (pending_writes.insert_or_assign(key, val).second == false) {
+      writer_stats.coalesced++;
+    }
+    writer_stats.queued++;
+    queued_seq++;
+    // start thread on demand, it stays around for the lifetime of this instance
+    if (!writer.joinable()) {
+      writer = std::thread(&Params::asyncWriteThread, this);
+    }
   }
+  writer_cv.notify_all();
+}
+
+void Params::flush() {
+  std::unique_lock lk(writer_lock);
+  const uint64_t seq = queued_seq;
+  writer_cv.wait(lk, [&] { return written_seq >= seq; });
+}
+
+ParamsWriterStats Params::writerStats() {
+  std::lock_guard lk(writer_lock);
+  return writer_stats;
 }
 
 void Params::asyncWriteThread() {
-  // TODO: write the latest one if a key has multiple values in the queue.
-  std::pair<std::string, std::string> p;
-  while (queue.try_pop(p, 0)) {
-    // Params::put is Thread-Safe
-    put(p.first, p.second);
+  util::set_thread_name("params_writer");
+  std::unique_lock lk(writer_lock);
+  while (true) {
+    writer_cv.wait(lk, [&] { return writer_exit || !pending_writes.empty(); });
+    if (pending_writes.empty()) break;
+
+    // everything queued while the previous batch was written goes out with one directory fsync
+    std::map<std::string, std::string> batch;
+    batch.swap(pending_writes);
+    const uint64_t seq = queued_seq;
+    lk.unlock();
+    int result = writeBatch(batch);
+    lk.lock();
+
+    if (result != 0) {
+      LOGE("failed to write %zu params, result=%d", batch.size(), result);
+      writer_stats.errors++;
+    } else {
+      writer_stats.written += batch.size();
+    }
+    writer_stats.batches++;
+    written_seq = seq;
+    writer_cv.notify_all();
   }
 }
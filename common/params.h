@@ -1,15 +1,16 @@
 #pragma once
 
-#include <future>
+#include <condition_variable>
+#include <functional>
 #include <map>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
 
-#include "common/queue.h"
-
 enum ParamKeyFlag {
   PERSISTENT = 0x02,
   CLEAR_ON_MANAGER_START = 0x04,
@@ -32,6 +33,14 @@ enum ParamKeyType {
   BYTES = 6
 };
 
+struct ParamsWriterStats {
+  uint64_t queued = 0;     // putNonBlocking calls
+  uint64_t coalesced = 0;  // values replaced by a newer one before they were written
+  uint64_t written = 0;
+  uint64_t batches = 0;    // one directory fsync each
+  uint64_t errors = 0;
+};
+
 struct ParamKeyAttributes {
   uint32_t flags;
   ParamKeyType type;
@@ -66,6 +75,11 @@ public:
   }
   std::map<std::string, std::string> readAll();
 
+  // callback runs on a background thread whenever key changes in any process.
+  // returns an id for removeWatch(), or -1 if change notifications are unavailable
+  int addWatch(const std::string &key, std::function<void(const std::string &key)> callback);
+  void removeWatch(int id);
+
   // helpers for writing values
   int put(const char *key, const char *val, size_t value_size);
   inline int put(const std::string &key, const std::string &val) {
@@ -78,14 +92,23 @@ public:
   inline void putBoolNonBlocking(const std::string &key, bool val) {
     putNonBlocking(key, val ? "1" : "0");
   }
+  // block until every putNonBlocking issued before is on disk
+  void flush();
+  ParamsWriterStats writerStats();
 
 private:
+  int writeBatch(const std::map<std::string, std::string> &values);
   void asyncWriteThread();
 
   std::string params_path;
   std::string params_prefix;
 
-  // for nonblocking write
-  std::future<void> future;
-  SafeQueue<std::pair<std::string, std::string>> queue;
+  // for nonblocking write. only the latest value per key is kept
+  std::thread writer;
+  std::mutex writer_lock;
+  std::condition_variable writer_cv;
+  std::map<std::string, std::string> pending_writes;
+  uint64_t queued_seq = 0, written_seq = 0;
+  bool writer_exit = false;
+  ParamsWriterStats writer_stats;
 };
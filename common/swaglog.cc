@@ -4,17 +4,82 @@
 
 #include "common/swaglog.h"
 
+#include <pthread.h>
+
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <zmq.h>
 #include <stdarg.h>
 #include "third_party/json11/json11.hpp"
+#include "common/util.h"
 #include "common/version.h"
 #include "system/hardware/hw.h"
 
+static int get_level(const char *env, int default_level) {
+  if (const char* lvl = getenv(env)) {
+    if (strcmp(lvl, "debug") == 0) {
+      return CLOUDLOG_DEBUG;
+    } else if (strcmp(lvl, "info") == 0) {
+      return CLOUDLOG_INFO;
+    } else if (strcmp(lvl, "warning") == 0) {
+      return CLOUDLOG_WARNING;
+    } else if (strcmp(lvl, "error") == 0) {
+      return CLOUDLOG_ERROR;
+    }
+  }
+  return default_level;
+}
+
+int cloudlog_level = get_level("SWAGLOG_LEVEL", CLOUDLOG_DEBUG);
+
+// Binary record as written by the logging thread. The JSON is only rendered by the swaglog thread.
+struct LogRecord {
+  static constexpr size_t DATA_SIZE = 192;
+
+  int levelnum;
+  int lineno;
+  const char* filename;
+  const char* func;
+  double created;
+  const char* fmt;                // nullptr if data is the formatted message
+  cloudlog_formatter formatter;
+  uint32_t size;
+  char data[DATA_SIZE];
+};
+
+// Single producer, single consumer. Owned by the state, so records outlive the thread that wrote them.
+struct LogRing {
+  static constexpr uint32_t SIZE = 128;
+
+  LogRecord *reserve() {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == SIZE) {
+      dropped++;
+      return nullptr;
+    }
+    return &records[h % SIZE];
+  }
+  void commit() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+  uint32_t pending() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+  }
+
+  std::atomic<uint32_t> head = 0, tail = 0;
+  std::atomic<uint32_t> dropped = 0;
+  std::atomic<bool> in_use = false;
+  LogRecord records[SIZE];
+};
+
 class SwaglogState {
 public:
   SwaglogState() {
@@ -29,16 +94,7 @@ public:
     // workaround for https://github.com/dropbox/json11/issues/38
     setlocale(LC_NUMERIC, "C");
 
-    print_level = CLOUDLOG_WARNING;
-    if (const char* print_lvl = getenv("LOGPRINT")) {
-      if (strcmp(print_lvl, "debug") == 0) {
-        print_level = CLOUDLOG_DEBUG;
-      } else if (strcmp(print_lvl, "info") == 0) {
-        print_level = CLOUDLOG_INFO;
-      } else if (strcmp(print_lvl, "warning") == 0) {
-        print_level = CLOUDLOG_WARNING;
-      }
-    }
+    print_level = get_level("LOGPRINT", CLOUDLOG_WARNING);
 
     ctx_j = json11::Json::object{};
     if (char* dongle_id = getenv("DONGLE_ID")) {
@@ -59,9 +115,23 @@ public:
     ctx_j["version"] = COMMA_VERSION;
     ctx_j["dirty"] = !getenv("CLEAN");
     ctx_j["device"] = Hardware::get_name();
+
+    consumer = std::thread(&SwaglogState::consumerThread, this);
+    // the consumer doesn't exist in a forked child, it logs synchronously
+    pthread_atfork(nullptr, nullptr, []() { forked = true; });
   }
 
   ~SwaglogState() {
+    if (forked) {
+      consumer.detach();
+    } else {
+      {
+        std::lock_guard lk(consumer_lock);
+        consumer_exit = true;
+      }
+      consumer_cv.notify_one();
+      consumer.join();
+    }
     zmq_close(sock);
     zmq_ctx_destroy(zctx);
   }
@@ -74,30 +144,96 @@ public:
     zmq_send(sock, log_s.data(), log_s.length(), ZMQ_NOBLOCK);
   }
 
+  // record goes to the ring when nothing needs to see it before the call returns
+  bool deferrable(int levelnum) const {
+    return levelnum < CLOUDLOG_WARNING && levelnum < print_level && !forked;
+  }
+
+  LogRing *ring() {
+    thread_local struct RingHandle {
+      LogRing *ring = nullptr;
+      ~RingHandle() {
+        if (ring) ring->in_use.store(false, std::memory_order_release);
+      }
+    } handle;
+
+    if (!handle.ring) {
+      std::lock_guard lk(rings_lock);
+      for (auto &r : rings) {
+        if (!r->in_use.load(std::memory_order_acquire)) {
+          handle.ring = r.get();
+          break;
+        }
+      }
+      if (!handle.ring) {
+        handle.ring = rings.emplace_back(std::make_unique<LogRing>()).get();
+      }
+      handle.ring->in_use = true;
+    }
+    return handle.ring;
+  }
+
+  void wake(const LogRing *r) {
+    // the consumer polls anyway, only wake it up early when a ring fills up
+    if (r->pending() == LogRing::SIZE / 2) {
+      consumer_cv.notify_one();
+    }
+  }
+
+  void pause_drain(bool paused) {
+    drain_paused = paused;
+    if (paused) {
+      // wait out a drain that's already running
+      std::lock_guard lk(drain_lock);
+    } else {
+      consumer_cv.notify_one();
+    }
+  }
+
   std::mutex lock;
   void* zctx = nullptr;
   void* sock = nullptr;
   int print_level;
   json11::Json::object ctx_j;
+
+  static inline std::atomic<bool> forked = false;
+
+private:
+  void consumerThread();
+  void drain();
+
+  std::mutex rings_lock;
+  std::vector<std::unique_ptr<LogRing>> rings;
+
+  std::mutex drain_lock;
+  std::atomic<bool> drain_paused = false;
+
+  std::mutex consumer_lock;
+  std::condition_variable consumer_cv;
+  bool consumer_exit = false;
+  std::thread consumer;
 };
 
 bool LOG_TIMESTAMPS = getenv("LOG_TIMESTAMPS");
 uint32_t NO_FRAME_ID = std::numeric_limits<uint32_t>::max();
 
-static void cloudlog_common(int levelnum, const char* filename, int lineno, const char* func,
-                            char* msg_buf, const json11::Json::object &msg_j={}) {
+static SwaglogState &swaglog_state() {
   static SwaglogState s;
+  return s;
+}
 
+static std::string render(const SwaglogState &s, int levelnum, const char* filename, int lineno, const char* func,
+                          double created, const char* msg, const json11::Json::object &msg_j={}) {
   json11::Json::object log_j = json11::Json::object {
     {"ctx", s.ctx_j},
     {"levelnum", levelnum},
     {"filename", filename},
     {"lineno", lineno},
     {"funcname", func},
-    {"created", seconds_since_epoch()}
+    {"created", created}
   };
   if (msg_j.empty()) {
-    log_j["msg"] = msg_buf;
+    log_j["msg"] = msg;
   } else {
     log_j["msg"] = msg_j;
   }
@@ -105,11 +241,66 @@ static void cloudlog_common(int levelnum, const char* filename, int lineno, cons
   std::string log_s;
   log_s += (char)levelnum;
   ((json11::Json)log_j).dump(log_s);
-  s.log(levelnum, filename, lineno, func, msg_buf, log_s);
+  return log_s;
+}
 
+static void cloudlog_common(int levelnum, const char* filename, int lineno, const char* func,
+                            char* msg_buf, const json11::Json::object &msg_j={}) {
+  SwaglogState &s = swaglog_state();
+  s.log(levelnum, filename, lineno, func, msg_buf, render(s, levelnum, filename, lineno, func, seconds_since_epoch(), msg_buf, msg_j));
   free(msg_buf);
 }
 
+void SwaglogState::drain() {
+  std::lock_guard drain_lk(drain_lock);
+  std::vector<LogRing *> snapshot;
+  {
+    std::lock_guard lk(rings_lock);
+    for (auto &r : rings) snapshot.push_back(r.get());
+  }
+
+  char msg[4096];
+  for (auto r : snapshot) {
+    for (uint32_t n = r->pending(); n > 0; --n) {
+      const uint32_t t = r->tail.load(std::memory_order_relaxed);
+      const LogRecord &rec = r->records[t % LogRing::SIZE];
+      const char *m = rec.data;
+      if (rec.fmt) {
+        rec.formatter(msg, sizeof(msg), rec.fmt, (const unsigned char *)rec.data);
+        m = msg;
+      }
+      log(rec.levelnum, rec.filename, rec.lineno, rec.func, m, render(*this, rec.levelnum, rec.filename, rec.lineno, rec.func, rec.created, m));
+      r->tail.store(t + 1, std::memory_order_release);
+    }
+
+    if (uint32_t dropped = r->dropped.exchange(0)) {
+      char *msg_buf = nullptr;
+      if (asprintf(&msg_buf, "swaglog: %u messages dropped", dropped) > 0) {
+        log(CLOUDLOG_WARNING, __FILE__, __LINE__, __func__, msg_buf, render(*this, CLOUDLOG_WARNING, __FILE__, __LINE__, __func__, seconds_since_epoch(), msg_buf));
+        free(msg_buf);
+      }
+    }
+  }
+}
+
+void SwaglogState::consumerThread() {
+  util::set_thread_name("swaglog");
+  std::unique_lock lk(consumer_lock);
+  while (!consumer_exit) {
+    consumer_cv.wait_for(lk, std::chrono::milliseconds(20));
+    if (drain_paused) continue;
+    lk.unlock();
+    drain();
+    lk.lock();
+  }
+  lk.unlock();
+  drain();
+}
+
+void cloudlog_pause_drain(bool paused) {
+  swaglog_state().pause_drain(paused);
+}
+
 void cloudlog_e(int levelnum, const char* filename, int lineno, const char* func,
                 const char* fmt, ...) {
   va_list args;
@@ -121,6 +312,74 @@ void cloudlog_e(int levelnum, const char* filename, int lineno, const char* func
   cloudlog_common(levelnum, filename, lineno, func, msg_buf);
 }
 
+void cloudlog_fast(int levelnum, const char* filename, int lineno, const char* func,
+                   const char* fmt, ...) {
+  SwaglogState &s = swaglog_state();
+  va_list args;
+  va_start(args, fmt);
+  if (s.deferrable(levelnum)) {
+    LogRing *r = s.ring();
+    LogRecord *rec = r->reserve();
+    if (!rec) {
+      // ring is full, counted as dropped
+      va_end(args);
+      return;
+    }
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int ret = vsnprintf(rec->data, sizeof(rec->data), fmt, args_copy);
+    va_end(args_copy);
+    if (ret >= 0 && ret < (int)sizeof(rec->data)) {
+      rec->levelnum = levelnum;
+      rec->lineno = lineno;
+      rec->filename = filename;
+      rec->func = func;
+      rec->created = seconds_since_epoch();
+      rec->fmt = nullptr;
+      rec->formatter = nullptr;
+      rec->size = ret;
+      r->commit();
+      s.wake(r);
+      va_end(args);
+      return;
+    }
+    // too long for a record, log it synchronously
+  }
+
+  char* msg_buf = nullptr;
+  int ret = vasprintf(&msg_buf, fmt, args);
+  va_end(args);
+  if (ret <= 0 || !msg_buf) return;
+  cloudlog_common(levelnum, filename, lineno, func, msg_buf);
+}
+
+void cloudlog_enqueue(int levelnum, const char* filename, int lineno, const char* func,
+                      const char* fmt, cloudlog_formatter formatter, const unsigned char* args, size_t args_size) {
+  SwaglogState &s = swaglog_state();
+  if (s.deferrable(levelnum) && args_size <= LogRecord::DATA_SIZE) {
+    LogRing *r = s.ring();
+    if (LogRecord *rec = r->reserve()) {
+      rec->levelnum = levelnum;
+      rec->lineno = lineno;
+      rec->filename = filename;
+      rec->func = func;
+      rec->created = seconds_since_epoch();
+      rec->fmt = fmt;
+      rec->formatter = formatter;
+      rec->size = args_size;
+      memcpy(rec->data, args, args_size);
+      r->commit();
+      s.wake(r);
+    }
+    return;
+  }
+
+  char msg[4096];
+  if (formatter(msg, sizeof(msg), fmt, args) <= 0) return;
+  cloudlog_common(levelnum, filename, lineno, func, strdup(msg));
+}
+
 void cloudlog_t_common(int levelnum, const char* filename, int lineno, const char* func,
                        uint32_t frame_id, const char* fmt, va_list args) {
   if (!LOG_TIMESTAMPS) return;
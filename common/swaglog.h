@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
 #include "common/timing.h"
 
 #define CLOUDLOG_DEBUG 10
@@ -8,6 +13,13 @@
 #define CLOUDLOG_ERROR 40
 #define CLOUDLOG_CRITICAL 50
 
+// statements below this level are compiled out
+#ifndef SWAGLOG_MIN_LEVEL
+#define SWAGLOG_MIN_LEVEL CLOUDLOG_DEBUG
+#endif
+
+// runtime level, set with SWAGLOG_LEVEL=debug|info|warning|error
+extern int cloudlog_level;
 
 #ifdef __GNUC__
 #define SWAG_LOG_CHECK_FMT(a, b) __attribute__ ((format (printf, a, b)))
@@ -24,10 +36,61 @@ void cloudlog_te(int levelnum, const char* filename, int lineno, const char* fun
 void cloudlog_te(int levelnum, const char* filename, int lineno, const char* func,
                  uint32_t frame_id, const char* fmt, ...) SWAG_LOG_CHECK_FMT(6, 7);
 
+// Like cloudlog_e, but debug and info records are handed to a per-thread ring and
+// serialized by the swaglog thread. filename and func must outlive the call (__FILE__, __func__).
+void cloudlog_fast(int levelnum, const char* filename, int lineno, const char* func,
+                   const char* fmt, ...) SWAG_LOG_CHECK_FMT(5, 6);
+
+// Holds the swaglog thread off the rings, records queue up (and overflow) until it's resumed. For tests.
+void cloudlog_pause_drain(bool paused);
+
+typedef int (*cloudlog_formatter)(char* buf, size_t size, const char* fmt, const unsigned char* args);
+void cloudlog_enqueue(int levelnum, const char* filename, int lineno, const char* func,
+                      const char* fmt, cloudlog_formatter formatter, const unsigned char* args, size_t args_size);
+
+template <class T>
+inline T cloudlog_unpack(const unsigned char* args, size_t &offset) {
+  T v;
+  memcpy(&v, args + offset, sizeof(T));
+  offset += sizeof(T);
+  return v;
+}
+
+template <class... Args>
+int cloudlog_format_args(char* buf, size_t size, const char* fmt, const unsigned char* args) {
+  size_t offset = 0;
+  // braced init evaluates left to right
+  std::tuple<Args...> values{cloudlog_unpack<Args>(args, offset)...};
+  return std::apply([&](auto... v) { return snprintf(buf, size, fmt, v...); }, values);
+}
+
+// Copies the arguments and leaves the formatting to the swaglog thread.
+// Only numbers can be deferred, a string may be gone by the time it's formatted.
+template <class... Args>
+void cloudlog_deferred(int levelnum, const char* filename, int lineno, const char* func,
+                       const char* fmt, Args... args) {
+  static_assert((std::is_arithmetic_v<Args> && ...), "deferred log arguments must be numbers");
+  unsigned char data[(sizeof(Args) + ... + 1)];
+  size_t offset = 0;
+  ((memcpy(data + offset, &args, sizeof(Args)), offset += sizeof(Args)), ...);
+  cloudlog_enqueue(levelnum, filename, lineno, func, fmt, &cloudlog_format_args<Args...>, data, offset);
+}
 
-#define cloudlog(lvl, fmt, ...) cloudlog_e(lvl, __FILE__, __LINE__, \
-                                           __func__, \
-                                           fmt, ## __VA_ARGS__)
+
+#define cloudlog(lvl, fmt, ...)                                                      \
+  do {                                                                               \
+    if ((lvl) >= SWAGLOG_MIN_LEVEL && (lvl) >= cloudlog_level) {                     \
+      cloudlog_fast(lvl, __FILE__, __LINE__, __func__, fmt, ## __VA_ARGS__);         \
+    }                                                                                \
+  } while (0)
+
+#define cloudlog_d(lvl, fmt, ...)                                                    \
+  do {                                                                               \
+    if ((lvl) >= SWAGLOG_MIN_LEVEL && (lvl) >= cloudlog_level) {                     \
+      if (0) printf(fmt, ## __VA_ARGS__);  /* format check only */                    \
+      cloudlog_deferred(lvl, __FILE__, __LINE__, __func__, fmt, ## __VA_ARGS__);     \
+    }                                                                                \
+  } while (0)
 
 #define cloudlog_t(lvl, ...) cloudlog_te(lvl, __FILE__, __LINE__, \
                                           __func__, \
@@ -70,6 +133,10 @@ void cloudlog_te(int levelnum, const char* filename, int lineno, const char* fun
 #define LOGW(fmt, ...) cloudlog(CLOUDLOG_WARNING, fmt, ## __VA_ARGS__)
 #define LOGE(fmt, ...) cloudlog(CLOUDLOG_ERROR, fmt, ## __VA_ARGS__)
 
+// deferred formatting, for numbers logged from hot loops
+#define LOGD_DEFER(fmt, ...) cloudlog_d(CLOUDLOG_DEBUG, fmt, ## __VA_ARGS__)
+#define LOG_DEFER(fmt, ...) cloudlog_d(CLOUDLOG_INFO, fmt, ## __VA_ARGS__)
+
 #define LOGD_100(fmt, ...) cloudlog_rl(2, 100, CLOUDLOG_DEBUG, fmt, ## __VA_ARGS__)
 #define LOG_100(fmt, ...) cloudlog_rl(2, 100, CLOUDLOG_INFO, fmt, ## __VA_ARGS__)
 #define LOGW_100(fmt, ...) cloudlog_rl(2, 100, CLOUDLOG_WARNING, fmt, ## __VA_ARGS__)
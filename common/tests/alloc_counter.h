@@ -0,0 +1,19 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations by replacing the global operator new, for the tests and benchmarks that
+// check a path doesn't allocate. A program can only have one replacement, so include this from
+// exactly one of its files.
+inline std::atomic<uint64_t> alloc_count = 0;
+
+void *operator new(size_t size) {
+  alloc_count++;
+  if (void *p = malloc(size)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
@@ -0,0 +1,113 @@
+// Times single LOGD and LOGD_DEFER calls from threads running 100 Hz loops, like the ones that log
+// from pandad and loggerd, against the synchronous path they used before. Every cycle starts after
+// a 10 ms sleep, so the calls run on cold caches. Exits with 1 when the median LOGD_DEFER call takes a
+// microsecond or more. LOGD still formats on the calling thread and is only reported.
+//
+// usage: bench_swaglog [--threads N] [--seconds S]
+
+#include <getopt.h>
+#include <zmq.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "common/swaglog.h"
+#include "common/timing.h"
+#include "common/util.h"
+#include "system/hardware/hw.h"
+
+struct Timings {
+  std::vector<uint64_t> fast, deferred, sync;
+};
+
+static void log_loop(int thread_id, int cycles, Timings *t) {
+  for (int i = 0; i < cycles; ++i) {
+    const double rate = i * 1.5;
+
+    uint64_t start = nanos_since_boot();
+    LOGD("thread %d cycle %d, %.2f msg/sec", thread_id, i, rate);
+    t->fast.push_back(nanos_since_boot() - start);
+
+    start = nanos_since_boot();
+    LOGD_DEFER("thread %d cycle %d, %.2f msg/sec", thread_id, i, rate);
+    t->deferred.push_back(nanos_since_boot() - start);
+
+    start = nanos_since_boot();
+    cloudlog_e(CLOUDLOG_DEBUG, __FILE__, __LINE__, __func__, "thread %d cycle %d, %.2f msg/sec", thread_id, i, rate);
+    t->sync.push_back(nanos_since_boot() - start);
+
+    util::sleep_for(10);
+  }
+}
+
+static void print(const char *name, std::vector<uint64_t> &ns) {
+  std::sort(ns.begin(), ns.end());
+  auto at = [&](double p) { return ns[std::min<size_t>(ns.size() * p, ns.size() - 1)] / 1e3; };
+  printf("%-10s p50 %7.2f us, p99 %7.2f us, max %7.2f us\n", name, at(0.5), at(0.99), ns.back() / 1e3);
+}
+
+int main(int argc, char *argv[]) {
+  int thread_cnt = 8;
+  int seconds = 5;
+  const option opts[] = {
+    {"threads", required_argument, nullptr, 't'},
+    {"seconds", required_argument, nullptr, 's'},
+    {nullptr, 0, nullptr, 0},
+  };
+  for (int opt; (opt = getopt_long(argc, argv, "", opts, nullptr)) != -1;) {
+    switch (opt) {
+      case 't': thread_cnt = std::max(atoi(optarg), 1); break;
+      case 's': seconds = std::max(atoi(optarg), 1); break;
+      default:
+        fprintf(stderr, "usage: %s [--threads N] [--seconds S]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  // stands in for logmessaged, so zmq_send doesn't return early for lack of a peer
+  void *zctx = zmq_ctx_new();
+  void *sock = zmq_socket(zctx, ZMQ_PULL);
+  zmq_bind(sock, Path::swaglog_ipc().c_str());
+  std::atomic<bool> stop = false;
+  std::thread receiver([&]() {
+    char buf[4096];
+    while (!stop) {
+      if (zmq_recv(sock, buf, sizeof(buf), ZMQ_DONTWAIT) <= 0) util::sleep_for(1);
+    }
+  });
+
+  // starts the swaglog thread, and keeps its setup out of the timings
+  LOGD("bench_swaglog");
+
+  const int cycles = seconds * 100;
+  std::vector<Timings> timings(thread_cnt);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_cnt; ++i) {
+    timings[i].fast.reserve(cycles);
+    timings[i].deferred.reserve(cycles);
+    timings[i].sync.reserve(cycles);
+    threads.emplace_back(log_loop, i, cycles, &timings[i]);
+  }
+  for (auto &t : threads) t.join();
+
+  Timings all;
+  for (auto &t : timings) {
+    all.fast.insert(all.fast.end(), t.fast.begin(), t.fast.end());
+    all.deferred.insert(all.deferred.end(), t.deferred.begin(), t.deferred.end());
+    all.sync.insert(all.sync.end(), t.sync.begin(), t.sync.end());
+  }
+  printf("%d threads at 100 Hz for %d s, %zu calls of each\n", thread_cnt, seconds, all.fast.size());
+  print("LOGD", all.fast);
+  print("LOGD_DEFER", all.deferred);
+  print("sync", all.sync);
+
+  stop = true;
+  receiver.join();
+  zmq_close(sock);
+  zmq_ctx_destroy(zctx);
+  return all.deferred[all.deferred.size() / 2] >= 1000;
+}
@@ -1,3 +1,8 @@
+#include <sys/wait.h>
+
+#include <future>
+#include <thread>
+
 #include "catch2/catch.hpp"
 #define private public
 #include "common/params.h"
@@ -16,8 +21,7 @@ TEST_CASE("params_nonblocking_put") {
     }
 
     // check if thread is running
-    REQUIRE(params.future.valid());
-    REQUIRE(params.future.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+    REQUIRE(params.writer.joinable());
   }
   // check results
   Params p(param_path);
@@ -25,3 +29,149 @@ TEST_CASE("params_nonblocking_put") {
     REQUIRE(p.get(name) == "1");
   }
 }
+
+TEST_CASE("params_nonblocking_coalesce") {
+  char tmp_path[] = "/tmp/asyncWriter_XXXXXX";
+  const std::string param_path = mkdtemp(tmp_path);
+  Params params(param_path);
+
+  // a placeholder keeps putNonBlocking from starting the writer, so all writes are queued before it runs
+  params.writer = std::thread([] {});
+  const int n = 100;
+  for (int i = 0; i < n; ++i) {
+    params.putNonBlocking("LastGPSPosition", std::to_string(i));
+    params.putBoolNonBlocking("IsMetric", i % 2);
+  }
+  REQUIRE(params.get("LastGPSPosition").empty());
+  params.writer.join();
+  params.writer = std::thread(&Params::asyncWriteThread, &params);
+
+  params.flush();
+  REQUIRE(params.get("LastGPSPosition") == std::to_string(n - 1));
+  REQUIRE(params.getBool("IsMetric") == ((n - 1) % 2));
+
+  auto stats = params.writerStats();
+  REQUIRE(stats.queued == 2 * n);
+  REQUIRE(stats.errors == 0);
+  REQUIRE(stats.written == 2);
+  REQUIRE(stats.coalesced == 2 * n - 2);
+  REQUIRE(stats.batches == 1);
+
+  // flush without pending writes returns right away
+  params.flush();
+}
+
+TEST_CASE("params_cache") {
+  char tmp_path[] = "/tmp/params_cache_XXXXXX";
+  const std::string param_path = mkdtemp(tmp_path);
+  Params params(param_path);
+  REQUIRE(params.get("IsMetric").empty());
+
+  SECTION("put from another instance") {
+    Params writer(param_path);
+    writer.put("IsMetric", "1");
+    REQUIRE(params.get("IsMetric") == "1");
+    writer.remove("IsMetric");
+    REQUIRE(params.get("IsMetric").empty());
+  }
+  SECTION("direct file write") {
+    params.put("IsMetric", "0");
+    REQUIRE(params.get("IsMetric") == "0");
+    util::write_file(params.getParamPath("IsMetric").c_str(), "1", 1, O_WRONLY | O_TRUNC);
+    REQUIRE(params.get("IsMetric") == "1");
+  }
+  SECTION("put from another process") {
+    for (int i = 0; i < 20; ++i) {
+      const std::string val = std::to_string(i);
+      pid_t pid = fork();
+      if (pid == 0) {
+        Params child(param_path);
+        // the forked cache must not serve the parent's values without its events
+        bool ok = child.get("IsMetric") == (i == 0 ? "" : std::to_string(i - 1));
+        child.put("IsMetric", val);
+        _exit(ok ? 0 : 1);
+      }
+      int status = 0;
+      waitpid(pid, &status, 0);
+      REQUIRE(WEXITSTATUS(status) == 0);
+      REQUIRE(params.get("IsMetric") == val);
+    }
+  }
+}
+
+TEST_CASE("params_blocking_get") {
+  char tmp_path[] = "/tmp/params_block_XXXXXX";
+  const std::string param_path = mkdtemp(tmp_path);
+  Params params(param_path);
+
+  std::thread writer([&]() {
+    util::sleep_for(50);
+    Params(param_path).put("CarParams", "test");
+  });
+  REQUIRE(params.get("CarParams", true) == "test");
+  writer.join();
+}
+
+TEST_CASE("params_watch") {
+  char tmp_path[] = "/tmp/params_watch_XXXXXX";
+  const std::string param_path = mkdtemp(tmp_path);
+  Params params(param_path);
+
+  std::promise<std::string> changed;
+  std::atomic<bool> notified = false;
+  int id = params.addWatch("IsMetric", [&](const std::string &key) {
+    if (!notified.exchange(true)) changed.set_value(key);
+  });
+  REQUIRE(id >= 0);
+  params.put("IsMetric", "1");
+  auto f = changed.get_future();
+  REQUIRE(f.wait_for(std::chrono::seconds(1)) == std::future_status::ready);
+  REQUIRE(f.get() == "IsMetric");
+  params.removeWatch(id);
+}
+
+TEST_CASE("params_watch_remove_during_delivery") {
+  char tmp_path[] = "/tmp/params_watch_XXXXXX";
+  const std::string param_path = mkdtemp(tmp_path);
+  Params params(param_path);
+
+  std::promise<void> entered;
+  std::atomic<bool> finished = false;
+  std::atomic<int> calls = 0;
+  int id = params.addWatch("IsMetric", [&](const std::string &key) {
+    if (calls++ == 0) {
+      entered.set_value();
+      util::sleep_for(200);
+      finished = true;
+    }
+  });
+  REQUIRE(id >= 0);
+  params.put("IsMetric", "1");
+  REQUIRE(entered.get_future().wait_for(std::chrono::seconds(1)) == std::future_status::ready);
+
+  // waits for the callback that is running, and drops the changes queued for it
+  params.removeWatch(id);
+  REQUIRE(finished);
+  const int calls_after_remove = calls;
+  params.put("IsMetric", "0");
+  util::sleep_for(100);
+  REQUIRE(calls == calls_after_remove);
+}
+
+TEST_CASE("params_watch_remove_from_callback") {
+  char tmp_path[] = "/tmp/params_watch_XXXXXX";
+  const std::string param_path = mkdtemp(tmp_path);
+  Params params(param_path);
+
+  std::promise<void> removed;
+  std::atomic<int> id = -1;
+  std::atomic<bool> notified = false;
+  id = params.addWatch("IsMetric", [&](const std::string &key) {
+    if (notified.exchange(true)) return;
+    params.removeWatch(id);
+    removed.set_value();
+  });
+  REQUIRE(id >= 0);
+  params.put("IsMetric", "1");
+  REQUIRE(removed.get_future().wait_for(std::chrono::seconds(1)) == std::future_status::ready);
+}
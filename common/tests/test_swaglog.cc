@@ -86,3 +86,91 @@ TEST_CASE("swaglog") {
 
   recv_log(thread_cnt, thread_msg_cnt);
 }
+
+TEST_CASE("swaglog deferred") {
+  void *zctx = zmq_ctx_new();
+  void *sock = zmq_socket(zctx, ZMQ_PULL);
+  zmq_bind(sock, Path::swaglog_ipc().c_str());
+
+  LOGD_DEFER("%d %.2f %lu", 42, 1.5, 7UL);
+  const int line_no = __LINE__ - 1;
+
+  json11::Json msg;
+  for (auto start = std::chrono::steady_clock::now();
+       msg.is_null() && std::chrono::steady_clock::now() < start + std::chrono::seconds{1};) {
+    char buf[4096] = {};
+    if (zmq_recv(sock, buf, sizeof(buf), ZMQ_DONTWAIT) <= 0) continue;
+
+    std::string err;
+    msg = json11::Json::parse(buf + 1, err);
+  }
+  REQUIRE(msg["msg"].string_value() == "42 1.50 7");
+  REQUIRE(msg["levelnum"].int_value() == CLOUDLOG_DEBUG);
+  REQUIRE(msg["lineno"].int_value() == line_no);
+  REQUIRE_THAT(msg["filename"].string_value(), Catch::Contains("test_swaglog.cc"));
+
+  zmq_close(sock);
+  zmq_ctx_destroy(zctx);
+}
+
+void overflow_thread(int thread_id, int msg_cnt, std::atomic<int> *running) {
+  for (int i = 0; i < msg_cnt; ++i) {
+    LOGD("%d %d", thread_id, i);
+  }
+  // a thread that exits hands its ring to the next one, stay until all are done
+  running->fetch_sub(1);
+  while (*running > 0) usleep(100);
+}
+
+TEST_CASE("swaglog ring overflow") {
+  void *zctx = zmq_ctx_new();
+  void *sock = zmq_socket(zctx, ZMQ_PULL);
+  zmq_bind(sock, Path::swaglog_ipc().c_str());
+
+  // with the swaglog thread held off, each thread's ring fills up and the rest is dropped
+  const int thread_cnt = 2;
+  const int ring_size = 128;
+  const int thread_msg_cnt = ring_size + 72;
+  cloudlog_pause_drain(true);
+  std::atomic<int> running = thread_cnt;
+  std::vector<std::thread> log_threads;
+  for (int i = 0; i < thread_cnt; ++i) {
+    log_threads.push_back(std::thread(overflow_thread, i, thread_msg_cnt, &running));
+  }
+  for (auto &t : log_threads) t.join();
+  cloudlog_pause_drain(false);
+
+  std::vector<int> next_seq(thread_cnt);
+  int received = 0, dropped = 0;
+  for (auto start = std::chrono::steady_clock::now();
+       (received < thread_cnt * ring_size || dropped < thread_cnt * (thread_msg_cnt - ring_size)) &&
+       std::chrono::steady_clock::now() < start + std::chrono::seconds{1};) {
+    char buf[4096] = {};
+    if (zmq_recv(sock, buf, sizeof(buf), ZMQ_DONTWAIT) <= 0) continue;
+
+    std::string err;
+    auto msg = json11::Json::parse(buf + 1, err);
+    REQUIRE(!msg.is_null());
+    const std::string text = msg["msg"].string_value();
+    if (msg["funcname"].string_value() == "overflow_thread") {
+      int thread_id = -1, seq = -1;
+      REQUIRE(sscanf(text.c_str(), "%d %d", &thread_id, &seq) == 2);
+      REQUIRE((thread_id >= 0 && thread_id < thread_cnt));
+      // the records that made it are the first ones, in the order they were logged
+      REQUIRE(seq == next_seq[thread_id]);
+      next_seq[thread_id]++;
+      received++;
+    } else if (unsigned int n = 0; sscanf(text.c_str(), "swaglog: %u messages dropped", &n) == 1) {
+      REQUIRE(msg["levelnum"].int_value() == CLOUDLOG_WARNING);
+      dropped += n;
+    }
+  }
+  for (int i = 0; i < thread_cnt; ++i) {
+    INFO("thread :" << i);
+    REQUIRE(next_seq[i] == ring_size);
+  }
+  REQUIRE(dropped == thread_cnt * (thread_msg_cnt - ring_size));
+
+  zmq_close(sock);
+  zmq_ctx_destroy(zctx);
+}
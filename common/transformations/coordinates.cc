@@ -2,6 +2,7 @@
 
 #include "common/transformations/coordinates.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <eigen3/Eigen/Dense>
@@ -61,6 +62,57 @@ Geodetic ecef2geodetic(const ECEF &e) {
   return to_degrees({lat, lon, h});
 }
 
+// the batch functions work through the points in chunks that fit on the stack,
+// so everything is computed from copies of the inputs and outputs can alias them
+constexpr int CHUNK_SIZE = 256;
+typedef Eigen::Array<double, Eigen::Dynamic, 1, 0, CHUNK_SIZE, 1> ChunkArray;
+typedef Eigen::Map<const Eigen::ArrayXd> ConstArrayMap;
+typedef Eigen::Map<Eigen::ArrayXd> ArrayMap;
+
+void geodetic2ecef_batch(const double *lat, const double *lon, const double *alt, double *x, double *y, double *z, size_t n) {
+  for (size_t i = 0; i < n; i += CHUNK_SIZE) {
+    const int m = std::min<size_t>(CHUNK_SIZE, n - i);
+    ChunkArray lat_rad = ConstArrayMap(lat + i, m) * (M_PI / 180.0);
+    ChunkArray lon_rad = ConstArrayMap(lon + i, m) * (M_PI / 180.0);
+    ChunkArray h = ConstArrayMap(alt + i, m);
+
+    ChunkArray sin_lat = lat_rad.sin();
+    ChunkArray a_xi = a / (1.0 - esq * sin_lat.square()).sqrt();
+    ChunkArray r = (a_xi + h) * lat_rad.cos();
+    ArrayMap(x + i, m) = r * lon_rad.cos();
+    ArrayMap(y + i, m) = r * lon_rad.sin();
+    ArrayMap(z + i, m) = (a_xi * (1.0 - esq) + h) * sin_lat;
+  }
+}
+
+void ecef2geodetic_batch(const double *x, const double *y, const double *z, double *lat, double *lon, double *alt, size_t n) {
+  // same Ferrari's solution as ecef2geodetic
+  const double Esq = a * a - b * b;
+  for (size_t i = 0; i < n; i += CHUNK_SIZE) {
+    const int m = std::min<size_t>(CHUNK_SIZE, n - i);
+    ChunkArray ex = ConstArrayMap(x + i, m);
+    ChunkArray ey = ConstArrayMap(y + i, m);
+    ChunkArray ez = ConstArrayMap(z + i, m);
+
+    ChunkArray r = (ex.square() + ey.square()).sqrt();
+    ChunkArray F = 54 * b * b * ez.square();
+    ChunkArray G = r.square() + (1 - esq) * ez.square() - esq * Esq;
+    ChunkArray C = (esq * esq * F * r.square()) / G.cube();
+    ChunkArray S = (1 + C + (C.square() + 2 * C).sqrt()).unaryExpr([](double v) { return std::cbrt(v); });
+    ChunkArray P = F / (3 * (S + S.inverse() + 1).square() * G.square());
+    ChunkArray Q = (1 + 2 * esq * esq * P).sqrt();
+    ChunkArray r_0 = -(P * esq * r) / (1 + Q) + (0.5 * a * a * (1 + Q.inverse()) - P * (1 - esq) * ez.square() / (Q * (1 + Q)) - 0.5 * P * r.square()).sqrt();
+    ChunkArray r_esq = (r - esq * r_0).square();
+    ChunkArray U = (r_esq + ez.square()).sqrt();
+    ChunkArray V = (r_esq + (1 - esq) * ez.square()).sqrt();
+    ChunkArray Z_0 = b * b * ez / (a * V);
+
+    ArrayMap(alt + i, m) = U * (1 - b * b / (a * V));
+    ArrayMap(lat + i, m) = ((ez + e1sq * Z_0) / r).atan() * (180.0 / M_PI);
+    ArrayMap(lon + i, m) = ey.binaryExpr(ex, [](double v, double u) { return std::atan2(v, u); }) * (180.0 / M_PI);
+  }
+}
+
 LocalCoord::LocalCoord(const Geodetic &geodetic, const ECEF &e) {
   init_ecef <<  e.x, e.y, e.z;
 
@@ -98,3 +150,39 @@ Geodetic LocalCoord::ned2geodetic(const NED &n) {
   ECEF e = ned2ecef(n);
   return ::ecef2geodetic(e);
 }
+
+void LocalCoord::ecef2ned_batch(const double *x, const double *y, const double *z, double *n, double *e, double *d, size_t count) const {
+  const Eigen::Matrix3d &M = ecef2ned_matrix;
+  for (size_t i = 0; i < count; i += CHUNK_SIZE) {
+    const int m = std::min<size_t>(CHUNK_SIZE, count - i);
+    ChunkArray dx = ConstArrayMap(x + i, m) - init_ecef[0];
+    ChunkArray dy = ConstArrayMap(y + i, m) - init_ecef[1];
+    ChunkArray dz = ConstArrayMap(z + i, m) - init_ecef[2];
+    ArrayMap(n + i, m) = M(0, 0) * dx + M(0, 1) * dy + M(0, 2) * dz;
+    ArrayMap(e + i, m) = M(1, 0) * dx + M(1, 1) * dy + M(1, 2) * dz;
+    ArrayMap(d + i, m) = M(2, 0) * dx + M(2, 1) * dy + M(2, 2) * dz;
+  }
+}
+
+void LocalCoord::ned2ecef_batch(const double *n, const double *e, const double *d, double *x, double *y, double *z, size_t count) const {
+  const Eigen::Matrix3d &M = ned2ecef_matrix;
+  for (size_t i = 0; i < count; i += CHUNK_SIZE) {
+    const int m = std::min<size_t>(CHUNK_SIZE, count - i);
+    ChunkArray cn = ConstArrayMap(n + i, m);
+    ChunkArray ce = ConstArrayMap(e + i, m);
+    ChunkArray cd = ConstArrayMap(d + i, m);
+    ArrayMap(x + i, m) = M(0, 0) * cn + M(0, 1) * ce + M(0, 2) * cd + init_ecef[0];
+    ArrayMap(y + i, m) = M(1, 0) * cn + M(1, 1) * ce + M(1, 2) * cd + init_ecef[1];
+    ArrayMap(z + i, m) = M(2, 0) * cn + M(2, 1) * ce + M(2, 2) * cd + init_ecef[2];
+  }
+}
+
+void LocalCoord::geodetic2ned_batch(const double *lat, const double *lon, const double *alt, double *n, double *e, double *d, size_t count) const {
+  ::geodetic2ecef_batch(lat, lon, alt, n, e, d, count);
+  ecef2ned_batch(n, e, d, n, e, d, count);
+}
+
+void LocalCoord::ned2geodetic_batch(const double *n, const double *e, const double *d, double *lat, double *lon, double *alt, size_t count) const {
+  ned2ecef_batch(n, e, d, lat, lon, alt, count);
+  ::ecef2geodetic_batch(lat, lon, alt, lat, lon, alt, count);
+}
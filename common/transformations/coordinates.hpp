@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #include <eigen3/Eigen/Dense>
 
 #define DEG2RAD(x) ((x) * M_PI / 180.0)
@@ -27,6 +29,11 @@ struct Geodetic {
 ECEF geodetic2ecef(const Geodetic &g);
 Geodetic ecef2geodetic(const ECEF &e);
 
+// Batch versions take n points in SoA layout, one array per component.
+// Outputs may alias the inputs. Geodetic coordinates are in degrees.
+void geodetic2ecef_batch(const double *lat, const double *lon, const double *alt, double *x, double *y, double *z, size_t n);
+void ecef2geodetic_batch(const double *x, const double *y, const double *z, double *lat, double *lon, double *alt, size_t n);
+
 class LocalCoord {
 public:
   Eigen::Matrix3d ned2ecef_matrix;
@@ -40,4 +47,9 @@ public:
   ECEF ned2ecef(const NED &n);
   NED geodetic2ned(const Geodetic &g);
   Geodetic ned2geodetic(const NED &n);
+
+  void ecef2ned_batch(const double *x, const double *y, const double *z, double *n, double *e, double *d, size_t count) const;
+  void ned2ecef_batch(const double *n, const double *e, const double *d, double *x, double *y, double *z, size_t count) const;
+  void geodetic2ned_batch(const double *lat, const double *lon, const double *alt, double *n, double *e, double *d, size_t count) const;
+  void ned2geodetic_batch(const double *n, const double *e, const double *d, double *lat, double *lon, double *alt, size_t count) const;
 };
@@ -1,5 +1,6 @@
 #define _USE_MATH_DEFINES
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <eigen3/Eigen/Dense>
@@ -36,6 +37,54 @@ Eigen::Vector3d quat2euler(const Eigen::Quaterniond &quat) {
   return {gamma, theta, psi};
 }
 
+constexpr int CHUNK_SIZE = 256;
+typedef Eigen::Array<double, Eigen::Dynamic, 1, 0, CHUNK_SIZE, 1> ChunkArray;
+typedef Eigen::Map<const Eigen::ArrayXd> ConstArrayMap;
+
+static auto atan2_array(const ChunkArray &y, const ChunkArray &x) {
+  return y.binaryExpr(x, [](double v, double u) { return std::atan2(v, u); });
+}
+
+void quat2euler_batch(const double *w, const double *x, const double *y, const double *z, double *roll, double *pitch, double *yaw, size_t n) {
+  for (size_t i = 0; i < n; i += CHUNK_SIZE) {
+    const int m = std::min<size_t>(CHUNK_SIZE, n - i);
+    ChunkArray qw = ConstArrayMap(w + i, m);
+    ChunkArray qx = ConstArrayMap(x + i, m);
+    ChunkArray qy = ConstArrayMap(y + i, m);
+    ChunkArray qz = ConstArrayMap(z + i, m);
+
+    ChunkArray gamma = atan2_array(2 * (qw * qx + qy * qz), 1 - 2 * (qx.square() + qy.square()));
+    ChunkArray theta = (2 * (qw * qy - qz * qx)).max(-1.0).min(1.0).asin();
+    ChunkArray psi = atan2_array(2 * (qw * qz + qx * qy), 1 - 2 * (qy.square() + qz.square()));
+    Eigen::Map<Eigen::ArrayXd>(roll + i, m) = gamma;
+    Eigen::Map<Eigen::ArrayXd>(pitch + i, m) = theta;
+    Eigen::Map<Eigen::ArrayXd>(yaw + i, m) = psi;
+  }
+}
+
+void euler2rot_batch(const double *roll, const double *pitch, const double *yaw, double *rot, size_t n) {
+  // Rz(yaw) * Ry(pitch) * Rx(roll), the same rotation euler2rot builds from a quaternion
+  typedef Eigen::Map<Eigen::ArrayXd, 0, Eigen::InnerStride<9>> RotMap;
+  for (size_t i = 0; i < n; i += CHUNK_SIZE) {
+    const int m = std::min<size_t>(CHUNK_SIZE, n - i);
+    ChunkArray r = ConstArrayMap(roll + i, m), p = ConstArrayMap(pitch + i, m), y = ConstArrayMap(yaw + i, m);
+    ChunkArray sr = r.sin(), cr = r.cos();
+    ChunkArray sp = p.sin(), cp = p.cos();
+    ChunkArray sy = y.sin(), cy = y.cos();
+
+    double *out = rot + 9 * i;
+    RotMap(out + 0, m) = cy * cp;
+    RotMap(out + 1, m) = cy * sp * sr - sy * cr;
+    RotMap(out + 2, m) = cy * sp * cr + sy * sr;
+    RotMap(out + 3, m) = sy * cp;
+    RotMap(out + 4, m) = sy * sp * sr + cy * cr;
+    RotMap(out + 5, m) = sy * sp * cr - cy * sr;
+    RotMap(out + 6, m) = -sp;
+    RotMap(out + 7, m) = cp * sr;
+    RotMap(out + 8, m) = cp * cr;
+  }
+}
+
 Eigen::Matrix3d quat2rot(const Eigen::Quaterniond &quat) {
   return quat.toRotationMatrix();
 }
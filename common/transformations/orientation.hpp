@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <eigen3/Eigen/Dense>
 #include "common/transformations/coordinates.hpp"
 
@@ -15,3 +16,8 @@ Eigen::Matrix3d rot_matrix(double roll, double pitch, double yaw);
 Eigen::Matrix3d rot(const Eigen::Vector3d &axis, double angle);
 Eigen::Vector3d ecef_euler_from_ned(const ECEF &ecef_init, const Eigen::Vector3d &ned_pose);
 Eigen::Vector3d ned_euler_from_ecef(const ECEF &ecef_init, const Eigen::Vector3d &ecef_pose);
+
+// Batch versions for n orientations, quaternion and euler components in SoA layout.
+// Rotation matrices are written row-major, 9 values per orientation.
+void quat2euler_batch(const double *w, const double *x, const double *y, const double *z, double *roll, double *pitch, double *yaw, size_t n);
+void euler2rot_batch(const double *roll, const double *pitch, const double *yaw, double *rot, size_t n);
@@ -3,9 +3,9 @@ from collections.abc import Callable
 
 from openpilot.common.transformations.transformations import (ecef_euler_from_ned_single,
                                                     euler2quat_single,
-                                                    euler2rot_single,
+                                                    euler2rot_batch,
                                                     ned_euler_from_ecef_single,
-                                                    quat2euler_single,
+                                                    quat2euler_batch,
                                                     quat2rot_single,
                                                     rot2euler_single,
                                                     rot2quat_single)
@@ -33,11 +33,23 @@ def numpy_wrap(function, input_shape, output_shape) -> Callable[..., np.ndarray]
   return f
 
 
+def batch_wrap(function, input_shape, output_shape) -> Callable[..., np.ndarray]:
+  """Like numpy_wrap, for functions that convert an (N, *input_shape) array in one call"""
+  def f(*inps):
+    *args, inp = inps
+    inp = np.asarray(inp, dtype=np.float64)
+    single = inp.ndim == len(input_shape)
+
+    result = function(*args, inp.reshape((-1,) + input_shape))
+    return result.reshape(output_shape if single else (inp.shape[0],) + output_shape)
+  return f
+
+
 euler2quat = numpy_wrap(euler2quat_single, (3,), (4,))
-quat2euler = numpy_wrap(quat2euler_single, (4,), (3,))
+quat2euler = batch_wrap(quat2euler_batch, (4,), (3,))
 quat2rot = numpy_wrap(quat2rot_single, (4,), (3, 3))
 rot2quat = numpy_wrap(rot2quat_single, (3, 3), (4,))
-euler2rot = numpy_wrap(euler2rot_single, (3,), (3, 3))
+euler2rot = batch_wrap(euler2rot_batch, (3,), (3, 3))
 rot2euler = numpy_wrap(rot2euler_single, (3, 3), (3,))
 ecef_euler_from_ned = numpy_wrap(ecef_euler_from_ned_single, (3,), (3,))
 ned_euler_from_ecef = numpy_wrap(ned_euler_from_ecef_single, (3,), (3,))
@@ -1,6 +1,7 @@
 import numpy as np
 
 import openpilot.common.transformations.coordinates as coord
+from openpilot.common.transformations.transformations import ecef2geodetic_single, geodetic2ecef_single
 
 geodetic_positions = np.array([[37.7610403, -122.4778699, 115],
                                  [27.4840915, -68.5867592, 2380],
@@ -102,3 +103,33 @@ class TestNED:
     np.testing.assert_allclose(converter.ned2ecef(ned_offsets_batch),
                                                            ecef_positions_offset_batch,
                                                            rtol=1e-9, atol=1e-7)
+
+  def test_batch_matches_single(self):
+    rng = np.random.default_rng(0)
+    geodetic = np.column_stack([rng.uniform(-89.9, 89.9, 1000), rng.uniform(-180, 180, 1000), rng.uniform(-500, 5000, 1000)])
+
+    ecef = coord.geodetic2ecef(geodetic)
+    np.testing.assert_allclose(ecef, [geodetic2ecef_single(g) for g in geodetic], rtol=0, atol=1e-6)
+    # the batch path evaluates the altitude in a different order, nanometers off the scalar one
+    geodetic_batch, geodetic_single = coord.ecef2geodetic(ecef), np.array([ecef2geodetic_single(e) for e in ecef])
+    np.testing.assert_allclose(geodetic_batch[:, :2], geodetic_single[:, :2], rtol=0, atol=1e-9)
+    np.testing.assert_allclose(geodetic_batch[:, 2], geodetic_single[:, 2], rtol=0, atol=1e-6)
+
+    converter = coord.LocalCoord.from_geodetic(geodetic_positions[0])
+    ned = converter.geodetic2ned(geodetic)
+    np.testing.assert_allclose(ned, [converter.geodetic2ned_single(g) for g in geodetic], rtol=0, atol=1e-6)
+    np.testing.assert_allclose(converter.ecef2ned(ecef), [converter.ecef2ned_single(e) for e in ecef], rtol=0, atol=1e-6)
+    np.testing.assert_allclose(converter.ned2ecef(ned), [converter.ned2ecef_single(n) for n in ned], rtol=0, atol=1e-6)
+    geodetic_batch, geodetic_single = converter.ned2geodetic(ned), np.array([converter.ned2geodetic_single(n) for n in ned])
+    np.testing.assert_allclose(geodetic_batch[:, :2], geodetic_single[:, :2], rtol=0, atol=1e-9)
+    np.testing.assert_allclose(geodetic_batch[:, 2], geodetic_single[:, 2], rtol=0, atol=1e-6)
+
+    for out in (ecef, geodetic_batch, ned, converter.ecef2ned(ecef), converter.ned2ecef(ned)):
+      assert out.flags.c_contiguous
+
+  def test_batch_input_unchanged(self):
+    geodetic = geodetic_positions.copy()
+    coord.geodetic2ecef(geodetic)
+    coord.geodetic2ecef(geodetic[0])
+    np.testing.assert_array_equal(geodetic, geodetic_positions)
+    assert coord.geodetic2ecef(np.zeros((0, 3))).shape == (0, 3)
@@ -3,6 +3,7 @@ import numpy as np
 from openpilot.common.transformations.orientation import euler2quat, quat2euler, euler2rot, rot2euler, \
                                                rot2quat, quat2rot, \
                                                ned_euler_from_ecef
+from openpilot.common.transformations.transformations import euler2rot_single, quat2euler_single
 
 eulers = np.array([[ 1.46520501,  2.78688383,  2.92780854],
        [ 4.86909526,  3.60618161,  4.30648981],
@@ -59,3 +60,12 @@ class TestOrientation:
       np.testing.assert_allclose(ned_eulers[i], ned_euler_from_ecef(ecef_positions[i], eulers[i]), rtol=1e-7)
       #np.testing.assert_allclose(eulers[i], ecef_euler_from_ned(ecef_positions[i], ned_eulers[i]), rtol=1e-7)
     # np.testing.assert_allclose(ned_eulers, ned_euler_from_ecef(ecef_positions, eulers), rtol=1e-7)
+
+  def test_batch_matches_single(self):
+    rng = np.random.default_rng(0)
+    random_quats = rng.normal(size=(1000, 4))
+    random_quats /= np.linalg.norm(random_quats, axis=1, keepdims=True)
+
+    random_eulers = quat2euler(random_quats)
+    np.testing.assert_allclose(random_eulers, [quat2euler_single(q) for q in random_quats], rtol=0, atol=1e-12)
+    np.testing.assert_allclose(euler2rot(random_eulers), [euler2rot_single(e) for e in random_eulers], rtol=0, atol=1e-12)
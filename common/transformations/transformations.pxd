@@ -34,6 +34,9 @@ cdef extern from "orientation.hpp":
   Vector3 ecef_euler_from_ned(const ECEF &, const Vector3 &)
   Vector3 ned_euler_from_ecef(const ECEF &, const Vector3 &)
 
+  void quat2euler_batch(const double *, const double *, const double *, const double *, double *, double *, double *, size_t)
+  void euler2rot_batch(const double *, const double *, const double *, double *, size_t)
+
 
 cdef extern from "coordinates.cc":
   cdef struct ECEF:
@@ -55,6 +58,9 @@ cdef extern from "coordinates.cc":
   ECEF geodetic2ecef(const Geodetic &)
   Geodetic ecef2geodetic(const ECEF &)
 
+  void geodetic2ecef_batch(const double *, const double *, const double *, double *, double *, double *, size_t)
+  void ecef2geodetic_batch(const double *, const double *, const double *, double *, double *, double *, size_t)
+
   cdef cppclass LocalCoord_c "LocalCoord":
     Matrix3 ned2ecef_matrix
     Matrix3 ecef2ned_matrix
@@ -68,5 +74,10 @@ cdef extern from "coordinates.cc":
     NED geodetic2ned(const Geodetic &)
     Geodetic ned2geodetic(const NED &)
 
+    void ecef2ned_batch(const double *, const double *, const double *, double *, double *, double *, size_t)
+    void ned2ecef_batch(const double *, const double *, const double *, double *, double *, double *, size_t)
+    void geodetic2ned_batch(const double *, const double *, const double *, double *, double *, double *, size_t)
+    void ned2geodetic_batch(const double *, const double *, const double *, double *, double *, double *, size_t)
+
 cdef extern from "coordinates.hpp":
   pass
@@ -15,6 +15,10 @@ from openpilot.common.transformations.transformations cimport ned_euler_from_ece
 from openpilot.common.transformations.transformations cimport geodetic2ecef as geodetic2ecef_c
 from openpilot.common.transformations.transformations cimport ecef2geodetic as ecef2geodetic_c
 from openpilot.common.transformations.transformations cimport LocalCoord_c
+from openpilot.common.transformations.transformations cimport quat2euler_batch as quat2euler_batch_c
+from openpilot.common.transformations.transformations cimport euler2rot_batch as euler2rot_batch_c
+from openpilot.common.transformations.transformations cimport geodetic2ecef_batch as geodetic2ecef_batch_c
+from openpilot.common.transformations.transformations cimport ecef2geodetic_batch as ecef2geodetic_batch_c
 
 
 import numpy as np
@@ -32,6 +36,14 @@ cdef Matrix3 numpy2matrix(np.ndarray[double, ndim=2, mode="fortran"] m):
     assert m.shape[1] == 3
     return Matrix3(<double*>m.data)
 
+cdef np.ndarray[double, ndim=2, mode="c"] to_soa(points, int dim):
+    # (N, dim) points to one contiguous row per component. always a copy, the batch functions work in place
+    return np.array(np.asarray(points, dtype=np.double).reshape(-1, dim).T, order='C')
+
+cdef np.ndarray from_soa(np.ndarray soa):
+    # back to C ordered (N, dim) points, callers expect rows they can hand to C code
+    return np.array(soa.T, order='C')
+
 cdef ECEF list2ecef(ecef):
     cdef ECEF e
     e.x = ecef[0]
@@ -110,6 +122,37 @@ def ecef2geodetic_single(ecef):
     cdef Geodetic g = ecef2geodetic_c(e)
     return [g.lat, g.lon, g.alt]
 
+def quat2euler_batch(quats):
+    cdef np.ndarray[double, ndim=2, mode="c"] q = to_soa(quats, 4)
+    cdef size_t n = q.shape[1]
+    cdef np.ndarray[double, ndim=2, mode="c"] e = np.empty((3, n))
+    cdef double *qp = <double*>q.data
+    cdef double *ep = <double*>e.data
+    quat2euler_batch_c(qp, qp + n, qp + 2*n, qp + 3*n, ep, ep + n, ep + 2*n, n)
+    return from_soa(e)
+
+def euler2rot_batch(eulers):
+    cdef np.ndarray[double, ndim=2, mode="c"] e = to_soa(eulers, 3)
+    cdef size_t n = e.shape[1]
+    cdef np.ndarray[double, ndim=3, mode="c"] r = np.empty((n, 3, 3))
+    cdef double *ep = <double*>e.data
+    euler2rot_batch_c(ep, ep + n, ep + 2*n, <double*>r.data, n)
+    return r
+
+def geodetic2ecef_batch(geodetic):
+    cdef np.ndarray[double, ndim=2, mode="c"] g = to_soa(geodetic, 3)
+    cdef size_t n = g.shape[1]
+    cdef double *gp = <double*>g.data
+    geodetic2ecef_batch_c(gp, gp + n, gp + 2*n, gp, gp + n, gp + 2*n, n)
+    return from_soa(g)
+
+def ecef2geodetic_batch(ecef):
+    cdef np.ndarray[double, ndim=2, mode="c"] e = to_soa(ecef, 3)
+    cdef size_t n = e.shape[1]
+    cdef double *ep = <double*>e.data
+    ecef2geodetic_batch_c(ep, ep + n, ep + 2*n, ep, ep + n, ep + 2*n, n)
+    return from_soa(e)
+
 
 cdef class LocalCoord:
     cdef LocalCoord_c * lc
@@ -169,5 +212,37 @@ cdef class LocalCoord:
         cdef Geodetic g = self.lc.ned2geodetic(n)
         return [g.lat, g.lon, g.alt]
 
+    def ecef2ned_batch(self, ecef):
+        assert self.lc
+        cdef np.ndarray[double, ndim=2, mode="c"] p = to_soa(ecef, 3)
+        cdef size_t n = p.shape[1]
+        cdef double *pp = <double*>p.data
+        self.lc.ecef2ned_batch(pp, pp + n, pp + 2*n, pp, pp + n, pp + 2*n, n)
+        return from_soa(p)
+
+    def ned2ecef_batch(self, ned):
+        assert self.lc
+        cdef np.ndarray[double, ndim=2, mode="c"] p = to_soa(ned, 3)
+        cdef size_t n = p.shape[1]
+        cdef double *pp = <double*>p.data
+        self.lc.ned2ecef_batch(pp, pp + n, pp + 2*n, pp, pp + n, pp + 2*n, n)
+        return from_soa(p)
+
+    def geodetic2ned_batch(self, geodetic):
+        assert self.lc
+        cdef np.ndarray[double, ndim=2, mode="c"] p = to_soa(geodetic, 3)
+        cdef size_t n = p.shape[1]
+        cdef double *pp = <double*>p.data
+        self.lc.geodetic2ned_batch(pp, pp + n, pp + 2*n, pp, pp + n, pp + 2*n, n)
+        return from_soa(p)
+
+    def ned2geodetic_batch(self, ned):
+        assert self.lc
+        cdef np.ndarray[double, ndim=2, mode="c"] p = to_soa(ned, 3)
+        cdef size_t n = p.shape[1]
+        cdef double *pp = <double*>p.data
+        self.lc.ned2geodetic_batch(pp, pp + n, pp + 2*n, pp, pp + n, pp + 2*n, n)
+        return from_soa(p)
+
     def __dealloc__(self):
         del self.lc
@@ -82,7 +82,7 @@ class ModelState:
     t1 = time.perf_counter()
 
     input_img_cl = self.frame.prepare(buf, transform.flatten())
-    if TICI:
+    if TICI and not self.frame.cpu:
       # The imgs tensors are backed by opencl memory, only need init once
       if 'input_img' not in self.tensor_inputs:
         self.tensor_inputs['input_img'] = qcom_tensor_from_opencl_address(input_img_cl.mem_address, (1, MODEL_WIDTH*MODEL_HEIGHT), dtype=dtypes.uint8)
@@ -161,6 +161,8 @@ class ModelState(ModelStateBase):
       policy_output_size = policy_metadata['output_shapes']['outputs'][1]
 
     self.frames = {name: DrivingModelFrame(context, ModelConstants.MODEL_RUN_FREQ//ModelConstants.MODEL_CONTEXT_FREQ) for name in self.vision_input_names}
+    # with MODELD_CPU_PREP=1 the frames aren't in opencl memory, even on TICI
+    self.cl_inputs = TICI and not USBGPU and not any(frame.cpu for frame in self.frames.values())
     self.prev_desire = np.zeros(ModelConstants.DESIRE_LEN, dtype=np.float32)
 
     # policy inputs
@@ -196,7 +198,7 @@ class ModelState(ModelStateBase):
 
     imgs_cl = {name: self.frames[name].prepare(bufs[name], transforms[name].flatten()) for name in self.vision_input_names}
 
-    if TICI and not USBGPU:
+    if self.cl_inputs:
       # The imgs tensors are backed by opencl memory, only need init once
       for key in imgs_cl:
         if key not in self.vision_inputs:
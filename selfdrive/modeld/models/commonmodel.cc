@@ -5,47 +5,78 @@
 
 #include "common/clutil.h"
 
-DrivingModelFrame::DrivingModelFrame(cl_device_id device_id, cl_context context, int _temporal_skip) : ModelFrame(device_id, context) {
-  input_frames = std::make_unique<uint8_t[]>(buf_size);
+DrivingModelFrame::DrivingModelFrame(cl_device_id device_id, cl_context context, int _temporal_skip, int model_width, int model_height)
+    : ModelFrame(device_id, context), MODEL_WIDTH(model_width), MODEL_HEIGHT(model_height) {
+  init_input_frames(buf_size);
   temporal_skip = _temporal_skip;
+  if (cpu) {
+    img_buffer_20hz = std::make_unique<uint8_t[]>((temporal_skip+1)*frame_size_bytes);
+    init_transform(device_id, context, MODEL_WIDTH, MODEL_HEIGHT);
+    return;
+  }
   input_frames_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, buf_size, NULL, &err));
   img_buffer_20hz_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (temporal_skip+1)*frame_size_bytes, NULL, &err));
-  region.origin = temporal_skip * frame_size_bytes;
-  region.size = frame_size_bytes;
-  last_img_cl = CL_CHECK_ERR(clCreateSubBuffer(img_buffer_20hz_cl, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err));
+  for (int i = 0; i <= temporal_skip; i++) {
+    cl_buffer_region region = {.origin = i * frame_size_bytes, .size = frame_size_bytes};
+    img_slots_cl.push_back(CL_CHECK_ERR(clCreateSubBuffer(img_buffer_20hz_cl, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err)));
+  }
 
   loadyuv_init(&loadyuv, context, device_id, MODEL_WIDTH, MODEL_HEIGHT);
   init_transform(device_id, context, MODEL_WIDTH, MODEL_HEIGHT);
 }
 
 cl_mem* DrivingModelFrame::prepare(cl_mem yuv_cl, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection) {
-  run_transform(yuv_cl, MODEL_WIDTH, MODEL_HEIGHT, frame_width, frame_height, frame_stride, frame_uv_offset, projection);
-
-  for (int i = 0; i < temporal_skip; i++) {
-    CL_CHECK(clEnqueueCopyBuffer(q, img_buffer_20hz_cl, img_buffer_20hz_cl, (i+1)*frame_size_bytes, i*frame_size_bytes, frame_size_bytes, 0, nullptr, nullptr));
+  newest_slot = (newest_slot + 1) % (temporal_skip + 1);
+  const int oldest_slot = (newest_slot + 1) % (temporal_skip + 1);
+  if (fused) {
+    transform_packed_queue(&transform, q, yuv_cl, frame_width, frame_height, frame_stride, frame_uv_offset,
+                           img_buffer_20hz_cl, newest_slot * frame_size_bytes, MODEL_WIDTH, MODEL_HEIGHT, projection);
+  } else {
+    run_transform(yuv_cl, MODEL_WIDTH, MODEL_HEIGHT, frame_width, frame_height, frame_stride, frame_uv_offset, projection);
+    loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, img_slots_cl[newest_slot]);
   }
-  loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, last_img_cl);
-
-  copy_queue(&loadyuv, q, img_buffer_20hz_cl, input_frames_cl, 0, 0, frame_size_bytes);
-  copy_queue(&loadyuv, q, last_img_cl, input_frames_cl, 0, frame_size_bytes, frame_size_bytes);
 
-  // NOTE: Since thneed is using a different command queue, this clFinish is needed to ensure the image is ready.
-  clFinish(q);
+  copy_queue(&loadyuv, q, img_buffer_20hz_cl, input_frames_cl, oldest_slot * frame_size_bytes, 0, frame_size_bytes);
+  copy_queue(&loadyuv, q, img_buffer_20hz_cl, input_frames_cl, newest_slot * frame_size_bytes, frame_size_bytes, frame_size_bytes);
+  // NOTE: Since thneed is using a different command queue, the kernels have to be finished here to ensure the image is ready.
+  finish_prepare();
   return &input_frames_cl;
 }
 
+uint8_t* DrivingModelFrame::prepare_cpu(const uint8_t *yuv, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection) {
+  newest_slot = (newest_slot + 1) % (temporal_skip + 1);
+  const int oldest_slot = (newest_slot + 1) % (temporal_skip + 1);
+  uint8_t *last_img = &img_buffer_20hz[newest_slot*frame_size_bytes];
+  if (fused) {
+    transform_packed_cpu(yuv, frame_width, frame_height, frame_stride, frame_uv_offset, last_img, MODEL_WIDTH, MODEL_HEIGHT, projection);
+  } else {
+    run_transform_cpu(yuv, MODEL_WIDTH, MODEL_HEIGHT, frame_width, frame_height, frame_stride, frame_uv_offset, projection);
+    loadyuv_cpu(y_buf.get(), u_buf.get(), v_buf.get(), last_img, MODEL_WIDTH, MODEL_HEIGHT);
+  }
+
+  uint8_t *frames = next_input_frame();
+  memcpy(&frames[0], &img_buffer_20hz[oldest_slot*frame_size_bytes], frame_size_bytes);
+  memcpy(&frames[frame_size_bytes], last_img, frame_size_bytes);
+  return frames;
+}
+
 DrivingModelFrame::~DrivingModelFrame() {
   deinit_transform();
+  if (cpu) return;
   loadyuv_destroy(&loadyuv);
   CL_CHECK(clReleaseMemObject(input_frames_cl));
+  for (cl_mem slot : img_slots_cl) {
+    CL_CHECK(clReleaseMemObject(slot));
+  }
   CL_CHECK(clReleaseMemObject(img_buffer_20hz_cl));
-  CL_CHECK(clReleaseMemObject(last_img_cl));
   CL_CHECK(clReleaseCommandQueue(q));
 }
 
 
-MonitoringModelFrame::MonitoringModelFrame(cl_device_id device_id, cl_context context) : ModelFrame(device_id, context) {
-  input_frames = std::make_unique<uint8_t[]>(buf_size);
+MonitoringModelFrame::MonitoringModelFrame(cl_device_id device_id, cl_context context, int model_width, int model_height)
+    : ModelFrame(device_id, context), MODEL_WIDTH(model_width), MODEL_HEIGHT(model_height) {
+  init_input_frames(buf_size);
+  if (cpu) return;
   input_frame_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, buf_size, NULL, &err));
 
   init_transform(device_id, context, MODEL_WIDTH, MODEL_HEIGHT);
@@ -53,12 +84,21 @@ MonitoringModelFrame::MonitoringModelFrame(cl_device_id device_id, cl_context co
 
 cl_mem* MonitoringModelFrame::prepare(cl_mem yuv_cl, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection) {
   run_transform(yuv_cl, MODEL_WIDTH, MODEL_HEIGHT, frame_width, frame_height, frame_stride, frame_uv_offset, projection);
-  clFinish(q);
+  finish_prepare();
   return &y_cl;
 }
 
+uint8_t* MonitoringModelFrame::prepare_cpu(const uint8_t *yuv, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection) {
+  // only the y plane is used, warp it straight into the input
+  uint8_t *frame = next_input_frame();
+  warp_perspective_cpu(yuv, frame_stride, 1, 0, frame_height, frame_width,
+                       frame, MODEL_WIDTH, 0, MODEL_HEIGHT, MODEL_WIDTH, projection);
+  return frame;
+}
+
 MonitoringModelFrame::~MonitoringModelFrame() {
   deinit_transform();
+  if (cpu) return;
   CL_CHECK(clReleaseMemObject(input_frame_cl));
   CL_CHECK(clReleaseCommandQueue(q));
 }
@@ -5,6 +5,7 @@
 #include <cassert>
 
 #include <memory>
+#include <vector>
 
 #define CL_USE_DEPRECATED_OPENCL_1_2_APIS
 #ifdef __APPLE__
@@ -14,22 +15,45 @@
 #endif
 
 #include "common/mat.h"
+#include "common/util.h"
 #include "selfdrive/modeld/transforms/loadyuv.h"
 #include "selfdrive/modeld/transforms/transform.h"
+#include "selfdrive/modeld/transforms/transform_cpu.h"
 
 class ModelFrame {
 public:
-  ModelFrame(cl_device_id device_id, cl_context context) {
-    q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
+  // frame prep runs on the CPU without a CL context, or when MODELD_CPU_PREP=1
+  ModelFrame(cl_device_id device_id, cl_context context) : cpu(context == nullptr || util::getenv("MODELD_CPU_PREP", 0) != 0) {
+    if (!cpu) {
+      q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
+    }
+  }
+  virtual ~ModelFrame() {
+    if (readback_event) clReleaseEvent(readback_event);
   }
-  virtual ~ModelFrame() {}
   virtual cl_mem* prepare(cl_mem yuv_cl, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection) { return NULL; }
+  // same output as prepare, read back already
+  virtual uint8_t* prepare_cpu(const uint8_t *yuv, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection) { return NULL; }
   uint8_t* buffer_from_cl(cl_mem *in_frames, int buffer_size) {
-    CL_CHECK(clEnqueueReadBuffer(q, *in_frames, CL_TRUE, 0, buffer_size, input_frames.get(), 0, nullptr, nullptr));
-    clFinish(q);
-    return &input_frames[0];
+    if (cpu) {
+      return input_frames[readback_idx].get();
+    }
+    if (readback_event && in_frames == readback_src && buffer_size == readback_size) {
+      // already read back by prepare()
+      CL_CHECK(clWaitForEvents(1, &readback_event));
+      CL_CHECK(clReleaseEvent(readback_event));
+      readback_event = nullptr;
+      return input_frames[readback_idx].get();
+    }
+    readback_src = in_frames;
+    readback_size = buffer_size;
+    uint8_t *frames = next_input_frame();
+    CL_CHECK(clEnqueueReadBuffer(q, *in_frames, CL_TRUE, 0, buffer_size, frames, 0, nullptr, nullptr));
+    return frames;
   }
 
+  const bool cpu;
+
   int MODEL_WIDTH;
   int MODEL_HEIGHT;
   int MODEL_FRAME_SIZE;
@@ -39,9 +63,49 @@ protected:
   cl_mem y_cl, u_cl, v_cl;
   Transform transform;
   cl_command_queue q;
-  std::unique_ptr<uint8_t[]> input_frames;
+  // double buffered, the array returned for a frame stays valid while the next one is prepared
+  std::unique_ptr<uint8_t[]> input_frames[2];
+  int readback_idx = 0;
+  cl_mem *readback_src = nullptr;
+  int readback_size = 0;
+  cl_event readback_event = nullptr;
+  std::unique_ptr<uint8_t[]> y_buf, u_buf, v_buf;
+
+  void init_input_frames(int size) {
+    for (auto &f : input_frames) f = std::make_unique<uint8_t[]>(size);
+  }
+
+  uint8_t* next_input_frame() {
+    readback_idx ^= 1;
+    return input_frames[readback_idx].get();
+  }
+
+  // Once buffer_from_cl was called, the output of each prepare() is read back along with the frame
+  // instead of in a second round trip. Consumers using the cl_mem directly never enable it.
+  void queue_readback() {
+    if (!readback_src) return;
+    if (readback_event) CL_CHECK(clReleaseEvent(readback_event));
+    CL_CHECK(clEnqueueReadBuffer(q, *readback_src, CL_FALSE, 0, readback_size, next_input_frame(), 0, nullptr, &readback_event));
+  }
+
+  // Ends prepare(): queues the readback and waits for the kernels only. The readback runs on while
+  // the host goes on, buffer_from_cl waits for it.
+  void finish_prepare() {
+    cl_event kernels_done;
+    CL_CHECK(clEnqueueMarkerWithWaitList(q, 0, nullptr, &kernels_done));
+    queue_readback();
+    CL_CHECK(clFlush(q));
+    CL_CHECK(clWaitForEvents(1, &kernels_done));
+    CL_CHECK(clReleaseEvent(kernels_done));
+  }
 
   void init_transform(cl_device_id device_id, cl_context context, int model_width, int model_height) {
+    if (cpu) {
+      y_buf = std::make_unique<uint8_t[]>(model_width * model_height);
+      u_buf = std::make_unique<uint8_t[]>((model_width / 2) * (model_height / 2));
+      v_buf = std::make_unique<uint8_t[]>((model_width / 2) * (model_height / 2));
+      return;
+    }
     y_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, model_width * model_height, NULL, &err));
     u_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (model_width / 2) * (model_height / 2), NULL, &err));
     v_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (model_width / 2) * (model_height / 2), NULL, &err));
@@ -49,6 +113,7 @@ protected:
   }
 
   void deinit_transform() {
+    if (cpu) return;
     transform_destroy(&transform);
     CL_CHECK(clReleaseMemObject(v_cl));
     CL_CHECK(clReleaseMemObject(u_cl));
@@ -60,35 +125,49 @@ protected:
         yuv_cl, frame_width, frame_height, frame_stride, frame_uv_offset,
         y_cl, u_cl, v_cl, model_width, model_height, projection);
   }
+
+  void run_transform_cpu(const uint8_t *yuv, int model_width, int model_height, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection) {
+    transform_cpu(yuv, frame_width, frame_height, frame_stride, frame_uv_offset,
+        y_buf.get(), u_buf.get(), v_buf.get(), model_width, model_height, projection);
+  }
 };
 
+// The input is two frames temporal_skip frames apart, kept in a ring of temporal_skip + 1 frames.
 class DrivingModelFrame : public ModelFrame {
 public:
-  DrivingModelFrame(cl_device_id device_id, cl_context context, int _temporal_skip);
+  DrivingModelFrame(cl_device_id device_id, cl_context context, int _temporal_skip, int model_width = 512, int model_height = 256);
   ~DrivingModelFrame();
   cl_mem* prepare(cl_mem yuv_cl, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection);
+  uint8_t* prepare_cpu(const uint8_t *yuv, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection);
 
-  const int MODEL_WIDTH = 512;
-  const int MODEL_HEIGHT = 256;
+  const int MODEL_WIDTH;
+  const int MODEL_HEIGHT;
   const int MODEL_FRAME_SIZE = MODEL_WIDTH * MODEL_HEIGHT * 3 / 2;
   const int buf_size = MODEL_FRAME_SIZE * 2; // 2 frames are temporal_skip frames apart
   const size_t frame_size_bytes = MODEL_FRAME_SIZE * sizeof(uint8_t);
+  // MODELD_FUSED_PREP=1 warps straight into the input layout in one pass instead of transform + loadyuv.
+  // off until bench_frameprep --verify has matched it against transform + loadyuv on the device
+  bool fused = util::getenv("MODELD_FUSED_PREP", 0) != 0;
 
 private:
   LoadYUVState loadyuv;
-  cl_mem img_buffer_20hz_cl, last_img_cl, input_frames_cl;
-  cl_buffer_region region;
+  // the new frame overwrites the oldest one, newest_slot + 1 holds the frame from temporal_skip frames ago
+  cl_mem img_buffer_20hz_cl, input_frames_cl;
+  std::vector<cl_mem> img_slots_cl;
   int temporal_skip;
+  int newest_slot = 0;
+  std::unique_ptr<uint8_t[]> img_buffer_20hz;
 };
 
 class MonitoringModelFrame : public ModelFrame {
 public:
-  MonitoringModelFrame(cl_device_id device_id, cl_context context);
+  MonitoringModelFrame(cl_device_id device_id, cl_context context, int model_width = 1440, int model_height = 960);
   ~MonitoringModelFrame();
   cl_mem* prepare(cl_mem yuv_cl, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection);
+  uint8_t* prepare_cpu(const uint8_t *yuv, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3& projection);
 
-  const int MODEL_WIDTH = 1440;
-  const int MODEL_HEIGHT = 960;
+  const int MODEL_WIDTH;
+  const int MODEL_HEIGHT;
   const int MODEL_FRAME_SIZE = MODEL_WIDTH * MODEL_HEIGHT;
   const int buf_size = MODEL_FRAME_SIZE;
 
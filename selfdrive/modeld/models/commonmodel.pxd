@@ -1,5 +1,6 @@
 # distutils: language = c++
 
+from libcpp cimport bool
 from msgq.visionipc.visionipc cimport cl_device_id, cl_context, cl_mem
 
 cdef extern from "common/mat.h":
@@ -15,8 +16,10 @@ cdef extern from "common/clutil.h":
 cdef extern from "selfdrive/modeld/models/commonmodel.h":
   cppclass ModelFrame:
     int buf_size
+    bool cpu
     unsigned char * buffer_from_cl(cl_mem*, int);
     cl_mem * prepare(cl_mem, int, int, int, int, mat3)
+    unsigned char * prepare_cpu(const unsigned char*, int, int, int, int, mat3)
 
   cppclass DrivingModelFrame:
     int buf_size
@@ -43,10 +43,19 @@ cdef class ModelFrame:
   def __dealloc__(self):
     del self.frame
 
+  @property
+  def cpu(self):
+    # prepare() returns no cl_mem then, the input is only available through buffer_from_cl
+    return self.frame.cpu
+
   def prepare(self, VisionBuf buf, float[:] projection):
     cdef mat3 cprojection
     memcpy(cprojection.v, &projection[0], 9*sizeof(float))
     cdef cl_mem * data
+    if self.frame.cpu:
+      # the frame is already in input_frames, buffer_from_cl only returns it
+      self.frame.prepare_cpu(<unsigned char*>buf.buf.addr, buf.width, buf.height, buf.stride, buf.uv_offset, cprojection)
+      return CLMem.create(NULL)
     data = self.frame.prepare(buf.buf.buf_cl, buf.width, buf.height, buf.stride, buf.uv_offset, cprojection)
     return CLMem.create(data)
 
@@ -60,7 +69,11 @@ cdef class DrivingModelFrame(ModelFrame):
   cdef cppDrivingModelFrame * _frame
 
   def __cinit__(self, CLContext context, int temporal_skip):
-    self._frame = new cppDrivingModelFrame(context.device_id, context.context, temporal_skip)
+    # without a context frame prep runs on the CPU
+    if context is None:
+      self._frame = new cppDrivingModelFrame(NULL, NULL, temporal_skip)
+    else:
+      self._frame = new cppDrivingModelFrame(context.device_id, context.context, temporal_skip)
     self.frame = <cppModelFrame*>(self._frame)
     self.buf_size = self._frame.buf_size
 
@@ -68,7 +81,10 @@ cdef class MonitoringModelFrame(ModelFrame):
   cdef cppMonitoringModelFrame * _frame
 
   def __cinit__(self, CLContext context):
-    self._frame = new cppMonitoringModelFrame(context.device_id, context.context)
+    if context is None:
+      self._frame = new cppMonitoringModelFrame(NULL, NULL)
+    else:
+      self._frame = new cppMonitoringModelFrame(context.device_id, context.context)
     self.frame = <cppModelFrame*>(self._frame)
     self.buf_size = self._frame.buf_size
 
@@ -0,0 +1,205 @@
+// Times the frame prep variants the model runners use on the CPU and, with --cl, on the OpenCL
+// device: driving frames with the temporal skip of the 20hz (4) and 5hz (1) buffers, monitoring
+// frames, and the float output of the legacy runners. "driving" is the fused warp of
+// MODELD_FUSED_PREP=1, "unfused" the separate transform and loadyuv passes modeld uses by default.
+// --verify also runs both paths over random projections and fails if any output byte differs,
+// between the fused and unfused driving frames on the device, and between CL and CPU.
+//
+// usage: bench_frameprep [--iterations N] [--cl] [--verify]
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/clutil.h"
+#include "common/timing.h"
+#include "selfdrive/modeld/models/commonmodel.h"
+
+// same layout as the road camera buffers
+const int FRAME_WIDTH = 1928;
+const int FRAME_HEIGHT = 1208;
+const int FRAME_STRIDE = 2048;
+const int FRAME_UV_OFFSET = FRAME_STRIDE * FRAME_HEIGHT;
+const int FRAME_SIZE = FRAME_UV_OFFSET + FRAME_STRIDE * FRAME_HEIGHT / 2;
+
+// maps the model input centered into the frame, with a random perturbation
+static mat3 projection(int model_width, int model_height, float scale, std::mt19937 &gen, float jitter) {
+  std::uniform_real_distribution<float> d(-jitter, jitter);
+  return {{
+    scale * (1.0f + d(gen) * 0.1f), d(gen) * 0.05f, FRAME_WIDTH / 2.0f - scale * model_width / 2.0f + d(gen) * 200.0f,
+    d(gen) * 0.05f, scale * (1.0f + d(gen) * 0.1f), FRAME_HEIGHT / 2.0f - scale * model_height / 2.0f + d(gen) * 200.0f,
+    d(gen) * 1e-4f, d(gen) * 1e-4f, 1.0f,
+  }};
+}
+
+template <class F>
+static void measure(const char *name, int iterations, F &&f) {
+  std::vector<double> times;
+  for (int i = 0; i < iterations; ++i) {
+    const uint64_t start = nanos_since_boot();
+    f();
+    times.push_back((nanos_since_boot() - start) / 1e6);
+  }
+  std::sort(times.begin(), times.end());
+  double sum = 0;
+  for (double t : times) sum += t;
+  printf("%-16s avg %7.3f ms, p99 %7.3f ms\n", name, sum / times.size(), times[(size_t)(0.99 * (times.size() - 1))]);
+}
+
+// the legacy runners take the newest two frames as floats, shifted in place in their input buffer
+static void measure_float_output(cl_device_id device_id, cl_context context, cl_command_queue q, cl_mem yuv_cl,
+                                 const mat3 &proj, int iterations) {
+  const int width = 512, height = 256, frame_size = width * height * 3 / 2;
+  Transform transform;
+  LoadYUVState loadyuv;
+  transform_init(&transform, context, device_id);
+  loadyuv_init(&loadyuv, context, device_id, width, height, true);
+  cl_mem y_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, width * height, NULL, &err));
+  cl_mem u_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (width / 2) * (height / 2), NULL, &err));
+  cl_mem v_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (width / 2) * (height / 2), NULL, &err));
+  cl_mem out_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, frame_size * 2 * sizeof(float), NULL, &err));
+  std::vector<float> out(frame_size * 2);
+
+  measure("driving float cl", iterations, [&]() {
+    transform_queue(&transform, q, yuv_cl, FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET,
+                    y_cl, u_cl, v_cl, width, height, proj);
+    copy_queue(&loadyuv, q, out_cl, out_cl, frame_size, 0, frame_size);
+    loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, out_cl, frame_size);
+    CL_CHECK(clEnqueueReadBuffer(q, out_cl, CL_TRUE, 0, out.size() * sizeof(float), out.data(), 0, nullptr, nullptr));
+  });
+
+  for (cl_mem m : {y_cl, u_cl, v_cl, out_cl}) CL_CHECK(clReleaseMemObject(m));
+  loadyuv_destroy(&loadyuv);
+  transform_destroy(&transform);
+}
+
+static int compare(const char *name, const uint8_t *a, const uint8_t *b, int size) {
+  int mismatches = 0;
+  for (int i = 0; i < size; ++i) {
+    if (a[i] != b[i] && mismatches++ == 0) {
+      printf("%s: first mismatch at %d, %d != %d\n", name, i, a[i], b[i]);
+    }
+  }
+  return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = 200;
+  bool use_cl = false, verify = false;
+  const option opts[] = {
+    {"iterations", required_argument, nullptr, 'n'},
+    {"cl", no_argument, nullptr, 'c'},
+    {"verify", no_argument, nullptr, 'v'},
+    {nullptr, 0, nullptr, 0},
+  };
+  for (int opt; (opt = getopt_long(argc, argv, "", opts, nullptr)) != -1;) {
+    switch (opt) {
+      case 'n': iterations = std::max(atoi(optarg), 1); break;
+      case 'c': use_cl = true; break;
+      case 'v': use_cl = verify = true; break;
+      default:
+        fprintf(stderr, "usage: %s [--iterations N] [--cl] [--verify]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  std::mt19937 gen(0);
+  std::vector<uint8_t> yuv(FRAME_SIZE);
+  std::uniform_int_distribution<int> noise(0, 40);
+  for (int r = 0; r < FRAME_HEIGHT * 3 / 2; ++r) {
+    for (int c = 0; c < FRAME_STRIDE; ++c) {
+      yuv[r * FRAME_STRIDE + c] = (r + c) % 216 + noise(gen);
+    }
+  }
+
+  DrivingModelFrame driving_cpu(nullptr, nullptr, 4);
+  DrivingModelFrame driving_skip1_cpu(nullptr, nullptr, 1);
+  DrivingModelFrame driving_unfused_cpu(nullptr, nullptr, 4);
+  driving_cpu.fused = driving_skip1_cpu.fused = true;
+  driving_unfused_cpu.fused = false;
+  MonitoringModelFrame monitoring_cpu(nullptr, nullptr);
+  const mat3 driving_proj = projection(driving_cpu.MODEL_WIDTH, driving_cpu.MODEL_HEIGHT, 2.0f, gen, 0.0f);
+  const mat3 monitoring_proj = projection(monitoring_cpu.MODEL_WIDTH, monitoring_cpu.MODEL_HEIGHT, 1.25f, gen, 0.0f);
+
+  printf("%dx%d frame, %d iterations\n", FRAME_WIDTH, FRAME_HEIGHT, iterations);
+  measure("driving cpu", iterations, [&]() {
+    driving_cpu.prepare_cpu(yuv.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, driving_proj);
+  });
+  measure("driving/1 cpu", iterations, [&]() {
+    driving_skip1_cpu.prepare_cpu(yuv.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, driving_proj);
+  });
+  measure("unfused cpu", iterations, [&]() {
+    driving_unfused_cpu.prepare_cpu(yuv.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, driving_proj);
+  });
+  measure("monitoring cpu", iterations, [&]() {
+    monitoring_cpu.prepare_cpu(yuv.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, monitoring_proj);
+  });
+  if (!use_cl) return 0;
+
+  cl_device_id device_id = cl_get_device_id(CL_DEVICE_TYPE_DEFAULT);
+  cl_context context = cl_create_context(device_id);
+  cl_command_queue q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
+  cl_mem yuv_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, FRAME_SIZE, yuv.data(), &err));
+  int mismatches = 0;
+  {
+    DrivingModelFrame driving_cl(device_id, context, 4);
+    DrivingModelFrame driving_skip1_cl(device_id, context, 1);
+    DrivingModelFrame driving_unfused_cl(device_id, context, 4);
+    driving_cl.fused = driving_skip1_cl.fused = true;
+    driving_unfused_cl.fused = false;
+    MonitoringModelFrame monitoring_cl(device_id, context);
+    if (driving_cl.cpu) {
+      fprintf(stderr, "MODELD_CPU_PREP is set, unset it to run the OpenCL path\n");
+      return 1;
+    }
+
+    measure("driving cl", iterations, [&]() {
+      driving_cl.buffer_from_cl(driving_cl.prepare(yuv_cl, FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, driving_proj), driving_cl.buf_size);
+    });
+    measure("driving/1 cl", iterations, [&]() {
+      driving_skip1_cl.buffer_from_cl(driving_skip1_cl.prepare(yuv_cl, FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, driving_proj), driving_skip1_cl.buf_size);
+    });
+    measure("unfused cl", iterations, [&]() {
+      driving_unfused_cl.buffer_from_cl(driving_unfused_cl.prepare(yuv_cl, FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, driving_proj), driving_unfused_cl.buf_size);
+    });
+    measure("monitoring cl", iterations, [&]() {
+      monitoring_cl.buffer_from_cl(monitoring_cl.prepare(yuv_cl, FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, monitoring_proj), monitoring_cl.buf_size);
+    });
+    measure_float_output(device_id, context, q, yuv_cl, driving_proj, iterations);
+
+    // the driving frames also check the temporal buffer, both sides have seen the same frames so far
+    for (int i = 0; verify && i < iterations; ++i) {
+      const mat3 proj = projection(driving_cl.MODEL_WIDTH, driving_cl.MODEL_HEIGHT, 2.0f, gen, 1.0f);
+      std::uniform_int_distribution<int> pixel(0, FRAME_SIZE - 1);
+      yuv[pixel(gen)] = gen();
+      CL_CHECK(clEnqueueWriteBuffer(q, yuv_cl, CL_TRUE, 0, FRAME_SIZE, yuv.data(), 0, nullptr, nullptr));
+
+      uint8_t *fused = driving_cl.buffer_from_cl(driving_cl.prepare(yuv_cl, FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, proj), driving_cl.buf_size);
+      uint8_t *unfused = driving_unfused_cl.buffer_from_cl(driving_unfused_cl.prepare(yuv_cl, FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, proj), driving_unfused_cl.buf_size);
+      mismatches += compare("driving fused cl vs unfused cl", fused, unfused, driving_cl.buf_size);
+      uint8_t *ref = driving_cpu.prepare_cpu(yuv.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, proj);
+      mismatches += compare("driving fused cl vs cpu", fused, ref, driving_cl.buf_size);
+      mismatches += compare("driving unfused cl vs cpu", unfused, ref, driving_cl.buf_size);
+      uint8_t *a = driving_unfused_cpu.prepare_cpu(yuv.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, proj);
+      mismatches += compare("driving unfused cpu vs fused cpu", a, ref, driving_cl.buf_size);
+
+      const mat3 mproj = projection(monitoring_cl.MODEL_WIDTH, monitoring_cl.MODEL_HEIGHT, 1.25f, gen, 1.0f);
+      a = monitoring_cl.buffer_from_cl(monitoring_cl.prepare(yuv_cl, FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, mproj), monitoring_cl.buf_size);
+      uint8_t *b = monitoring_cpu.prepare_cpu(yuv.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_STRIDE, FRAME_UV_OFFSET, mproj);
+      mismatches += compare("monitoring cl vs cpu", a, b, monitoring_cl.buf_size);
+    }
+  }
+  CL_CHECK(clReleaseMemObject(yuv_cl));
+  CL_CHECK(clReleaseCommandQueue(q));
+  cl_release_context(context);
+
+  if (verify) {
+    printf("%d mismatched bytes over %d projections\n", mismatches, iterations);
+  }
+  return mismatches > 0;
+}
@@ -4,7 +4,7 @@
 #include <cstdio>
 #include <cstring>
 
-void loadyuv_init(LoadYUVState* s, cl_context ctx, cl_device_id device_id, int width, int height) {
+void loadyuv_init(LoadYUVState* s, cl_context ctx, cl_device_id device_id, int width, int height, bool float_output) {
   memset(s, 0, sizeof(*s));
 
   s->width = width;
@@ -13,8 +13,8 @@ void loadyuv_init(LoadYUVState* s, cl_context ctx, cl_device_id device_id, int w
   char args[1024];
   snprintf(args, sizeof(args),
            "-cl-fast-relaxed-math -cl-denorms-are-zero "
-           "-DTRANSFORMED_WIDTH=%d -DTRANSFORMED_HEIGHT=%d",
-           width, height);
+           "-DTRANSFORMED_WIDTH=%d -DTRANSFORMED_HEIGHT=%d%s",
+           width, height, float_output ? " -DOUTPUT_FLOAT" : "");
   cl_program prg = cl_program_from_file(ctx, device_id, LOADYUV_PATH, args);
 
   s->loadys_krnl = CL_CHECK_ERR(clCreateKernel(prg, "loadys", &err));
@@ -33,8 +33,8 @@ void loadyuv_destroy(LoadYUVState* s) {
 
 void loadyuv_queue(LoadYUVState* s, cl_command_queue q,
                    cl_mem y_cl, cl_mem u_cl, cl_mem v_cl,
-                   cl_mem out_cl) {
-  cl_int global_out_off = 0;
+                   cl_mem out_cl, int out_offset) {
+  cl_int global_out_off = out_offset;
 
   CL_CHECK(clSetKernelArg(s->loadys_krnl, 0, sizeof(cl_mem), &y_cl));
   CL_CHECK(clSetKernelArg(s->loadys_krnl, 1, sizeof(cl_mem), &out_cl));
@@ -68,9 +68,10 @@ void copy_queue(LoadYUVState* s, cl_command_queue q, cl_mem src, cl_mem dst,
                  size_t src_offset, size_t dst_offset, size_t size) {
   CL_CHECK(clSetKernelArg(s->copy_krnl, 0, sizeof(cl_mem), &src));
   CL_CHECK(clSetKernelArg(s->copy_krnl, 1, sizeof(cl_mem), &dst));
-  CL_CHECK(clSetKernelArg(s->copy_krnl, 2, sizeof(cl_int), &src_offset));
-  CL_CHECK(clSetKernelArg(s->copy_krnl, 3, sizeof(cl_int), &dst_offset));
+  const cl_int src_off = src_offset, dst_off = dst_offset;
+  CL_CHECK(clSetKernelArg(s->copy_krnl, 2, sizeof(cl_int), &src_off));
+  CL_CHECK(clSetKernelArg(s->copy_krnl, 3, sizeof(cl_int), &dst_off));
   const size_t copy_work_size = size/8;
   CL_CHECK(clEnqueueNDRangeKernel(q, s->copy_krnl, 1, NULL,
                               &copy_work_size, NULL, 0, 0, NULL));
-}
\ No newline at end of file
+}
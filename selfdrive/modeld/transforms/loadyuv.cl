@@ -1,7 +1,20 @@
 #define UV_SIZE ((TRANSFORMED_WIDTH/2)*(TRANSFORMED_HEIGHT/2))
 
+// the output is uchar, or float with -DOUTPUT_FLOAT, offsets are in output elements
+#ifdef OUTPUT_FLOAT
+#define OUT_T float
+#define OUT_T8 float8
+#define CONVERT_OUT4(v) convert_float4(v)
+#define CONVERT_OUT8(v) convert_float8(v)
+#else
+#define OUT_T uchar
+#define OUT_T8 uchar8
+#define CONVERT_OUT4(v) (v)
+#define CONVERT_OUT8(v) (v)
+#endif
+
 __kernel void loadys(__global uchar8 const * const Y,
-                     __global uchar * out,
+                     __global OUT_T * out,
                      int out_offset)
 {
     const int gid = get_global_id(0);
@@ -14,8 +27,8 @@ __kernel void loadys(__global uchar8 const * const Y,
     // 02
     // 13
 
-    __global uchar* outy0;
-    __global uchar* outy1;
+    __global OUT_T* outy0;
+    __global OUT_T* outy1;
     if ((oy & 1) == 0) {
       outy0 = out + out_offset; //y0
       outy1 = out + out_offset + UV_SIZE*2; //y2
@@ -24,21 +37,21 @@ __kernel void loadys(__global uchar8 const * const Y,
       outy1 = out + out_offset + UV_SIZE*3; //y3
     }
 
-    vstore4(ys.s0246, 0, outy0 + (oy/2) * (TRANSFORMED_WIDTH/2) + ox/2);
-    vstore4(ys.s1357, 0, outy1 + (oy/2) * (TRANSFORMED_WIDTH/2) + ox/2);
+    vstore4(CONVERT_OUT4(ys.s0246), 0, outy0 + (oy/2) * (TRANSFORMED_WIDTH/2) + ox/2);
+    vstore4(CONVERT_OUT4(ys.s1357), 0, outy1 + (oy/2) * (TRANSFORMED_WIDTH/2) + ox/2);
 }
 
 __kernel void loaduv(__global uchar8 const * const in,
-                     __global uchar8 * out,
+                     __global OUT_T8 * out,
                      int out_offset)
 {
   const int gid = get_global_id(0);
   const uchar8 inv = in[gid];
-  out[gid + out_offset / 8] = inv;
+  out[gid + out_offset / 8] = CONVERT_OUT8(inv);
 }
 
-__kernel void copy(__global uchar8 * in,
-                   __global uchar8 * out,
+__kernel void copy(__global OUT_T8 * in,
+                   __global OUT_T8 * out,
                    int in_offset,
                    int out_offset)
 {
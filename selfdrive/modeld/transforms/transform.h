@@ -10,7 +10,7 @@
 #include "common/mat.h"
 
 typedef struct {
-  cl_kernel krnl;
+  cl_kernel krnl, packed_krnl;
   cl_mem m_y_cl, m_uv_cl;
 } Transform;
 
@@ -23,3 +23,10 @@ void transform_queue(Transform* s, cl_command_queue q,
                      cl_mem out_y, cl_mem out_u, cl_mem out_v,
                      int out_width, int out_height,
                      const mat3& projection);
+
+// warps straight into the layout loadyuv_queue writes, at out_offset bytes into out
+void transform_packed_queue(Transform* s, cl_command_queue q,
+                            cl_mem yuv, int in_width, int in_height, int in_stride, int in_uv_offset,
+                            cl_mem out, int out_offset,
+                            int out_width, int out_height,
+                            const mat3& projection);
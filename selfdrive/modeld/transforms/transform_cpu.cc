@@ -0,0 +1,207 @@
+#include "selfdrive/modeld/transforms/transform_cpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+// the kernel does separate float multiplies and adds, fusing them would change the rounding
+#pragma STDC FP_CONTRACT OFF
+
+#define INTER_BITS 5
+#define INTER_TAB_SIZE (1 << INTER_BITS)
+
+#define INTER_REMAP_COEF_BITS 15
+#define INTER_REMAP_COEF_SCALE (1 << INTER_REMAP_COEF_BITS)
+
+namespace {
+
+inline int saturate_short(int v) {
+  return std::clamp(v, -32768, 32767);
+}
+
+// the kernel's bilinear weights for every subpixel position. all the products are exact in
+// float, so a table gives the same integers as computing them per pixel. they are saturated
+// to short like in the kernel, so they fit the 16 bit lanes of the blend
+struct InterTab {
+  int16_t coeffs[INTER_TAB_SIZE * INTER_TAB_SIZE][4];
+
+  InterTab() {
+    for (int ay = 0; ay < INTER_TAB_SIZE; ++ay) {
+      for (int ax = 0; ax < INTER_TAB_SIZE; ++ax) {
+        float taby = 1.f / INTER_TAB_SIZE * ay;
+        float tabx = 1.f / INTER_TAB_SIZE * ax;
+        int16_t *c = coeffs[ay * INTER_TAB_SIZE + ax];
+        c[0] = saturate_short(lrintf((1.0f - taby) * (1.0f - tabx) * INTER_REMAP_COEF_SCALE));
+        c[1] = saturate_short(lrintf((1.0f - taby) * tabx * INTER_REMAP_COEF_SCALE));
+        c[2] = saturate_short(lrintf(taby * (1.0f - tabx) * INTER_REMAP_COEF_SCALE));
+        c[3] = saturate_short(lrintf(taby * tabx * INTER_REMAP_COEF_SCALE));
+      }
+    }
+  }
+};
+
+const InterTab inter_tab;
+
+inline uint8_t blend_pixel(const int16_t *v, const int16_t *c) {
+  const int val = v[0] * c[0] + v[1] * c[1] + v[2] * c[2] + v[3] * c[3];
+  return std::clamp((val + (1 << (INTER_REMAP_COEF_BITS - 1))) >> INTER_REMAP_COEF_BITS, 0, 255);
+}
+
+// Blends n pixels from their four source samples and weights, 4 int16 each per pixel. The
+// products and sums are exact in 32 bits, so this gives the same bytes as blend_pixel.
+void blend_row(const int16_t *v, const int16_t *c, uint8_t *dst, int n) {
+  int x = 0;
+#if defined(__aarch64__)
+  for (; x + 8 <= n; x += 8) {
+    int32x4_t sums[2];
+    for (int h = 0; h < 2; ++h) {
+      // two pixels per vector, pairwise adds reduce the four products of each pixel
+      const int16_t *vp = v + (x + h * 4) * 4, *cp = c + (x + h * 4) * 4;
+      int16x8_t v01 = vld1q_s16(vp), v23 = vld1q_s16(vp + 8);
+      int16x8_t c01 = vld1q_s16(cp), c23 = vld1q_s16(cp + 8);
+      int32x4_t p01 = vpaddq_s32(vmull_s16(vget_low_s16(v01), vget_low_s16(c01)), vmull_high_s16(v01, c01));
+      int32x4_t p23 = vpaddq_s32(vmull_s16(vget_low_s16(v23), vget_low_s16(c23)), vmull_high_s16(v23, c23));
+      sums[h] = vrshrq_n_s32(vpaddq_s32(p01, p23), INTER_REMAP_COEF_BITS);
+    }
+    vst1_u8(dst + x, vqmovun_s16(vcombine_s16(vqmovn_s32(sums[0]), vqmovn_s32(sums[1]))));
+  }
+#elif defined(__x86_64__)
+  const __m128i round = _mm_set1_epi32(1 << (INTER_REMAP_COEF_BITS - 1));
+  for (; x + 8 <= n; x += 8) {
+    __m128i sums[2];
+    for (int h = 0; h < 2; ++h) {
+      // madd gives the two partial sums of two pixels per vector, the shuffles add them up
+      const int16_t *vp = v + (x + h * 4) * 4, *cp = c + (x + h * 4) * 4;
+      __m128 p01 = _mm_castsi128_ps(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)vp), _mm_loadu_si128((const __m128i *)cp)));
+      __m128 p23 = _mm_castsi128_ps(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)(vp + 8)), _mm_loadu_si128((const __m128i *)(cp + 8))));
+      __m128i even = _mm_castps_si128(_mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0)));
+      __m128i odd = _mm_castps_si128(_mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1)));
+      sums[h] = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), round), INTER_REMAP_COEF_BITS);
+    }
+    __m128i packed = _mm_packs_epi32(sums[0], sums[1]);
+    _mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(packed, packed));
+  }
+#endif
+  for (; x < n; ++x) {
+    dst[x] = blend_pixel(v + x * 4, c + x * 4);
+  }
+}
+
+// one row of the warp, the same math as warp_pixel in transform.cl
+void warp_row_cpu(const uint8_t *src, int src_row_stride, int src_px_stride, int src_offset, int src_rows, int src_cols,
+                  uint8_t *dst_row, int dy, int dst_cols, const float *M) {
+  thread_local std::vector<int32_t> xs, ys;
+  thread_local std::vector<int16_t> samples, weights;
+  xs.resize(dst_cols);
+  ys.resize(dst_cols);
+  samples.resize(dst_cols * 4);
+  weights.resize(dst_cols * 4);
+
+  // source coordinates of the row in INTER_BITS fixed point. no dependencies between
+  // pixels, so the compiler can vectorize this part
+  for (int dx = 0; dx < dst_cols; ++dx) {
+    float X0 = M[0] * dx + M[1] * dy + M[2];
+    float Y0 = M[3] * dx + M[4] * dy + M[5];
+    float W = M[6] * dx + M[7] * dy + M[8];
+    W = W != 0.0f ? INTER_TAB_SIZE / W : 0.0f;
+    xs[dx] = (int32_t)rintf(X0 * W);
+    ys[dx] = (int32_t)rintf(Y0 * W);
+  }
+
+  // the gather stays scalar, neither target has a byte gather
+  for (int dx = 0; dx < dst_cols; ++dx) {
+    const int X = xs[dx], Y = ys[dx];
+    const int sx = saturate_short(X >> INTER_BITS);
+    const int sy = saturate_short(Y >> INTER_BITS);
+
+    const int sx_clamp = std::clamp(sx, 0, src_cols - 1);
+    const int sx_p1_clamp = std::clamp(sx + 1, 0, src_cols - 1);
+    const int sy_clamp = std::clamp(sy, 0, src_rows - 1);
+    const int sy_p1_clamp = std::clamp(sy + 1, 0, src_rows - 1);
+    const uint8_t *row0 = src + sy_clamp * src_row_stride + src_offset;
+    const uint8_t *row1 = src + sy_p1_clamp * src_row_stride + src_offset;
+    int16_t *v = &samples[dx * 4];
+    v[0] = row0[sx_clamp * src_px_stride];
+    v[1] = row0[sx_p1_clamp * src_px_stride];
+    v[2] = row1[sx_clamp * src_px_stride];
+    v[3] = row1[sx_p1_clamp * src_px_stride];
+    memcpy(&weights[dx * 4], inter_tab.coeffs[(Y & (INTER_TAB_SIZE - 1)) * INTER_TAB_SIZE + (X & (INTER_TAB_SIZE - 1))], sizeof(int16_t) * 4);
+  }
+
+  blend_row(samples.data(), weights.data(), dst_row, dst_cols);
+}
+
+}  // namespace
+
+void warp_perspective_cpu(const uint8_t *src, int src_row_stride, int src_px_stride, int src_offset, int src_rows, int src_cols,
+                          uint8_t *dst, int dst_row_stride, int dst_offset, int dst_rows, int dst_cols,
+                          const mat3 &projection) {
+  for (int dy = 0; dy < dst_rows; ++dy) {
+    warp_row_cpu(src, src_row_stride, src_px_stride, src_offset, src_rows, src_cols,
+                 dst + dy * dst_row_stride + dst_offset, dy, dst_cols, projection.v);
+  }
+}
+
+void transform_cpu(const uint8_t *yuv, int in_width, int in_height, int in_stride, int in_uv_offset,
+                   uint8_t *out_y, uint8_t *out_u, uint8_t *out_v,
+                   int out_width, int out_height,
+                   const mat3 &projection) {
+  // in and out uv is half the size of y.
+  const mat3 projection_uv = transform_scale_buffer(projection, 0.5);
+
+  warp_perspective_cpu(yuv, in_stride, 1, 0, in_height, in_width,
+                       out_y, out_width, 0, out_height, out_width, projection);
+  warp_perspective_cpu(yuv, in_stride, 2, in_uv_offset, in_height / 2, in_width / 2,
+                       out_u, out_width / 2, 0, out_height / 2, out_width / 2, projection_uv);
+  warp_perspective_cpu(yuv, in_stride, 2, in_uv_offset + 1, in_height / 2, in_width / 2,
+                       out_v, out_width / 2, 0, out_height / 2, out_width / 2, projection_uv);
+}
+
+void loadyuv_cpu(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *out, int width, int height) {
+  const int uv_size = (width / 2) * (height / 2);
+
+  // the Y plane is split into 4 half resolution planes, the even/odd columns of the
+  // even rows go to planes 0 and 2, of the odd rows to planes 1 and 3
+  for (int row = 0; row < height; ++row) {
+    const uint8_t *in = y + row * width;
+    uint8_t *even_cols = out + (row & 1) * uv_size + (row / 2) * (width / 2);
+    uint8_t *odd_cols = even_cols + uv_size * 2;
+    for (int x = 0; x < width / 2; ++x) {
+      even_cols[x] = in[2 * x];
+      odd_cols[x] = in[2 * x + 1];
+    }
+  }
+  memcpy(out + width * height, u, uv_size);
+  memcpy(out + width * height + uv_size, v, uv_size);
+}
+
+void transform_packed_cpu(const uint8_t *yuv, int in_width, int in_height, int in_stride, int in_uv_offset,
+                          uint8_t *out, int out_width, int out_height,
+                          const mat3 &projection) {
+  const int uv_size = (out_width / 2) * (out_height / 2);
+  const mat3 projection_uv = transform_scale_buffer(projection, 0.5);
+
+  // each Y row is warped into a scratch row that stays in cache and split by column parity from there
+  thread_local std::vector<uint8_t> row;
+  row.resize(out_width);
+  for (int dy = 0; dy < out_height; ++dy) {
+    warp_row_cpu(yuv, in_stride, 1, 0, in_height, in_width, row.data(), dy, out_width, projection.v);
+    uint8_t *even_cols = out + (dy & 1) * uv_size + (dy / 2) * (out_width / 2);
+    uint8_t *odd_cols = even_cols + uv_size * 2;
+    for (int x = 0; x < out_width / 2; ++x) {
+      even_cols[x] = row[2 * x];
+      odd_cols[x] = row[2 * x + 1];
+    }
+  }
+  warp_perspective_cpu(yuv, in_stride, 2, in_uv_offset, in_height / 2, in_width / 2,
+                       out + uv_size * 4, out_width / 2, 0, out_height / 2, out_width / 2, projection_uv);
+  warp_perspective_cpu(yuv, in_stride, 2, in_uv_offset + 1, in_height / 2, in_width / 2,
+                       out + uv_size * 5, out_width / 2, 0, out_height / 2, out_width / 2, projection_uv);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/mat.h"
+
+// CPU versions of the transform.cl and loadyuv.cl kernels, bit-exact with them.
+// They let frame prep run without an OpenCL device and serve as a reference for the kernels.
+
+void warp_perspective_cpu(const uint8_t *src, int src_row_stride, int src_px_stride, int src_offset, int src_rows, int src_cols,
+                          uint8_t *dst, int dst_row_stride, int dst_offset, int dst_rows, int dst_cols,
+                          const mat3 &M);
+
+// same planes as transform_queue
+void transform_cpu(const uint8_t *yuv, int in_width, int in_height, int in_stride, int in_uv_offset,
+                   uint8_t *out_y, uint8_t *out_u, uint8_t *out_v,
+                   int out_width, int out_height,
+                   const mat3 &projection);
+
+// same layout as loadyuv_queue
+void loadyuv_cpu(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *out, int width, int height);
+
+// same as transform_packed_queue, equal to transform_cpu followed by loadyuv_cpu
+void transform_packed_cpu(const uint8_t *yuv, int in_width, int in_height, int in_stride, int in_uv_offset,
+                          uint8_t *out, int out_width, int out_height,
+                          const mat3 &projection);
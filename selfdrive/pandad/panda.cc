@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "cereal/messaging/messaging.h"
@@ -12,20 +13,26 @@
 
 const bool PANDAD_MAXOUT = getenv("PANDAD_MAXOUT") != nullptr;
 
-Panda::Panda(std::string serial, uint32_t bus_offset) : bus_offset(bus_offset) {
+static std::unique_ptr<PandaCommsHandle> open_handle(const std::string &serial) {
   // try USB first, then SPI
   try {
-    handle = std::make_unique<PandaUsbHandle>(serial);
+    auto handle = std::make_unique<PandaUsbHandle>(serial);
     LOGW("connected to %s over USB", serial.c_str());
+    return handle;
   } catch (std::exception &e) {
 #ifndef __APPLE__
-    handle = std::make_unique<PandaSpiHandle>(serial);
+    auto handle = std::make_unique<PandaSpiHandle>(serial);
     LOGW("connected to %s over SPI", serial.c_str());
+    return handle;
 #else
     throw e;
 #endif
   }
+}
+
+Panda::Panda(std::string serial, uint32_t bus_offset) : Panda(open_handle(serial), bus_offset) {}
 
+Panda::Panda(std::unique_ptr<PandaCommsHandle> comms_handle, uint32_t bus_offset) : handle(std::move(comms_handle)), bus_offset(bus_offset) {
   hw_type = get_hw_type();
   can_reset_communications();
 }
@@ -38,7 +45,7 @@ bool Panda::comms_healthy() {
   return handle->comms_healthy;
 }
 
-std::string Panda::hw_serial() {
+const std::string &Panda::hw_serial() {
   return handle->hw_serial;
 }
 
@@ -240,6 +247,7 @@ bool Panda::can_receive(std::vector<can_frame>& out_vec) {
   assert(receive_buffer_size + RECV_SIZE <= sizeof(receive_buffer));
 
   int recv = handle->bulk_read(0x81, &receive_buffer[receive_buffer_size], RECV_SIZE);
+  can_rx_full = (recv == RECV_SIZE);
   if (!comms_healthy()) {
     return false;
   }
@@ -291,7 +299,8 @@ bool Panda::unpack_can_buffer(uint8_t *data, uint32_t &size, std::vector<can_fra
       canData.src += CAN_RETURNED_BUS_OFFSET;
     }
 
-    canData.dat.assign((char *)&data[pos + sizeof(can_header)], data_len);
+    canData.dat_len = data_len;
+    memcpy(canData.dat, &data[pos + sizeof(can_header)], data_len);
 
     pos += sizeof(can_header) + data_len;
   }
@@ -303,6 +312,24 @@ bool Panda::unpack_can_buffer(uint8_t *data, uint32_t &size, std::vector<can_fra
   return true;
 }
 
+kj::ArrayPtr<capnp::byte> CanEventSerializer::serialize(const std::vector<can_frame> &frames, bool valid) {
+  MessageBuilder msg(segment.get());
+  auto canData = msg.initEvent(valid).initCan(frames.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    canData[i].setAddress(frames[i].address);
+    canData[i].setDat(kj::arrayPtr(frames[i].dat, frames[i].dat_len));
+    canData[i].setSrc(frames[i].src);
+  }
+  segment.fit(msg);
+
+  size_t size = msg.getSerializedSize();
+  if (buf.size() < size) {
+    buf = kj::heapArray<capnp::byte>(size + size / 4);
+  }
+  msg.serializeToBuffer(buf.begin(), buf.size());
+  return buf.slice(0, size);
+}
+
 uint8_t Panda::calculate_checksum(uint8_t *data, uint32_t len) {
   uint8_t checksum = 0U;
   for (uint32_t i = 0U; i < len; i++) {
@@ -11,6 +11,7 @@
 
 #include "cereal/gen/cpp/car.capnp.h"
 #include "cereal/gen/cpp/log.capnp.h"
+#include "cereal/messaging/messaging.h"
 #include "panda/board/health.h"
 #include "panda/board/can.h"
 #include "selfdrive/pandad/panda_comms.h"
@@ -25,6 +26,9 @@
 
 #define PANDA_BUS_OFFSET 4
 
+// upper bound of frames one can_receive call can unpack: a receive buffer full of empty frames
+#define CAN_FRAMES_MAX_PER_RECV ((RECV_SIZE + sizeof(can_header) + CANPACKET_DATA_SIZE_MAX) / sizeof(can_header))
+
 struct __attribute__((packed)) can_header {
   uint8_t reserved : 1;
   uint8_t bus : 3;
@@ -36,10 +40,23 @@ struct __attribute__((packed)) can_header {
   uint8_t checksum : 8;
 };
 
+// payload is stored inline, so filling a reserved vector of frames never allocates
 struct can_frame {
   long address;
-  std::string dat;
   long src;
+  uint8_t dat_len;
+  uint8_t dat[CANPACKET_DATA_SIZE_MAX];
+};
+
+// Serializes received frames into a "can" event. The capnp segment and the output
+// buffer are kept across calls and sized from the previous cycle.
+class CanEventSerializer {
+public:
+  kj::ArrayPtr<capnp::byte> serialize(const std::vector<can_frame> &frames, bool valid);
+
+private:
+  FirstSegment segment;
+  kj::Array<capnp::byte> buf;
 };
 
 
@@ -49,13 +66,14 @@ private:
 
 public:
   Panda(std::string serial="", uint32_t bus_offset=0);
+  Panda(std::unique_ptr<PandaCommsHandle> comms_handle, uint32_t bus_offset=0);
 
   cereal::PandaState::PandaType hw_type = cereal::PandaState::PandaType::UNKNOWN;
   const uint32_t bus_offset;
 
   bool connected();
   bool comms_healthy();
-  std::string hw_serial();
+  const std::string &hw_serial();
 
   // Static functions
   static std::vector<std::string> list(bool usb_only=false);
@@ -84,12 +102,15 @@ public:
   void set_canfd_non_iso(uint16_t bus, bool non_iso);
   void can_send(const capnp::List<cereal::CanData>::Reader &can_data_list);
   bool can_receive(std::vector<can_frame>& out_vec);
+  // the last read filled RECV_SIZE, more data is likely queued on the panda
+  inline bool can_rx_pending() const { return can_rx_full; }
   void can_reset_communications();
 
 protected:
   // for unit tests
-  uint8_t receive_buffer[RECV_SIZE + sizeof(can_header) + 64];
+  uint8_t receive_buffer[RECV_SIZE + sizeof(can_header) + CANPACKET_DATA_SIZE_MAX];
   uint32_t receive_buffer_size = 0;
+  bool can_rx_full = false;
 
   Panda(uint32_t bus_offset) : bus_offset(bus_offset) {}
   void pack_can_buffer(const capnp::List<cereal::CanData>::Reader &can_data_list,
@@ -114,15 +114,22 @@ void can_send_thread(std::vector<Panda *> pandas, bool fake_send) {
       continue;
     }
 
-    capnp::FlatArrayMessageReader cmsg(aligned_buf.align(msg.get()));
+    // read in place when the message is already word aligned, it outlives the reader
+    kj::ArrayPtr<const capnp::word> words;
+    if (reinterpret_cast<uintptr_t>(msg->getData()) % sizeof(capnp::word) == 0) {
+      words = kj::arrayPtr((const capnp::word *)msg->getData(), msg->getSize() / sizeof(capnp::word));
+    } else {
+      words = aligned_buf.align(msg.get());
+    }
+    capnp::FlatArrayMessageReader cmsg(words);
     cereal::Event::Reader event = cmsg.getRoot<cereal::Event>();
 
     // Don't send if older than 1 second
     if ((nanos_since_boot() - event.getLogMonoTime() < 1e9) && !fake_send) {
       for (const auto& panda : pandas) {
-        LOGT("sending sendcan to panda: %s", (panda->hw_serial()).c_str());
+        LOGT("sending sendcan to panda: %s", panda->hw_serial().c_str());
         panda->can_send(event.getSendcan());
-        LOGT("sendcan sent to panda: %s", (panda->hw_serial()).c_str());
+        LOGT("sendcan sent to panda: %s", panda->hw_serial().c_str());
       }
     } else {
       LOGE("sendcan too old to send: %" PRIu64 ", %" PRIu64, nanos_since_boot(), event.getLogMonoTime());
@@ -130,25 +137,49 @@ void can_send_thread(std::vector<Panda *> pandas, bool fake_send) {
   }
 }
 
-void can_recv(std::vector<Panda *> &pandas, PubMaster *pm) {
+CanRecvLatency can_recv_latency;
+
+bool can_recv(std::vector<Panda *> &pandas, PubMaster *pm) {
   static std::vector<can_frame> raw_can_data;
+  static CanEventSerializer serializer;
+  bool rx_pending = false;
   {
+    // only allocates on the first call, frames are stored inline
+    raw_can_data.reserve(pandas.size() * CAN_FRAMES_MAX_PER_RECV);
+
     bool comms_healthy = true;
     raw_can_data.clear();
     for (const auto& panda : pandas) {
       comms_healthy &= panda->can_receive(raw_can_data);
+      rx_pending |= panda->can_rx_pending();
     }
 
-    MessageBuilder msg;
-    auto evt = msg.initEvent();
-    evt.setValid(comms_healthy);
-    auto canData = evt.initCan(raw_can_data.size());
-    for (size_t i = 0; i < raw_can_data.size(); ++i) {
-      canData[i].setAddress(raw_can_data[i].address);
-      canData[i].setDat(kj::arrayPtr((uint8_t*)raw_can_data[i].dat.data(), raw_can_data[i].dat.size()));
-      canData[i].setSrc(raw_can_data[i].src);
+    auto bytes = serializer.serialize(raw_can_data, comms_healthy);
+    pm->send("can", bytes.begin(), bytes.size());
+  }
+  return rx_pending;
+}
+
+void can_recv_thread(std::vector<Panda *> pandas) {
+  util::set_thread_name("pandad_can_recv");
+  if (!Hardware::PC()) {
+    // above the main loop, so housekeeping never delays CAN publication
+    util::set_realtime_priority(55);
+  }
+
+  PubMaster pm({"can"});
+  RateKeeper rk("pandad_can_recv", 100);
+
+  while (!do_exit && check_all_connected(pandas)) {
+    uint64_t start = nanos_since_boot();
+    bool rx_pending = can_recv(pandas, &pm);
+    can_recv_latency.update(nanos_since_boot() - start);
+
+    // a full read means the pandas have more queued, so poll again right away
+    // instead of waiting for the next cycle. otherwise keep the nominal rate
+    if (!rx_pending) {
+      rk.keepTime();
     }
-    pm->send("can", msg);
   }
 }
 
@@ -286,6 +317,8 @@ std::optional<bool> send_panda_states(PubMaster *pm, const std::vector<Panda *>
 
     auto ps = pss[i];
     fill_panda_state(ps, panda->hw_type, health);
+    ps.setCanRecvLatencyAvgMs(can_recv_latency.avg_ms());
+    ps.setCanRecvLatencyMaxMs(can_recv_latency.max_ms());
 
     auto cs = std::array{ps.initCanState0(), ps.initCanState1(), ps.initCanState2()};
     for (uint32_t j = 0; j < PANDA_CAN_CNT; j++) {
@@ -441,13 +474,14 @@ void pandad_run(std::vector<Panda *> &pandas) {
   const bool spoofing_started = getenv("STARTED") != nullptr;
   const bool fake_send = getenv("FAKESEND") != nullptr;
 
-  // Start the CAN send thread
+  // Start the CAN threads
   std::thread send_thread(can_send_thread, pandas, fake_send);
+  std::thread recv_thread(can_recv_thread, pandas);
 
   Params params;
   RateKeeper rk("pandad", 100);
   SubMaster sm({"selfdriveState", "selfdriveStateSP", "carParams"});
-  PubMaster pm({"can", "pandaStates", "peripheralState"});
+  PubMaster pm({"pandaStates", "peripheralState"});
   PandaSafety panda_safety(pandas);
   Panda *peripheral_panda = pandas[0];
   bool engaged = false;
@@ -455,10 +489,8 @@ void pandad_run(std::vector<Panda *> &pandas) {
   bool is_onroad = false;
   bool always_offroad = false;
 
-  // Main loop: receive CAN data and process states
+  // Main loop: process states, CAN is received on its own thread
   while (!do_exit && check_all_connected(pandas)) {
-    can_recv(pandas, &pm);
-
     // Process peripheral state at 20 Hz
     if (rk.frame() % 5 == 0) {
       process_peripheral_state(peripheral_panda, &pm, no_fan_control);
@@ -506,6 +538,7 @@ void pandad_run(std::vector<Panda *> &pandas) {
   }
 
   send_thread.join();
+  recv_thread.join();
 }
 
 void pandad_main_thread(std::vector<std::string> serials) {
@@ -1,12 +1,49 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "cereal/messaging/messaging.h"
 #include "common/params.h"
+#include "common/util.h"
 #include "selfdrive/pandad/panda.h"
 
+extern ExitHandler do_exit;
+
 void pandad_main_thread(std::vector<std::string> serials);
+void can_send_thread(std::vector<Panda *> pandas, bool fake_send);
+void can_recv_thread(std::vector<Panda *> pandas);
+bool can_recv(std::vector<Panda *> &pandas, PubMaster *pm);
+std::optional<bool> send_panda_states(PubMaster *pm, const std::vector<Panda *> &pandas, bool is_onroad, bool spoofing_started, bool always_offroad);
+
+// Time from starting the bulk reads until "can" is published. can_recv_thread updates it every
+// cycle and pandaStates carries the average and max of the last WINDOW cycles.
+class CanRecvLatency {
+public:
+  void update(uint64_t ns) {
+    sum_ns += ns;
+    max_ns = std::max(max_ns, ns);
+    if (++cnt == WINDOW) {
+      avg_ms_ = sum_ns / cnt / 1e6;
+      max_ms_ = max_ns / 1e6;
+      cnt = sum_ns = max_ns = 0;
+    }
+  }
+  float avg_ms() const { return avg_ms_; }
+  float max_ms() const { return max_ms_; }
+
+  static constexpr uint64_t WINDOW = 100;
+
+private:
+  uint64_t cnt = 0, sum_ns = 0, max_ns = 0;
+  std::atomic<float> avg_ms_ = 0, max_ms_ = 0;
+};
+
+extern CanRecvLatency can_recv_latency;
 
 // deprecated devices
 static const std::vector<cereal::PandaState::PandaType> SUPPORTED_PANDA_TYPES = {
@@ -0,0 +1,181 @@
+// Drives pandad's CAN threads against simulated pandas and reports throughput,
+// sendcan -> can latency, checksum recovery and CPU time per frame.
+//
+// usage: bench_pandad [--pandas N] [--spi] [--fps FRAMES_PER_SEC] [--len BYTES] [--seconds S]
+//                     [--latency-us US] [--jitter-us US] [--read-size BYTES] [--corrupt PROB]
+
+#include <getopt.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "common/ratekeeper.h"
+#include "common/timing.h"
+#include "common/util.h"
+#include "selfdrive/pandad/pandad.h"
+#include "selfdrive/pandad/tests/panda_sim.h"
+
+struct BenchConfig {
+  int pandas = 1;
+  int fps = 3000;
+  int len = 8;
+  double seconds = 10;
+  PandaSimHandle::Config sim = {.loopback = true};
+};
+
+static double cpu_seconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void sendcan_thread(const BenchConfig &config, uint64_t *sent) {
+  PubMaster pm({"sendcan"});
+  RateKeeper rk("bench_sendcan", 100);
+  const int frames_per_msg = std::max(1, config.fps / 100);
+  const int buses = config.pandas * PANDA_BUS_OFFSET;
+  uint8_t dat[CANPACKET_DATA_SIZE_MAX] = {};
+
+  while (!do_exit) {
+    MessageBuilder msg;
+    auto can = msg.initEvent().initSendcan(frames_per_msg);
+    for (int i = 0; i < frames_per_msg; ++i) {
+      // the payload carries the send time, the receiver computes the latency from it
+      uint64_t ts = nanos_since_boot();
+      memcpy(dat, &ts, sizeof(ts));
+      can[i].setAddress(0x100 + i % 0x400);
+      can[i].setSrc((*sent + i) % buses);
+      can[i].setDat(kj::arrayPtr(dat, config.len));
+    }
+    pm.send("sendcan", msg);
+    *sent += frames_per_msg;
+    rk.keepTime();
+  }
+}
+
+static double percentile(std::vector<uint64_t> &v, double p) {
+  if (v.empty()) return 0;
+  size_t idx = std::min(v.size() - 1, (size_t)(p * v.size()));
+  std::nth_element(v.begin(), v.begin() + idx, v.end());
+  return v[idx] / 1e6;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [--pandas N] [--spi] [--fps FRAMES_PER_SEC] [--len BYTES] [--seconds S]\n"
+                  "       [--latency-us US] [--jitter-us US] [--read-size BYTES] [--corrupt PROB]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+  BenchConfig config;
+  const option opts[] = {
+    {"pandas", required_argument, nullptr, 'p'},
+    {"spi", no_argument, nullptr, 's'},
+    {"fps", required_argument, nullptr, 'f'},
+    {"len", required_argument, nullptr, 'l'},
+    {"seconds", required_argument, nullptr, 't'},
+    {"latency-us", required_argument, nullptr, 'L'},
+    {"jitter-us", required_argument, nullptr, 'J'},
+    {"read-size", required_argument, nullptr, 'r'},
+    {"corrupt", required_argument, nullptr, 'c'},
+    {nullptr, 0, nullptr, 0},
+  };
+  for (int opt; (opt = getopt_long(argc, argv, "", opts, nullptr)) != -1;) {
+    switch (opt) {
+      case 'p': config.pandas = std::clamp(atoi(optarg), 1, 3); break;
+      case 's': config.sim.transport = PandaSimHandle::Transport::SPI; break;
+      case 'f': config.fps = atoi(optarg); break;
+      case 'l': config.len = std::clamp(atoi(optarg), (int)sizeof(uint64_t), (int)CANPACKET_DATA_SIZE_MAX); break;
+      case 't': config.seconds = atof(optarg); break;
+      case 'L': config.sim.latency_us = atoi(optarg); break;
+      case 'J': config.sim.jitter_us = atoi(optarg); break;
+      case 'r': config.sim.max_read_size = std::clamp(atoi(optarg), 1, (int)RECV_SIZE); break;
+      case 'c': config.sim.corrupt_prob = atof(optarg); break;
+      default: usage(argv[0]); return 1;
+    }
+  }
+  // round up to a valid CAN FD length
+  config.len = *std::lower_bound(std::begin(dlc_to_len), std::end(dlc_to_len), config.len);
+
+  std::vector<PandaSimHandle *> sims;
+  std::vector<Panda *> pandas;
+  for (int i = 0; i < config.pandas; ++i) {
+    auto sim = new PandaSimHandle(config.sim, "sim" + std::to_string(i));
+    sims.push_back(sim);
+    pandas.push_back(new Panda(std::unique_ptr<PandaCommsHandle>(sim), i * PANDA_BUS_OFFSET));
+  }
+
+  std::unique_ptr<Context> context(Context::create());
+  std::unique_ptr<SubSocket> can_sock(SubSocket::create(context.get(), "can"));
+  assert(can_sock != nullptr);
+  can_sock->setTimeout(100);
+
+  std::thread send_thread(can_send_thread, pandas, false);
+  std::thread recv_thread(can_recv_thread, pandas);
+  util::sleep_for(100);
+
+  uint64_t sent = 0;
+  std::thread publisher(sendcan_thread, std::cref(config), &sent);
+
+  std::vector<uint64_t> latencies;
+  latencies.reserve(config.fps * config.seconds * 1.5);
+  uint64_t received = 0, invalid = 0;
+  AlignedBuffer aligned_buf;
+  const double cpu_start = cpu_seconds();
+  const uint64_t start = nanos_since_boot();
+  while (nanos_since_boot() - start < config.seconds * 1e9) {
+    std::unique_ptr<Message> msg(can_sock->receive());
+    if (!msg) continue;
+
+    const uint64_t now = nanos_since_boot();
+    capnp::FlatArrayMessageReader cmsg(aligned_buf.align(msg.get()));
+    auto event = cmsg.getRoot<cereal::Event>();
+    invalid += !event.getValid();
+    for (const auto &c : event.getCan()) {
+      uint64_t ts;
+      memcpy(&ts, c.getDat().begin(), sizeof(ts));
+      if (ts >= start) {
+        latencies.push_back(now - ts);
+      }
+      received++;
+    }
+  }
+  const double elapsed = (nanos_since_boot() - start) / 1e9;
+  const double cpu = cpu_seconds() - cpu_start;
+
+  do_exit = true;
+  publisher.join();
+  send_thread.join();
+  recv_thread.join();
+
+  PandaSimHandle::Stats total;
+  for (auto sim : sims) {
+    auto s = sim->stats();
+    total.tx_frames += s.tx_frames;
+    total.tx_checksum_errors += s.tx_checksum_errors;
+    total.corrupted_reads += s.corrupted_reads;
+    total.resets += s.resets - 1;  // one reset on connect
+    total.dropped_bytes += s.dropped_bytes;
+    total.transfers += s.transfers;
+  }
+
+  printf("pandas: %d, transport: %s, bus load: %d frames/s of %d bytes\n", config.pandas,
+         config.sim.transport == PandaSimHandle::Transport::SPI ? "spi" : "usb", config.fps, config.len);
+  printf("throughput:   %.0f frames/s (%lu sent, %lu written, %lu received)\n", received / elapsed, sent, total.tx_frames, received);
+  printf("latency:      p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 1.0));
+  printf("checksums:    %lu corrupted reads, %lu resets, %lu bytes dropped, %lu invalid can msgs, %lu tx errors\n",
+         total.corrupted_reads, total.resets, total.dropped_bytes, invalid, total.tx_checksum_errors);
+  printf("transfers:    %lu\n", total.transfers);
+  printf("cpu:          %.2f us/frame (whole process)\n", received > 0 ? cpu / received * 1e6 : 0.);
+
+  for (auto panda : pandas) {
+    delete panda;
+  }
+  return 0;
+}
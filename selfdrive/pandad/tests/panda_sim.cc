@@ -0,0 +1,164 @@
+#include "selfdrive/pandad/tests/panda_sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+static uint8_t sim_checksum(const uint8_t *data, uint32_t len) {
+  uint8_t checksum = 0U;
+  for (uint32_t i = 0U; i < len; i++) {
+    checksum ^= data[i];
+  }
+  return checksum;
+}
+
+static uint8_t sim_len_to_dlc(uint8_t len) {
+  for (uint8_t dlc = 0; dlc < std::size(dlc_to_len); ++dlc) {
+    if (dlc_to_len[dlc] >= len) return dlc;
+  }
+  return std::size(dlc_to_len) - 1;
+}
+
+PandaSimHandle::PandaSimHandle(const Config &config, const std::string &serial)
+    : PandaCommsHandle(serial), config(config), rng(std::random_device{}()) {
+  hw_serial = serial;
+}
+
+void PandaSimHandle::transfer_delay() {
+  uint32_t us = config.latency_us;
+  if (config.jitter_us > 0) {
+    us += std::uniform_int_distribution<uint32_t>(0, config.jitter_us)(rng);
+  }
+  if (us > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+}
+
+int PandaSimHandle::control_write(uint8_t request, uint16_t param1, uint16_t param2, unsigned int timeout) {
+  std::lock_guard lk(lock);
+  transfer_delay();
+  if (request == 0xc0) {
+    // can_reset_communications: the panda drops everything not yet read
+    stats_.resets++;
+    stats_.dropped_bytes += rx_queue.size();
+    rx_queue.clear();
+  }
+  return 0;
+}
+
+int PandaSimHandle::control_read(uint8_t request, uint16_t param1, uint16_t param2, unsigned char *data, uint16_t length, unsigned int timeout) {
+  std::lock_guard lk(lock);
+  transfer_delay();
+  memset(data, 0, length);
+  if (request == 0xc1 && length > 0) {
+    data[0] = (uint8_t)config.hw_type;
+    return 1;
+  }
+  // serial_read() reads until the port is empty
+  return request == 0xe0 ? 0 : length;
+}
+
+int PandaSimHandle::bulk_write(unsigned char endpoint, unsigned char *data, int length, unsigned int timeout) {
+  std::lock_guard lk(lock);
+  stats_.transfers++;
+  transfer_delay();
+  if (endpoint != 3) {
+    return length;
+  }
+
+  int pos = 0;
+  while (pos + (int)sizeof(can_header) <= length) {
+    can_header header;
+    memcpy(&header, &data[pos], sizeof(can_header));
+    const uint8_t data_len = dlc_to_len[header.data_len_code];
+    if (pos + sizeof(can_header) + data_len > length) {
+      break;
+    }
+
+    if (sim_checksum(&data[pos], sizeof(can_header) + data_len) != 0) {
+      stats_.tx_checksum_errors++;
+    } else {
+      stats_.tx_frames++;
+      const uint8_t *dat = &data[pos + sizeof(can_header)];
+      if (on_tx) {
+        on_tx(header.bus, header.addr, dat, data_len);
+      }
+      if (config.loopback) {
+        can_header rx_header = header;
+        rx_header.checksum = 0;
+        uint8_t buf[sizeof(can_header) + CANPACKET_DATA_SIZE_MAX];
+        memcpy(buf, &rx_header, sizeof(can_header));
+        memcpy(&buf[sizeof(can_header)], dat, data_len);
+        ((can_header *)buf)->checksum = sim_checksum(buf, sizeof(can_header) + data_len);
+        rx_queue.insert(rx_queue.end(), buf, &buf[sizeof(can_header) + data_len]);
+        stats_.rx_frames++;
+      }
+    }
+    pos += sizeof(can_header) + data_len;
+  }
+  return length;
+}
+
+int PandaSimHandle::bulk_read(unsigned char endpoint, unsigned char *data, int length, unsigned int timeout) {
+  std::lock_guard lk(lock);
+  if (endpoint != 0x81) {
+    transfer_delay();
+    return 0;
+  }
+
+  int ret = 0;
+  const int available = std::min<int>(rx_queue.size(), config.max_read_size);
+  if (config.transport == Transport::SPI) {
+    // same chunking as PandaSpiHandle::bulk_transfer, a short chunk ends the transfer
+    const int xfer_size = SPI_BUF_SIZE - 0x40;
+    while (true) {
+      int chunk = std::min({xfer_size, length - ret, available - ret});
+      stats_.transfers++;
+      transfer_delay();
+      ret += chunk;
+      if (chunk < xfer_size) break;
+    }
+  } else {
+    stats_.transfers++;
+    transfer_delay();
+    ret = std::min(length, available);
+  }
+
+  std::copy_n(rx_queue.begin(), ret, data);
+  rx_queue.erase(rx_queue.begin(), rx_queue.begin() + ret);
+  stats_.rx_bytes += ret;
+
+  if (ret > 0 && config.corrupt_prob > 0 && std::bernoulli_distribution(config.corrupt_prob)(rng)) {
+    // the last byte always belongs to a frame that gets checked, now or with the next read
+    data[ret - 1] ^= 0x01;
+    stats_.corrupted_reads++;
+  }
+  return ret;
+}
+
+void PandaSimHandle::queue_rx(uint8_t bus, uint32_t address, const uint8_t *dat, uint8_t len, bool returned) {
+  uint8_t data_len_code = sim_len_to_dlc(len);
+  uint8_t buf[sizeof(can_header) + CANPACKET_DATA_SIZE_MAX] = {};
+
+  can_header header = {};
+  header.addr = address;
+  header.extended = (address >= 0x800) ? 1 : 0;
+  header.data_len_code = data_len_code;
+  header.bus = bus;
+  header.returned = returned;
+  memcpy(buf, &header, sizeof(can_header));
+  memcpy(&buf[sizeof(can_header)], dat, len);
+
+  const uint32_t size = sizeof(can_header) + dlc_to_len[data_len_code];
+  ((can_header *)buf)->checksum = sim_checksum(buf, size);
+
+  std::lock_guard lk(lock);
+  rx_queue.insert(rx_queue.end(), buf, &buf[size]);
+  stats_.rx_frames++;
+}
+
+PandaSimHandle::Stats PandaSimHandle::stats() {
+  std::lock_guard lk(lock);
+  return stats_;
+}
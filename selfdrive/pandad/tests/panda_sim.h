@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include "selfdrive/pandad/panda.h"
+
+// In-process stand-in for a panda behind the USB or SPI bulk protocol.
+// Frames queued for RX are packed with their checksums and handed out in reads
+// limited to the requested length, so frames get split across reads like on a
+// real panda. Frames written to the CAN TX endpoint are checksum verified and
+// optionally looped back into RX.
+class PandaSimHandle : public PandaCommsHandle {
+public:
+  enum class Transport { USB, SPI };
+
+  struct Config {
+    Transport transport = Transport::USB;
+    cereal::PandaState::PandaType hw_type = cereal::PandaState::PandaType::RED_PANDA;
+    uint32_t latency_us = 0;  // per USB transfer or per SPI chunk
+    uint32_t jitter_us = 0;   // uniformly distributed extra latency
+    uint32_t max_read_size = RECV_SIZE;  // bytes the panda hands out per bulk read
+    bool loopback = false;
+    double corrupt_prob = 0;  // chance of flipping a bit in a bulk read
+  };
+
+  struct Stats {
+    uint64_t rx_frames = 0;
+    uint64_t rx_bytes = 0;
+    uint64_t tx_frames = 0;
+    uint64_t tx_checksum_errors = 0;
+    uint64_t corrupted_reads = 0;
+    uint64_t resets = 0;
+    uint64_t dropped_bytes = 0;
+    uint64_t transfers = 0;
+  };
+
+  PandaSimHandle(const Config &config, const std::string &serial = "sim");
+  ~PandaSimHandle() {}
+  void cleanup() override {}
+
+  int control_write(uint8_t request, uint16_t param1, uint16_t param2, unsigned int timeout=TIMEOUT) override;
+  int control_read(uint8_t request, uint16_t param1, uint16_t param2, unsigned char *data, uint16_t length, unsigned int timeout=TIMEOUT) override;
+  int bulk_write(unsigned char endpoint, unsigned char* data, int length, unsigned int timeout=TIMEOUT) override;
+  int bulk_read(unsigned char endpoint, unsigned char* data, int length, unsigned int timeout=TIMEOUT) override;
+
+  // queue a frame as if it was received on the panda's bus
+  void queue_rx(uint8_t bus, uint32_t address, const uint8_t *dat, uint8_t len, bool returned = false);
+  Stats stats();
+  void set_corrupt_prob(double prob) {
+    std::lock_guard lk(lock);
+    config.corrupt_prob = prob;
+  }
+
+  // called for every valid frame written to the CAN TX endpoint
+  std::function<void(uint8_t bus, uint32_t address, const uint8_t *dat, uint8_t len)> on_tx;
+
+private:
+  void transfer_delay();
+
+  Config config;
+  Stats stats_;
+  std::mutex lock;
+  std::deque<uint8_t> rx_queue;
+  std::mt19937 rng;
+};
@@ -3,14 +3,17 @@
 
 #include "catch2/catch.hpp"
 #include "cereal/messaging/messaging.h"
+#include "common/tests/alloc_counter.h"
 #include "common/util.h"
 #include "selfdrive/pandad/panda.h"
+#include "selfdrive/pandad/tests/panda_sim.h"
 
 struct PandaTest : public Panda {
   PandaTest(uint32_t bus_offset, int can_list_size, cereal::PandaState::PandaType hw_type);
   void test_can_send();
   void test_can_recv(uint32_t chunk_size = 0);
   void test_chunked_can_recv();
+  void test_can_recv_no_alloc();
 
   std::map<int, std::string> test_data;
   int can_list_size = 0;
@@ -96,9 +99,49 @@ void PandaTest::test_can_recv(uint32_t rx_chunk_size) {
   REQUIRE(frames.size() == can_list_size);
   for (int i = 0; i < frames.size(); ++i) {
     REQUIRE(frames[i].address == i);
-    REQUIRE(test_data.find(frames[i].dat.size()) != test_data.end());
-    const std::string &dat = test_data[frames[i].dat.size()];
-    REQUIRE(memcmp(dat.data(), frames[i].dat.data(), dat.size()) == 0);
+    REQUIRE(test_data.find(frames[i].dat_len) != test_data.end());
+    const std::string &dat = test_data[frames[i].dat_len];
+    REQUIRE(memcmp(dat.data(), frames[i].dat, dat.size()) == 0);
+  }
+}
+
+void PandaTest::test_can_recv_no_alloc() {
+  std::vector<uint8_t> packed;
+  this->pack_can_buffer(can_data_list, [&](uint8_t *data, size_t size) {
+    packed.insert(packed.end(), data, &data[size]);
+  });
+  REQUIRE(packed.size() <= RECV_SIZE);
+
+  std::vector<can_frame> frames;
+  frames.reserve(CAN_FRAMES_MAX_PER_RECV);
+  CanEventSerializer serializer;
+  kj::ArrayPtr<capnp::byte> bytes;
+  auto cycle = [&]() {
+    frames.clear();
+    memcpy(this->receive_buffer, packed.data(), packed.size());
+    this->receive_buffer_size = packed.size();
+    bool ret = this->unpack_can_buffer(this->receive_buffer, this->receive_buffer_size, frames);
+    bytes = serializer.serialize(frames, ret);
+  };
+
+  // the first cycles size the capnp segment and the output buffer
+  for (int i = 0; i < 3; ++i) cycle();
+
+  size_t allocs_before = alloc_count;
+  for (int i = 0; i < 100; ++i) cycle();
+  REQUIRE(alloc_count - allocs_before == 0);
+
+  AlignedBuffer aligned_buf;
+  capnp::FlatArrayMessageReader reader(aligned_buf.align((const char *)bytes.begin(), bytes.size()));
+  auto event = reader.getRoot<cereal::Event>();
+  REQUIRE(event.getValid());
+  auto can = event.getCan();
+  REQUIRE(can.size() == can_list_size);
+  for (int i = 0; i < can.size(); ++i) {
+    auto dat = can[i].getDat();
+    REQUIRE(can[i].getAddress() == i);
+    REQUIRE(can[i].getSrc() == can_data_list[i].getSrc());
+    REQUIRE(memcmp(dat.begin(), can_data_list[i].getDat().begin(), dat.size()) == 0);
   }
 }
 
@@ -133,3 +176,67 @@ TEST_CASE("send/recv CAN FD packets") {
     test.test_can_recv(0x40);
   }
 }
+
+TEST_CASE("recv CAN packets without allocating") {
+  auto can_list_size = GENERATE(1, 10, 100, 200);
+  auto hw_type = GENERATE(cereal::PandaState::PandaType::DOS, cereal::PandaState::PandaType::RED_PANDA);
+  PandaTest test(0, can_list_size, hw_type);
+  test.test_can_recv_no_alloc();
+}
+
+static std::vector<std::string> queue_sim_frames(PandaSimHandle *sim, int cnt) {
+  std::vector<std::string> sent;
+  for (int i = 0; i < cnt; ++i) {
+    std::string dat = util::random_string(dlc_to_len[util::random_int(0, std::size(dlc_to_len) - 1)]);
+    sim->queue_rx(i % PANDA_BUS_CNT, i, (const uint8_t *)dat.data(), dat.size());
+    sent.push_back(dat);
+  }
+  return sent;
+}
+
+TEST_CASE("recv CAN packets over simulated transports") {
+  PandaSimHandle::Config config;
+  config.transport = GENERATE(PandaSimHandle::Transport::USB, PandaSimHandle::Transport::SPI);
+  config.max_read_size = GENERATE(0x40U, 0x3ffU, RECV_SIZE);
+  auto bus_offset = GENERATE(0, 4);
+
+  auto sim = new PandaSimHandle(config);
+  Panda panda(std::unique_ptr<PandaCommsHandle>(sim), bus_offset);
+  REQUIRE(panda.hw_type == config.hw_type);
+
+  auto sent = queue_sim_frames(sim, 1000);
+  std::vector<can_frame> frames;
+  for (int i = 0; i < 1000 && frames.size() < sent.size(); ++i) {
+    REQUIRE(panda.can_receive(frames));
+  }
+
+  REQUIRE(frames.size() == sent.size());
+  for (int i = 0; i < frames.size(); ++i) {
+    REQUIRE(frames[i].address == i);
+    REQUIRE(frames[i].src == i % PANDA_BUS_CNT + bus_offset);
+    REQUIRE(frames[i].dat_len == sent[i].size());
+    REQUIRE(memcmp(frames[i].dat, sent[i].data(), sent[i].size()) == 0);
+  }
+}
+
+TEST_CASE("recover from corrupted CAN reads") {
+  PandaSimHandle::Config config;
+  config.corrupt_prob = 1.0;
+  auto sim = new PandaSimHandle(config);
+  Panda panda(std::unique_ptr<PandaCommsHandle>(sim), 0);
+
+  std::vector<can_frame> frames;
+  queue_sim_frames(sim, 100);
+  REQUIRE_FALSE(panda.can_receive(frames));
+  REQUIRE(sim->stats().resets == 2);  // one on connect, one for the checksum failure
+
+  // the panda dropped its queue, communication recovers once reads are clean again
+  sim->set_corrupt_prob(0);
+  auto sent = queue_sim_frames(sim, 100);
+  frames.clear();
+  REQUIRE(panda.can_receive(frames));
+  REQUIRE(frames.size() == sent.size());
+  for (int i = 0; i < frames.size(); ++i) {
+    REQUIRE(memcmp(frames[i].dat, sent[i].data(), sent[i].size()) == 0);
+  }
+}
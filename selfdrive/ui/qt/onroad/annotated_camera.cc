@@ -6,6 +6,7 @@
 #include <cmath>
 
 #include "common/swaglog.h"
+#include "selfdrive/ui/qt/profiler.h"
 #include "selfdrive/ui/qt/util.h"
 
 // Window that shows camera view and variety of info drawn on top
@@ -88,6 +89,7 @@ mat4 AnnotatedCameraWidget::calcFrameMatrix() {
 }
 
 void AnnotatedCameraWidget::paintGL() {
+  UIProfileScope profile(UIProfiler::ONROAD_PAINT);
   UIState *s = uiState();
   SubMaster &sm = *(s->sm);
   const double start_draw_t = millis_since_boot();
@@ -122,17 +124,27 @@ void AnnotatedCameraWidget::paintGL() {
     }
     CameraWidget::setStreamType(wide_cam_requested ? VISION_STREAM_WIDE_ROAD : VISION_STREAM_ROAD);
     CameraWidget::setFrameId(sm["modelV2"].getModelV2().getFrameId());
-    CameraWidget::paintGL();
   }
+  // the frame stays pinned while it is drawn, the vipc thread can go on receiving meanwhile
+  CameraWidget::paintGL();
 
   QPainter painter(this);
   painter.setRenderHint(QPainter::Antialiasing);
   painter.setPen(Qt::NoPen);
 
-  model.draw(painter, rect());
-  dmon.draw(painter, rect());
-  hud.updateState(*s);
-  hud.draw(painter, rect());
+  {
+    UIProfileScope model_profile(UIProfiler::MODEL_DRAW);
+    model.draw(painter, rect());
+  }
+  {
+    UIProfileScope dmon_profile(UIProfiler::DMON_DRAW);
+    dmon.draw(painter, rect());
+  }
+  {
+    UIProfileScope hud_profile(UIProfiler::HUD_DRAW);
+    hud.updateState(*s);
+    hud.draw(painter, rect());
+  }
 
   double cur_draw_t = millis_since_boot();
   double dt = cur_draw_t - prev_draw_t;
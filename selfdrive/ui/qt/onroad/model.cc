@@ -20,7 +20,7 @@ void ModelRenderer::draw(QPainter &painter, const QRect &surface_rect) {
   const auto &radar_state = sm["radarState"].getRadarState();
   const auto &lead_one = radar_state.getLeadOne();
 
-  update_model(model, lead_one);
+  update_geometry(model, lead_one);
   drawLaneLines(painter);
   drawPath(painter, model, surface_rect.height());
 
@@ -48,34 +48,48 @@ void ModelRenderer::update_leads(const cereal::RadarState::Reader &radar_state,
   }
 }
 
+void ModelRenderer::update_geometry(const cereal::ModelDataV2::Reader &model, const cereal::RadarState::LeadData::Reader &lead) {
+  const auto key = std::make_tuple(model.getFrameId(), lead.getStatus() ? lead.getDRel() : -1.0f,
+                                   path_offset_z, car_space_transform, clip_region);
+  if (key != geometry_key) {
+    geometry_key = key;
+    ++geometry_generation;
+    update_model(model, lead);
+  }
+}
+
 void ModelRenderer::update_model(const cereal::ModelDataV2::Reader &model, const cereal::RadarState::LeadData::Reader &lead) {
   const auto &model_position = model.getPosition();
   float max_distance = std::clamp(*(model_position.getX().end() - 1), MIN_DRAW_DISTANCE, MAX_DRAW_DISTANCE);
 
-  // update lane lines
   const auto &lane_lines = model.getLaneLines();
   const auto &line_probs = model.getLaneLineProbs();
-  int max_idx = get_path_length_idx(lane_lines[0], max_distance);
-  for (int i = 0; i < std::size(lane_line_vertices); i++) {
+  const int max_idx = get_path_length_idx(lane_lines[0], max_distance);
+  for (int i = 0; i < std::size(lane_line_probs); i++) {
     lane_line_probs[i] = line_probs[i];
-    mapLineToPolygon(lane_lines[i], 0.025 * lane_line_probs[i], 0, &lane_line_vertices[i], max_idx);
   }
 
-  // update road edges
   const auto &road_edges = model.getRoadEdges();
   const auto &edge_stds = model.getRoadEdgeStds();
-  for (int i = 0; i < std::size(road_edge_vertices); i++) {
+  for (int i = 0; i < std::size(road_edge_stds); i++) {
     road_edge_stds[i] = edge_stds[i];
-    mapLineToPolygon(road_edges[i], 0.025, 0, &road_edge_vertices[i], max_idx);
   }
 
-  // update path
   if (lead.getStatus()) {
     const float lead_d = lead.getDRel() * 2.;
     max_distance = std::clamp((float)(lead_d - fmin(lead_d * 0.35, 10.)), 0.0f, max_distance);
   }
-  max_idx = get_path_length_idx(model_position, max_distance);
-  mapLineToPolygon(model_position, 0.9, path_offset_z, &track_vertices, max_idx, false);
+  const int path_max_idx = get_path_length_idx(model_position, max_distance);
+
+  mapLinesToPolygons({
+    {lane_lines[0], 0.025f * lane_line_probs[0], 0, &lane_line_vertices[0], max_idx},
+    {lane_lines[1], 0.025f * lane_line_probs[1], 0, &lane_line_vertices[1], max_idx},
+    {lane_lines[2], 0.025f * lane_line_probs[2], 0, &lane_line_vertices[2], max_idx},
+    {lane_lines[3], 0.025f * lane_line_probs[3], 0, &lane_line_vertices[3], max_idx},
+    {road_edges[0], 0.025f, 0, &road_edge_vertices[0], max_idx},
+    {road_edges[1], 0.025f, 0, &road_edge_vertices[1], max_idx},
+    {model_position, 0.9f, path_offset_z, &track_vertices, path_max_idx, false},
+  });
 }
 
 void ModelRenderer::drawLaneLines(QPainter &painter) {
@@ -93,43 +107,48 @@ void ModelRenderer::drawLaneLines(QPainter &painter) {
 }
 
 void ModelRenderer::drawPath(QPainter &painter, const cereal::ModelDataV2::Reader &model, int height) {
-  QLinearGradient bg(0, height, 0, 0);
   if (experimental_mode) {
-    // The first half of track_vertices are the points for the right side of the path
-    const auto &acceleration = model.getAcceleration().getX();
-    const int max_len = std::min<int>(track_vertices.length() / 2, acceleration.size());
-
-    for (int i = 0; i < max_len; ++i) {
-      // Some points are out of frame
-      int track_idx = max_len - i - 1;  // flip idx to start from bottom right
-      if (track_vertices[track_idx].y() < 0 || track_vertices[track_idx].y() > height) continue;
-
-      // Flip so 0 is bottom of frame
-      float lin_grad_point = (height - track_vertices[track_idx].y()) / height;
-
-      // speed up: 120, slow down: 0
-      float path_hue = fmax(fmin(60 + acceleration[i] * 35, 120), 0);
-      // FIXME: painter.drawPolygon can be slow if hue is not rounded
-      path_hue = int(path_hue * 100 + 0.5) / 100;
-
-      float saturation = fmin(fabs(acceleration[i] * 1.5), 1);
-      float lightness = util::map_val(saturation, 0.0f, 1.0f, 0.95f, 0.62f);        // lighter when grey
-      float alpha = util::map_val(lin_grad_point, 0.75f / 2.f, 0.75f, 0.4f, 0.0f);  // matches previous alpha fade
-      bg.setColorAt(lin_grad_point, QColor::fromHslF(path_hue / 360., saturation, lightness, alpha));
-
-      // Skip a point, unless next is last
-      i += (i + 2) < max_len ? 1 : 0;
+    // the stops only move with the geometry
+    const auto key = std::make_tuple(true, height, geometry_generation, 0.0f, false);
+    if (key != path_brush_key) {
+      path_brush_key = key;
+      QLinearGradient bg(0, height, 0, 0);
+      // The first half of track_vertices are the points for the right side of the path
+      const auto &acceleration = model.getAcceleration().getX();
+      const int max_len = std::min<int>(track_vertices.length() / 2, acceleration.size());
+
+      for (int i = 0; i < max_len; ++i) {
+        // Some points are out of frame
+        int track_idx = max_len - i - 1;  // flip idx to start from bottom right
+        if (track_vertices[track_idx].y() < 0 || track_vertices[track_idx].y() > height) continue;
+
+        // Flip so 0 is bottom of frame
+        float lin_grad_point = (height - track_vertices[track_idx].y()) / height;
+
+        // speed up: 120, slow down: 0
+        float path_hue = fmax(fmin(60 + acceleration[i] * 35, 120), 0);
+        // FIXME: painter.drawPolygon can be slow if hue is not rounded
+        path_hue = int(path_hue * 100 + 0.5) / 100;
+
+        float saturation = fmin(fabs(acceleration[i] * 1.5), 1);
+        float lightness = util::map_val(saturation, 0.0f, 1.0f, 0.95f, 0.62f);        // lighter when grey
+        float alpha = util::map_val(lin_grad_point, 0.75f / 2.f, 0.75f, 0.4f, 0.0f);  // matches previous alpha fade
+        bg.setColorAt(lin_grad_point, QColor::fromHslF(path_hue / 360., saturation, lightness, alpha));
+
+        // Skip a point, unless next is last
+        i += (i + 2) < max_len ? 1 : 0;
+      }
+      path_brush = QBrush(bg);
     }
-
   } else {
-    updatePathGradient(bg);
+    updatePathGradient(height);
   }
 
-  painter.setBrush(bg);
+  painter.setBrush(path_brush);
   painter.drawPolygon(track_vertices);
 }
 
-void ModelRenderer::updatePathGradient(QLinearGradient &bg) {
+void ModelRenderer::updatePathGradient(int height) {
   static const QColor throttle_colors[] = {
       QColor::fromHslF(148. / 360., 0.94, 0.51, 0.4),
       QColor::fromHslF(112. / 360., 1.0, 0.68, 0.35),
@@ -158,10 +177,17 @@ void ModelRenderer::updatePathGradient(QLinearGradient &bg) {
     blend_factor = std::min(blend_factor + transition_speed, 1.0f);
   }
 
+  // outside of a transition the gradient stays the same
+  const auto key = std::make_tuple(false, height, uint64_t(0), blend_factor, allow_throttle);
+  if (key == path_brush_key) return;
+  path_brush_key = key;
+
   // Set gradient colors by blending the start and end colors
+  QLinearGradient bg(0, height, 0, 0);
   bg.setColorAt(0.0f, blendColors(begin_colors[0], end_colors[0], blend_factor));
   bg.setColorAt(0.5f, blendColors(begin_colors[1], end_colors[1], blend_factor));
   bg.setColorAt(1.0f, blendColors(begin_colors[2], end_colors[2], blend_factor));
+  path_brush = QBrush(bg);
 }
 
 QColor ModelRenderer::blendColors(const QColor &start, const QColor &end, float t) {
@@ -216,22 +242,51 @@ bool ModelRenderer::mapToScreen(float in_x, float in_y, float in_z, QPointF *out
 
 void ModelRenderer::mapLineToPolygon(const cereal::XYZTData::Reader &line, float y_off, float z_off,
                                      QPolygonF *pvd, int max_idx, bool allow_invert) {
-  const auto line_x = line.getX(), line_y = line.getY(), line_z = line.getZ();
-  QPointF left, right;
-  pvd->clear();
-  for (int i = 0; i <= max_idx; i++) {
-    // highly negative x positions  are drawn above the frame and cause flickering, clip to zy plane of camera
-    if (line_x[i] < 0) continue;
-
-    bool l = mapToScreen(line_x[i], line_y[i] - y_off, line_z[i] + z_off, &left);
-    bool r = mapToScreen(line_x[i], line_y[i] + y_off, line_z[i] + z_off, &right);
-    if (l && r) {
-      // For wider lines the drawn polygon will "invert" when going over a hill and cause artifacts
-      if (!allow_invert && pvd->size() && left.y() > pvd->back().y()) {
-        continue;
+  mapLinesToPolygons({{line, y_off, z_off, pvd, max_idx, allow_invert}});
+}
+
+void ModelRenderer::mapLinesToPolygons(std::initializer_list<LinePolygon> lines) {
+  int cols = 0;
+  for (const auto &l : lines) cols += 2 * (l.max_idx + 1);
+  line_points.resize(3, cols);
+
+  // left and right edge of every point, in car space
+  int col = 0;
+  for (const auto &l : lines) {
+    const auto line_x = l.line.getX(), line_y = l.line.getY(), line_z = l.line.getZ();
+    for (int i = 0; i <= l.max_idx; i++) {
+      line_points.col(col++) << line_x[i], line_y[i] - l.y_off, line_z[i] + l.z_off;
+      line_points.col(col++) << line_x[i], line_y[i] + l.y_off, line_z[i] + l.z_off;
+    }
+  }
+  projected_points.noalias() = car_space_transform * line_points;
+
+  col = 0;
+  QVector<QPointF> right_side;
+  for (const auto &l : lines) {
+    const auto line_x = l.line.getX();
+    QPolygonF &pvd = *l.pvd;
+    pvd.clear();
+    right_side.clear();
+    for (int i = 0; i <= l.max_idx; i++, col += 2) {
+      // highly negative x positions  are drawn above the frame and cause flickering, clip to zy plane of camera
+      if (line_x[i] < 0) continue;
+
+      const auto l_pt = projected_points.col(col), r_pt = projected_points.col(col + 1);
+      const QPointF left(l_pt.x() / l_pt.z(), l_pt.y() / l_pt.z());
+      const QPointF right(r_pt.x() / r_pt.z(), r_pt.y() / r_pt.z());
+      if (clip_region.contains(left) && clip_region.contains(right)) {
+        // For wider lines the drawn polygon will "invert" when going over a hill and cause artifacts
+        if (!l.allow_invert && pvd.size() && left.y() > pvd.back().y()) {
+          continue;
+        }
+        pvd.push_back(left);
+        right_side.push_back(right);
       }
-      pvd->push_back(left);
-      pvd->push_front(right);
     }
+    // the right side runs back from the far end, so the polygon closes along the line
+    pvd.reserve(pvd.size() + right_side.size());
+    pvd.insert(0, right_side.size(), QPointF());
+    std::copy(right_side.rbegin(), right_side.rend(), pvd.begin());
   }
 }
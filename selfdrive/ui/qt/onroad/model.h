@@ -1,5 +1,7 @@
 #pragma once
 
+#include <tuple>
+
 #include <QPainter>
 #include <QPolygonF>
 
@@ -34,12 +36,23 @@ protected:
   bool mapToScreen(float in_x, float in_y, float in_z, QPointF *out);
   void mapLineToPolygon(const cereal::XYZTData::Reader &line, float y_off, float z_off,
                         QPolygonF *pvd, int max_idx, bool allow_invert = true);
+
+  struct LinePolygon {
+    cereal::XYZTData::Reader line;
+    float y_off, z_off;
+    QPolygonF *pvd;
+    int max_idx;
+    bool allow_invert = true;
+  };
+  // projects the edges of all lines with one matrix product
+  void mapLinesToPolygons(std::initializer_list<LinePolygon> lines);
   void drawLead(QPainter &painter, const cereal::RadarState::LeadData::Reader &lead_data, const QPointF &vd, const QRect &surface_rect);
   void update_leads(const cereal::RadarState::Reader &radar_state, const cereal::XYZTData::Reader &line);
+  void update_geometry(const cereal::ModelDataV2::Reader &model, const cereal::RadarState::LeadData::Reader &lead);
   virtual void update_model(const cereal::ModelDataV2::Reader &model, const cereal::RadarState::LeadData::Reader &lead);
   void drawLaneLines(QPainter &painter);
   void drawPath(QPainter &painter, const cereal::ModelDataV2::Reader &model, int height);
-  void updatePathGradient(QLinearGradient &bg);
+  void updatePathGradient(int height);
   QColor blendColors(const QColor &start, const QColor &end, float t);
 
   bool longitudinal_control = false;
@@ -55,4 +68,13 @@ protected:
   QPointF lead_vertices[2] = {};
   Eigen::Matrix3f car_space_transform = Eigen::Matrix3f::Zero();
   QRectF clip_region;
+
+  // update_geometry only runs update_model when one of its inputs changed: the model frame,
+  // the lead distance the path is clipped to, calibration or the surface
+  std::tuple<uint32_t, float, float, Eigen::Matrix3f, QRectF> geometry_key = {0, 0, 0, Eigen::Matrix3f::Zero(), {}};
+  uint64_t geometry_generation = 0;
+  // path brush and what it was built from: mode, height, geometry or blend state
+  std::tuple<bool, int, uint64_t, float, bool> path_brush_key = {};
+  QBrush path_brush;
+  Eigen::Matrix3Xf line_points, projected_points;
 };
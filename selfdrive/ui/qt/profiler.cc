@@ -0,0 +1,109 @@
+#include "selfdrive/ui/qt/profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "common/swaglog.h"
+#include "common/util.h"
+
+UIProfiler &UIProfiler::instance() {
+  static UIProfiler profiler;
+  return profiler;
+}
+
+UIProfiler::UIProfiler() : enabled_(util::getenv("UI_PROFILE", 0) != 0) {
+  if (!enabled_) return;
+
+  pm = std::make_unique<PubMaster>(std::vector<const char*>{"uiProfileSP"});
+  if (const char *path = std::getenv("UI_PROFILE_FILE")) {
+    dump = fopen(path, "a");
+    if (dump) {
+      fprintf(dump, "time,started,stage,count,mean_ms,p50_ms,p95_ms,max_ms,over_budget\n");
+    } else {
+      LOGE("failed to open UI profile file %s", path);
+    }
+  }
+}
+
+UIProfiler::~UIProfiler() {
+  if (dump) fclose(dump);
+}
+
+void UIProfiler::record(Stage stage, uint64_t ns) {
+  Histogram &h = window[stage];
+  const float ms = ns / 1e6;
+  h.bins[std::min<int>(ms / BIN_MS, BIN_COUNT - 1)]++;
+  h.count++;
+  h.sum_ms += ms;
+  h.max_ms = std::max(h.max_ms, ms);
+  h.over_budget += ms > BUDGET_MS;
+}
+
+UIProfiler::Summary UIProfiler::summarize(const Histogram &h) {
+  Summary s;
+  s.count = h.count;
+  if (h.count == 0) return s;
+
+  // upper edge of the bin holding the percentile, never past the largest sample
+  auto percentile = [&](float p) {
+    const uint32_t target = std::max<uint32_t>(1, p * h.count + 0.5f);
+    uint32_t seen = 0;
+    for (int i = 0; i < BIN_COUNT; ++i) {
+      seen += h.bins[i];
+      if (seen >= target) return std::min((i + 1) * BIN_MS, h.max_ms);
+    }
+    return h.max_ms;
+  };
+  s.mean_ms = h.sum_ms / h.count;
+  s.p50_ms = percentile(0.5f);
+  s.p95_ms = percentile(0.95f);
+  s.max_ms = h.max_ms;
+  s.over_budget = h.over_budget;
+  return s;
+}
+
+void UIProfiler::tick(bool started) {
+  if (!enabled_) return;
+
+  const uint64_t now = nanos_since_boot();
+  if (window_start == 0) window_start = now;
+  if (now - window_start < 1e9) return;
+
+  for (int i = 0; i < STAGE_COUNT; ++i) {
+    last_window[i] = summarize(window[i]);
+  }
+  window = {};
+  window_start = now;
+  publish(started);
+}
+
+void UIProfiler::publish(bool started) {
+  MessageBuilder msg;
+  auto profile = msg.initEvent().initUiProfileSP();
+  profile.setBudgetMillis(BUDGET_MS);
+  profile.setStarted(started);
+  auto stages = profile.initStages(STAGE_COUNT);
+  for (int i = 0; i < STAGE_COUNT; ++i) {
+    const Summary &s = last_window[i];
+    auto stage = stages[i];
+    stage.setName(stage_names[i]);
+    stage.setCount(s.count);
+    stage.setMeanMillis(s.mean_ms);
+    stage.setP50Millis(s.p50_ms);
+    stage.setP95Millis(s.p95_ms);
+    stage.setMaxMillis(s.max_ms);
+    stage.setOverBudget(s.over_budget);
+  }
+  pm->send("uiProfileSP", msg);
+
+  if (dump) {
+    const double t = window_start / 1e9;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+      const Summary &s = last_window[i];
+      if (s.count == 0) continue;
+      fprintf(dump, "%.3f,%d,%s,%u,%.3f,%.3f,%.3f,%.3f,%u\n", t, started, stage_names[i],
+              s.count, s.mean_ms, s.p50_ms, s.p95_ms, s.max_ms, s.over_budget);
+    }
+    fflush(dump);
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+#include "cereal/messaging/messaging.h"
+#include "common/timing.h"
+
+// Update and paint times of the UI per stage, collected when UI_PROFILE=1. Each second the
+// window is published as uiProfileSP, and appended to UI_PROFILE_FILE when that is set.
+// Stages are only timed on the UI thread.
+class UIProfiler {
+public:
+  enum Stage {
+    UPDATE,
+    UPDATE_SOCKETS,
+    ONROAD_PAINT,
+    CAMERA_PAINT,
+    MODEL_DRAW,
+    DMON_DRAW,
+    HUD_DRAW,
+    STAGE_COUNT,
+  };
+  static constexpr const char *stage_names[STAGE_COUNT] = {
+    "update", "update_sockets", "onroad_paint", "camera_paint", "model_draw", "dmon_draw", "hud_draw",
+  };
+  // one frame at the 20 Hz UI rate
+  static constexpr float BUDGET_MS = 50.0f;
+
+  struct Summary {
+    uint32_t count = 0;
+    float mean_ms = 0, p50_ms = 0, p95_ms = 0, max_ms = 0;
+    uint32_t over_budget = 0;
+  };
+
+  static UIProfiler &instance();
+  ~UIProfiler();
+  bool enabled() const { return enabled_; }
+  void record(Stage stage, uint64_t ns);
+  // closes the window once a second has passed, called on every UI update
+  void tick(bool started);
+  const std::array<Summary, STAGE_COUNT> &lastWindow() const { return last_window; }
+
+private:
+  UIProfiler();
+
+  // 0.25 ms bins, the last one takes everything from 100 ms on
+  static constexpr int BIN_COUNT = 400;
+  static constexpr float BIN_MS = 0.25f;
+  struct Histogram {
+    std::array<uint32_t, BIN_COUNT> bins = {};
+    uint32_t count = 0, over_budget = 0;
+    double sum_ms = 0;
+    float max_ms = 0;
+  };
+  static Summary summarize(const Histogram &h);
+  void publish(bool started);
+
+  const bool enabled_;
+  std::array<Histogram, STAGE_COUNT> window = {};
+  std::array<Summary, STAGE_COUNT> last_window = {};
+  uint64_t window_start = 0;
+  std::unique_ptr<PubMaster> pm;
+  FILE *dump = nullptr;
+};
+
+class UIProfileScope {
+public:
+  explicit UIProfileScope(UIProfiler::Stage stage)
+      : stage(stage), start(UIProfiler::instance().enabled() ? nanos_since_boot() : 0) {}
+  ~UIProfileScope() {
+    if (start) UIProfiler::instance().record(stage, nanos_since_boot() - start);
+  }
+
+private:
+  const UIProfiler::Stage stage;
+  const uint64_t start;
+};
@@ -205,6 +205,43 @@ bool hasLongitudinalControl(const cereal::CarParams::Reader &car_params) {
 
 // ParamWatcher
 
+const QStaticText &StaticTextCache::get(const QFont &font, const QString &text) {
+  auto font_texts = texts.find(font);
+  if (font_texts != texts.end()) {
+    auto it = font_texts->constFind(text);
+    if (it != font_texts->cend()) return *it;
+  }
+
+  // values like the speed keep producing new strings, start over instead of growing
+  if (entries >= MAX_ENTRIES) {
+    texts.clear();
+    entries = 0;
+  }
+  QStaticText static_text(text);
+  static_text.setTextFormat(Qt::PlainText);
+  static_text.setPerformanceHint(QStaticText::AggressiveCaching);
+  static_text.prepare(QTransform(), font);
+  ++entries;
+  return *texts[font].insert(text, static_text);
+}
+
+void StaticTextCache::draw(QPainter &p, const QRectF &rect, int flags, const QString &text) {
+  const QStaticText &static_text = get(p.font(), text);
+  const QSizeF size = static_text.size();
+  QPointF pos = rect.topLeft();
+  if (flags & Qt::AlignRight) {
+    pos.setX(rect.right() - size.width());
+  } else if (flags & Qt::AlignHCenter) {
+    pos.setX(rect.center().x() - size.width() / 2);
+  }
+  if (flags & Qt::AlignBottom) {
+    pos.setY(rect.bottom() - size.height());
+  } else if (flags & Qt::AlignVCenter) {
+    pos.setY(rect.center().y() - size.height() / 2);
+  }
+  p.drawStaticText(pos, static_text);
+}
+
 ParamWatcher::ParamWatcher(QObject *parent) : QObject(parent) {
   watcher = new QFileSystemWatcher(this);
   QObject::connect(watcher, &QFileSystemWatcher::fileChanged, this, &ParamWatcher::fileChanged);
@@ -5,8 +5,10 @@
 
 #include <QDateTime>
 #include <QFileSystemWatcher>
+#include <QHash>
 #include <QPainter>
 #include <QPixmap>
+#include <QStaticText>
 #include <QSurfaceFormat>
 #include <QWidget>
 
@@ -35,6 +37,21 @@ struct InterFont : public QFont {
   }
 };
 
+// Single line texts laid out once per font and string. Most HUD values repeat from one frame
+// to the next, drawing them from here skips shaping the same text again.
+class StaticTextCache {
+public:
+  // valid until the next call
+  const QStaticText &get(const QFont &font, const QString &text);
+  // placed like QPainter::drawText(rect, flags, text) with the painter's font
+  void draw(QPainter &p, const QRectF &rect, int flags, const QString &text);
+
+private:
+  static constexpr int MAX_ENTRIES = 512;
+  QHash<QFont, QHash<QString, QStaticText>> texts;
+  int entries = 0;
+};
+
 class ParamWatcher : public QObject {
   Q_OBJECT
 
@@ -7,8 +7,11 @@
 #endif
 
 #include <cmath>
+#include <cstring>
 #include <QApplication>
 
+#include "selfdrive/ui/qt/profiler.h"
+
 namespace {
 
 const char frame_vertex_shader[] =
@@ -81,6 +84,7 @@ CameraWidget::~CameraWidget() {
     glDeleteBuffers(1, &frame_ibo);
 #ifndef QCOM2
     glDeleteTextures(2, textures);
+    glDeleteBuffers(2, pbos);
 #endif
   }
   doneCurrent();
@@ -141,6 +145,7 @@ void CameraWidget::initializeGL() {
   glUniform1i(program->uniformLocation("uTexture"), 0);
 #else
   glGenTextures(2, textures);
+  glGenBuffers(2, pbos);
   glUniform1i(program->uniformLocation("uTextureY"), 0);
   glUniform1i(program->uniformLocation("uTextureUV"), 1);
 #endif
@@ -196,54 +201,46 @@ mat4 CameraWidget::calcFrameMatrix() {
 }
 
 void CameraWidget::paintGL() {
+  UIProfileScope profile(UIProfiler::CAMERA_PAINT);
   glClearColor(bg.redF(), bg.greenF(), bg.blueF(), bg.alphaF());
   glClear(GL_STENCIL_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
-  std::lock_guard lk(frame_lock);
-  if (frames.empty()) return;
-
-  int frame_idx = frames.size() - 1;
+  std::shared_ptr<const CameraFrame> frame;
+  {
+    std::lock_guard lk(frame_lock);
+    if (frames.empty()) return;
 
-  // Always draw latest frame until sync logic is more stable
-  // for (frame_idx = 0; frame_idx < frames.size() - 1; frame_idx++) {
-  //   if (frames[frame_idx].first == draw_frame_id) break;
-  // }
+    // Always draw latest frame until sync logic is more stable
+    frame = frames.back();
+  }
 
   // Log duplicate/dropped frames
-  if (frames[frame_idx].first == prev_frame_id) {
-    qDebug() << "Drawing same frame twice" << frames[frame_idx].first;
-  } else if (frames[frame_idx].first != prev_frame_id + 1) {
-    qDebug() << "Skipped frame" << frames[frame_idx].first;
+  if (frame->frame_id == prev_frame_id) {
+    qDebug() << "Drawing same frame twice" << frame->frame_id;
+  } else if (frame->frame_id != prev_frame_id + 1) {
+    qDebug() << "Skipped frame" << frame->frame_id;
   }
-  prev_frame_id = frames[frame_idx].first;
-  VisionBuf *frame = frames[frame_idx].second;
-  assert(frame != nullptr);
+  prev_frame_id = frame->frame_id;
 
   auto frame_mat = calcFrameMatrix();
 
   glViewport(0, 0, glWidth(), glHeight());
   glBindVertexArray(frame_vao);
   glUseProgram(program->programId());
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
 #ifdef QCOM2
   // no frame copy
   glActiveTexture(GL_TEXTURE0);
-  glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, egl_images[frame->idx]);
+  glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, egl_images[frame->buf->idx]);
   assert(glGetError() == GL_NO_ERROR);
 #else
-  // fallback to copy
-  glPixelStorei(GL_UNPACK_ROW_LENGTH, stream_stride);
+  if (frame->frame_id != uploaded_frame_id || frame->buf != uploaded_buf) {
+    uploadFrame(*frame);
+  }
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, textures[0]);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream_width, stream_height, GL_RED, GL_UNSIGNED_BYTE, frame->y);
-  assert(glGetError() == GL_NO_ERROR);
-
-  glPixelStorei(GL_UNPACK_ROW_LENGTH, stream_stride/2);
   glActiveTexture(GL_TEXTURE0 + 1);
   glBindTexture(GL_TEXTURE_2D, textures[1]);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream_width/2, stream_height/2, GL_RG, GL_UNSIGNED_BYTE, frame->uv);
-  assert(glGetError() == GL_NO_ERROR);
 #endif
 
   glUniformMatrix4fv(program->uniformLocation("uTransform"), 1, GL_TRUE, frame_mat.v);
@@ -253,9 +250,56 @@ void CameraWidget::paintGL() {
   glBindVertexArray(0);
   glBindTexture(GL_TEXTURE_2D, 0);
   glActiveTexture(GL_TEXTURE0);
+}
+
+#ifndef QCOM2
+// The frame is copied into the next pixel buffer and the textures are updated from there, so the
+// driver moves the pixels while the paint goes on. Mapping the other buffer of the pair never
+// waits for the transfer of the previous frame.
+bool CameraWidget::uploadFrame(const CameraFrame &frame) {
+  const size_t y_size = stream_stride * stream_height;
+  const size_t uv_size = stream_stride * (stream_height / 2);
+
+  pbo_idx = (pbo_idx + 1) % std::size(pbos);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[pbo_idx]);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, y_size + uv_size, nullptr, GL_STREAM_DRAW);
+  auto dst = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, y_size + uv_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (!dst) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return false;
+  }
+  memcpy(dst, frame.buf->y, y_size);
+  memcpy(dst + y_size, frame.buf->uv, uv_size);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+  // the server hands its buffers out in a ring, a slow paint may have copied the next frame in it
+  if (frame.stamped && frame.buf->get_frame_id() != frame.frame_id) {
+    qDebug() << "Frame buffer recycled while uploading" << frame.frame_id;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return false;
+  }
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, stream_stride);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, textures[0]);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream_width, stream_height, GL_RED, GL_UNSIGNED_BYTE, (const void *)0);
+  assert(glGetError() == GL_NO_ERROR);
+
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, stream_stride/2);
+  glActiveTexture(GL_TEXTURE0 + 1);
+  glBindTexture(GL_TEXTURE_2D, textures[1]);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream_width/2, stream_height/2, GL_RG, GL_UNSIGNED_BYTE, (const void *)y_size);
+  assert(glGetError() == GL_NO_ERROR);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  uploaded_frame_id = frame.frame_id;
+  uploaded_buf = frame.buf;
+  return true;
 }
+#endif
 
 void CameraWidget::vipcConnected(VisionIpcClient *vipc_client) {
   makeCurrent();
@@ -304,6 +348,7 @@ void CameraWidget::vipcConnected(VisionIpcClient *vipc_client) {
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, stream_width/2, stream_height/2, 0, GL_RG, GL_UNSIGNED_BYTE, nullptr);
   assert(glGetError() == GL_NO_ERROR);
+  uploaded_buf = nullptr;
 #endif
 }
 
@@ -319,6 +364,7 @@ void CameraWidget::vipcThread() {
   while (!QThread::currentThread()->isInterruptionRequested()) {
     if (!vipc_client || cur_stream != requested_stream_type) {
       clearFrames();
+      waitForUnpinnedFrames();
       qDebug().nospace() << "connecting to stream " << requested_stream_type << ", was connected to " << cur_stream;
       cur_stream = requested_stream_type;
       vipc_client.reset(new VisionIpcClient(stream_name, cur_stream, false));
@@ -344,7 +390,7 @@ void CameraWidget::vipcThread() {
     if (VisionBuf *buf = vipc_client->recv(&meta_main, 1000)) {
       {
         std::lock_guard lk(frame_lock);
-        frames.push_back(std::make_pair(meta_main.frame_id, buf));
+        frames.push_back(pinFrame(meta_main.frame_id, buf));
         while (frames.size() > FRAME_BUFFER_SIZE) {
           frames.pop_front();
         }
@@ -356,6 +402,8 @@ void CameraWidget::vipcThread() {
       }
     }
   }
+  // no frame may outlive the client mapping its buffer
+  clearFrames();
 }
 
 void CameraWidget::clearFrames() {
@@ -363,3 +411,19 @@ void CameraWidget::clearFrames() {
   frames.clear();
   available_streams.clear();
 }
+
+std::shared_ptr<const CameraFrame> CameraWidget::pinFrame(uint32_t frame_id, VisionBuf *buf) {
+  pinned_frames++;
+  auto frame = new CameraFrame{frame_id, buf, buf->get_frame_id() == frame_id};
+  return std::shared_ptr<const CameraFrame>(frame, [this](const CameraFrame *f) {
+    delete f;
+    pinned_frames--;
+  });
+}
+
+// the buffers are unmapped with their client, a paint still reading one holds it until done
+void CameraWidget::waitForUnpinnedFrames() {
+  while (pinned_frames > 0 && !QThread::currentThread()->isInterruptionRequested()) {
+    QThread::usleep(100);
+  }
+}
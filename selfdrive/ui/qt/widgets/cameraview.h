@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <deque>
 #include <map>
 #include <memory>
@@ -32,6 +33,15 @@
 
 const int FRAME_BUFFER_SIZE = 5;
 
+// A received frame. Paint holds a reference while it reads the buffer, and the vipc thread
+// waits for all references to be dropped before replacing the client that maps the buffers.
+struct CameraFrame {
+  uint32_t frame_id;
+  VisionBuf *buf;
+  // the server wrote the frame id into the buffer, so a recycled buffer can be detected
+  bool stamped;
+};
+
 class CameraWidget : public QOpenGLWidget, protected QOpenGLFunctions {
   Q_OBJECT
 
@@ -59,6 +69,11 @@ protected:
   virtual mat4 calcFrameMatrix();
   void vipcThread();
   void clearFrames();
+  std::shared_ptr<const CameraFrame> pinFrame(uint32_t frame_id, VisionBuf *buf);
+  void waitForUnpinnedFrames();
+#ifndef QCOM2
+  bool uploadFrame(const CameraFrame &frame);
+#endif
 
   int glWidth();
   int glHeight();
@@ -70,6 +85,12 @@ protected:
 
 #ifdef QCOM2
   std::map<int, EGLImageKHR> egl_images;
+#else
+  // frames go through two pixel buffers, and a frame already in the textures is not uploaded again
+  GLuint pbos[2];
+  int pbo_idx = 0;
+  uint32_t uploaded_frame_id = 0;
+  const VisionBuf *uploaded_buf = nullptr;
 #endif
 
   std::string stream_name;
@@ -81,7 +102,8 @@ protected:
   std::set<VisionStreamType> available_streams;
   QThread *vipc_thread = nullptr;
   std::recursive_mutex frame_lock;
-  std::deque<std::pair<uint32_t, VisionBuf*>> frames;
+  std::atomic<int> pinned_frames = 0;
+  std::deque<std::shared_ptr<const CameraFrame>> frames;
   uint32_t draw_frame_id = 0;
   uint32_t prev_frame_id = 0;
 
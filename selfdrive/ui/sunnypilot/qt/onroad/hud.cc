@@ -8,6 +8,7 @@
 
 #include "selfdrive/ui/sunnypilot/qt/onroad/hud.h"
 
+#include "selfdrive/ui/qt/profiler.h"
 #include "selfdrive/ui/qt/util.h"
 
 
@@ -192,6 +193,11 @@ void HudRendererSP::draw(QPainter &p, const QRect &surface_rect) {
       drawRightDevUI(p, surface_rect.right() - 184 - UI_BORDER_SIZE * 2, UI_BORDER_SIZE * 2 + rect_right.height());
     }
 
+    // Frame budget, with UI_PROFILE=1
+    if (devUiInfo != 0 && UIProfiler::instance().enabled()) {
+      drawFrameBudget(p);
+    }
+
     // Speed Limit
     bool showSpeedLimit;
     bool speed_limit_assist_pre_active_pulse = pulseElement(speedLimitAssistFrame);
@@ -270,10 +276,11 @@ void HudRendererSP::draw(QPainter &p, const QRect &surface_rect) {
 }
 
 void HudRendererSP::drawText(QPainter &p, int x, int y, const QString &text, QColor color) {
-  QRect real_rect = p.fontMetrics().boundingRect(text);
+  const QStaticText &static_text = text_cache.get(p.font(), text);
+  QRect real_rect(QPoint(), static_text.size().toSize());
   real_rect.moveCenter({x, y - real_rect.height() / 2});
   p.setPen(color);
-  p.drawText(real_rect.x(), real_rect.bottom(), text);
+  p.drawStaticText(real_rect.x(), real_rect.bottom() - p.fontMetrics().ascent(), static_text);
 }
 
 bool HudRendererSP::pulseElement(int frame) {
@@ -302,16 +309,21 @@ void HudRendererSP::drawSmartCruiseControlOnroadIcon(QPainter &p, const QRect &s
                  y - (box_height / 2) + y_offset,
                  box_width, box_height);
 
-  QPainterPath boxPath;
-  boxPath.addRoundedRect(bg_rect, 10, 10);
+  // subtracting the glyphs is slow, the box only moves with the surface or the icon order
+  auto &[cached_rect, boxPath] = scc_icon_paths[text];
+  if (cached_rect != bg_rect || boxPath.isEmpty()) {
+    cached_rect = bg_rect;
+    boxPath = QPainterPath();
+    boxPath.addRoundedRect(bg_rect, 10, 10);
 
-  int text_w = fm.horizontalAdvance(text);
-  qreal baseline_y = bg_rect.top() + padding_v + fm.ascent();
-  qreal text_x = bg_rect.center().x() - (text_w / 2.0);
+    int text_w = fm.horizontalAdvance(text);
+    qreal baseline_y = bg_rect.top() + padding_v + fm.ascent();
+    qreal text_x = bg_rect.center().x() - (text_w / 2.0);
 
-  QPainterPath textPath;
-  textPath.addText(QPointF(text_x, baseline_y), font, text);
-  boxPath = boxPath.subtracted(textPath);
+    QPainterPath textPath;
+    textPath.addText(QPointF(text_x, baseline_y), font, text);
+    boxPath = boxPath.subtracted(textPath);
+  }
 
   p.setPen(Qt::NoPen);
   p.setBrush(longOverride ? QColor(0x91, 0x9b, 0x95, 0xf1) : QColor(0, 0xff, 0, 0xff));
@@ -370,27 +382,23 @@ void HudRendererSP::drawRightDevUI(QPainter &p, int x, int y) {
 
 int HudRendererSP::drawBottomDevUIElement(QPainter &p, int x, int y, const QString &value, const QString &label, const QString &units, QColor &color) {
   p.setFont(InterFont(38, QFont::Bold));
-  QFontMetrics fm(p.font());
-  QRect init_rect = fm.boundingRect(label + " ");
-  QRect real_rect = fm.boundingRect(init_rect, 0, label + " ");
+  QRect real_rect(QPoint(), text_cache.get(p.font(), label + " ").size().toSize());
   real_rect.moveCenter({x, y});
 
-  QRect init_rect2 = fm.boundingRect(value);
-  QRect real_rect2 = fm.boundingRect(init_rect2, 0, value);
+  QRect real_rect2(QPoint(), text_cache.get(p.font(), value).size().toSize());
   real_rect2.moveTop(real_rect.top());
   real_rect2.moveLeft(real_rect.right() + 10);
 
-  QRect init_rect3 = fm.boundingRect(units);
-  QRect real_rect3 = fm.boundingRect(init_rect3, 0, units);
+  QRect real_rect3(QPoint(), text_cache.get(p.font(), units).size().toSize());
   real_rect3.moveTop(real_rect.top());
   real_rect3.moveLeft(real_rect2.right() + 10);
 
   p.setPen(Qt::white);
-  p.drawText(real_rect, Qt::AlignLeft | Qt::AlignVCenter, label);
+  text_cache.draw(p, real_rect, Qt::AlignLeft | Qt::AlignVCenter, label);
 
   p.setPen(color);
-  p.drawText(real_rect2, Qt::AlignRight | Qt::AlignVCenter, value);
-  p.drawText(real_rect3, Qt::AlignLeft | Qt::AlignVCenter, units);
+  text_cache.draw(p, real_rect2, Qt::AlignRight | Qt::AlignVCenter, value);
+  text_cache.draw(p, real_rect3, Qt::AlignLeft | Qt::AlignVCenter, units);
   return 430;
 }
 
@@ -421,6 +429,41 @@ void HudRendererSP::drawBottomDevUI(QPainter &p, int x, int y) {
   rw += drawBottomDevUIElement(p, rw, y, altitudeElement.value, altitudeElement.label, altitudeElement.units, altitudeElement.color);
 }
 
+void HudRendererSP::drawFrameBudget(QPainter &p) {
+  const auto &stages = UIProfiler::instance().lastWindow();
+  const int x = 60, y = 440, w = 440, row_h = 40;
+  p.setPen(Qt::NoPen);
+  p.setBrush(QColor(0, 0, 0, 160));
+  p.drawRoundedRect(QRect(x, y, w, row_h * (UIProfiler::STAGE_COUNT + 1) + 20), 16, 16);
+
+  p.setFont(InterFont(28, QFont::Bold));
+  p.setPen(Qt::white);
+  const QRect header(x + 20, y + 10, w - 40, row_h);
+  text_cache.draw(p, header, Qt::AlignLeft | Qt::AlignVCenter, "STAGE");
+  text_cache.draw(p, header, Qt::AlignRight | Qt::AlignVCenter, "p95 / max ms");
+
+  for (int i = 0; i < UIProfiler::STAGE_COUNT; ++i) {
+    const auto &stage = stages[i];
+    const QRect row = header.translated(0, row_h * (i + 1));
+
+    // the slowest frame of the last second against the budget
+    QColor color = QColor(0, 255, 0, 120);
+    if (stage.max_ms > UIProfiler::BUDGET_MS) {
+      color = QColor(255, 0, 0, 120);
+    } else if (stage.max_ms > UIProfiler::BUDGET_MS * 0.75) {
+      color = QColor(255, 188, 0, 120);
+    }
+    p.setPen(Qt::NoPen);
+    p.setBrush(color);
+    p.drawRect(QRect(row.left(), row.top() + 6, row.width() * std::min(stage.max_ms / UIProfiler::BUDGET_MS, 1.0f), row.height() - 12));
+
+    p.setPen(Qt::white);
+    text_cache.draw(p, row, Qt::AlignLeft | Qt::AlignVCenter, UIProfiler::stage_names[i]);
+    text_cache.draw(p, row, Qt::AlignRight | Qt::AlignVCenter,
+                    QString("%1 / %2").arg(stage.p95_ms, 0, 'f', 1).arg(stage.max_ms, 0, 'f', 1));
+  }
+}
+
 void HudRendererSP::drawSpeedLimitSigns(QPainter &p, QRect &sign_rect) {
   bool speedLimitWarningEnabled = speedLimitMode >= SpeedLimitMode::WARNING;  // TODO-SP: update to include SpeedLimitMode::ASSIST
   bool hasSpeedLimit = speedLimitValid || speedLimitLastValid;
@@ -477,7 +520,7 @@ void HudRendererSP::drawSpeedLimitSigns(QPainter &p, QRect &sign_rect) {
     p.setFont(InterFont(font_size, QFont::Bold));
 
     p.setPen(speed_color);
-    p.drawText(center_circle, Qt::AlignCenter, speedLimitStr);
+    text_cache.draw(p, center_circle, Qt::AlignCenter, speedLimitStr);
 
     // Offset value in small circular box
     if (!speedLimitSubText.isEmpty() && hasSpeedLimit) {
@@ -496,7 +539,7 @@ void HudRendererSP::drawSpeedLimitSigns(QPainter &p, QRect &sign_rect) {
 
       p.setFont(InterFont(offset_circle_size * speedLimitSubTextFactor, QFont::Bold));
       p.setPen(QColor(255, 255, 255, alpha));
-      p.drawText(offset_circle_rect, Qt::AlignCenter, speedLimitSubText);
+      text_cache.draw(p, offset_circle_rect, Qt::AlignCenter, speedLimitSubText);
     }
   } else {
     // US/Canada MUTCD style sign
@@ -515,14 +558,14 @@ void HudRendererSP::drawSpeedLimitSigns(QPainter &p, QRect &sign_rect) {
     // "SPEED LIMIT" text
     p.setFont(InterFont(40, QFont::DemiBold));
     p.setPen(QColor(0, 0, 0, alpha));
-    p.drawText(inner_rect.adjusted(0, 10, 0, 0), Qt::AlignTop | Qt::AlignHCenter, tr("SPEED"));
-    p.drawText(inner_rect.adjusted(0, 50, 0, 0), Qt::AlignTop | Qt::AlignHCenter, tr("LIMIT"));
+    text_cache.draw(p, inner_rect.adjusted(0, 10, 0, 0), Qt::AlignTop | Qt::AlignHCenter, tr("SPEED"));
+    text_cache.draw(p, inner_rect.adjusted(0, 50, 0, 0), Qt::AlignTop | Qt::AlignHCenter, tr("LIMIT"));
 
     // Speed value with color coding
     p.setFont(InterFont(90, QFont::Bold));
 
     p.setPen(speed_color);
-    p.drawText(inner_rect.adjusted(0, 80, 0, 0), Qt::AlignTop | Qt::AlignHCenter, speedLimitStr);
+    text_cache.draw(p, inner_rect.adjusted(0, 80, 0, 0), Qt::AlignTop | Qt::AlignHCenter, speedLimitStr);
 
     // Offset value in small box
     if (!speedLimitSubText.isEmpty() && hasSpeedLimit) {
@@ -542,7 +585,7 @@ void HudRendererSP::drawSpeedLimitSigns(QPainter &p, QRect &sign_rect) {
 
       p.setFont(InterFont(offset_box_size * speedLimitSubTextFactor, QFont::Bold));
       p.setPen(QColor(255, 255, 255, alpha));
-      p.drawText(offset_box_rect, Qt::AlignCenter, speedLimitSubText);
+      text_cache.draw(p, offset_box_rect, Qt::AlignCenter, speedLimitSubText);
     }
   }
 }
@@ -598,17 +641,17 @@ void HudRendererSP::drawUpcomingSpeedLimit(QPainter &p) {
   // "AHEAD" label
   p.setFont(InterFont(40, QFont::DemiBold));
   p.setPen(QColor(200, 200, 200, 255));
-  p.drawText(ahead_rect.adjusted(0, 4, 0, 0), Qt::AlignTop | Qt::AlignHCenter, tr("AHEAD"));
+  text_cache.draw(p, ahead_rect.adjusted(0, 4, 0, 0), Qt::AlignTop | Qt::AlignHCenter, tr("AHEAD"));
 
   // Speed value
   p.setFont(InterFont(70, QFont::Bold));
   p.setPen(QColor(255, 255, 255, 255));
-  p.drawText(ahead_rect.adjusted(0, 38, 0, 0), Qt::AlignTop | Qt::AlignHCenter, speedStr);
+  text_cache.draw(p, ahead_rect.adjusted(0, 38, 0, 0), Qt::AlignTop | Qt::AlignHCenter, speedStr);
 
   // Distance
   p.setFont(InterFont(40, QFont::Normal));
   p.setPen(QColor(180, 180, 180, 255));
-  p.drawText(ahead_rect.adjusted(0, 110, 0, 0), Qt::AlignTop | Qt::AlignHCenter, distanceStr);
+  text_cache.draw(p, ahead_rect.adjusted(0, 110, 0, 0), Qt::AlignTop | Qt::AlignHCenter, distanceStr);
 }
 
 void HudRendererSP::drawRoadName(QPainter &p, const QRect &surface_rect) {
@@ -638,7 +681,7 @@ void HudRendererSP::drawRoadName(QPainter &p, const QRect &surface_rect) {
 
   // Truncate if still too long
   QString truncated = fm.elidedText(roadNameStr, Qt::ElideRight, road_rect.width() - 20);
-  p.drawText(road_rect, Qt::AlignCenter, truncated);
+  text_cache.draw(p, road_rect, Qt::AlignCenter, truncated);
 }
 
 void HudRendererSP::drawSpeedLimitPreActiveArrow(QPainter &p, QRect &sign_rect) {
@@ -708,13 +751,13 @@ void HudRendererSP::drawSetSpeedSP(QPainter &p, const QRect &surface_rect) {
 
   p.setFont(InterFont(max_str_size, QFont::DemiBold));
   p.setPen(max_color);
-  p.drawText(set_speed_rect.adjusted(0, max_str_y, 0, 0), Qt::AlignTop | Qt::AlignHCenter, max_str);
+  text_cache.draw(p, set_speed_rect.adjusted(0, max_str_y, 0, 0), Qt::AlignTop | Qt::AlignHCenter, max_str);
 
   // Draw set speed
   QString setSpeedStr = is_cruise_set ? QString::number(std::nearbyint(set_speed)) : "–";
   p.setFont(InterFont(90, QFont::Bold));
   p.setPen(set_speed_color);
-  p.drawText(set_speed_rect.adjusted(0, 77, 0, 0), Qt::AlignTop | Qt::AlignHCenter, setSpeedStr);
+  text_cache.draw(p, set_speed_rect.adjusted(0, 77, 0, 0), Qt::AlignTop | Qt::AlignHCenter, setSpeedStr);
 }
 
 void HudRendererSP::drawE2eAlert(QPainter &p, const QRect &surface_rect, const QString &alert_alt_text) {
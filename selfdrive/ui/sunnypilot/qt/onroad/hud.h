@@ -7,7 +7,12 @@
 
 #pragma once
 
+#include <utility>
+
+#include <QPainterPath>
+
 #include "selfdrive/ui/qt/onroad/hud.h"
+#include "selfdrive/ui/qt/util.h"
 #include "selfdrive/ui/sunnypilot/qt/offroad/settings/longitudinal/speed_limit/helpers.h"
 #include "selfdrive/ui/sunnypilot/qt/onroad/developer_ui/developer_ui.h"
 
@@ -28,6 +33,7 @@ private:
   int drawRightDevUIElement(QPainter &p, int x, int y, const QString &value, const QString &label, const QString &units, QColor &color);
   int drawBottomDevUIElement(QPainter &p, int x, int y, const QString &value, const QString &label, const QString &units, QColor &color);
   void drawBottomDevUI(QPainter &p, int x, int y);
+  void drawFrameBudget(QPainter &p);
   void drawStandstillTimer(QPainter &p, int x, int y);
   bool pulseElement(int frame);
   void drawSmartCruiseControlOnroadIcon(QPainter &p, const QRect &surface_rect, int x_offset, int y_offset, std::string name);
@@ -122,4 +128,7 @@ private:
   float speedCluster = 0;
   int icbm_active_counter = 0;
   bool pcmCruiseSpeed;
+
+  StaticTextCache text_cache;
+  QHash<QString, std::pair<QRectF, QPainterPath>> scc_icon_paths;
 };
@@ -34,11 +34,9 @@ void ModelRendererSP::draw(QPainter &painter, const QRect &surface_rect) {
   painter.save();
 
   const auto &model = sm["modelV2"].getModelV2();
-  const auto &radar_state = sm["radarState"].getRadarState();
-  const auto &lead_one = radar_state.getLeadOne();
   const auto &car_state = sm["carState"].getCarState();
 
-  update_model(model, lead_one);
+  // the geometry, blindspots included, is already up to date from ModelRenderer::draw
   drawLaneLines(painter);
 
   bool blindspot = s->scene.blindspot_ui;
@@ -171,10 +169,9 @@ void ModelRendererSP::drawLeadStatusPosition(QPainter &painter, const cereal::Ra
 
   if (text_lines.isEmpty()) return;
 
-  QFontMetrics fm(content_font);
   float text_width = 120.0f;
   for (const QString &line : text_lines) {
-    text_width = std::max(text_width, fm.horizontalAdvance(line) + 20.0f);
+    text_width = std::max<float>(text_width, text_cache.get(content_font, line).size().width() + 20.0f);
   }
   text_width = std::min(text_width, 250.0f);
 
@@ -202,9 +199,9 @@ void ModelRendererSP::drawLeadStatusPosition(QPainter &painter, const cereal::Ra
 
     // Draw shadow
     painter.setPen(QColor(0, 0, 0, (int)(200 * lead_status_alpha)));
-    painter.drawText(rect.translated(shadow_offset), Qt::AlignCenter, text_lines[i]);
+    text_cache.draw(painter, rect.translated(shadow_offset), Qt::AlignCenter, text_lines[i]);
     painter.setPen(text_color);
-    painter.drawText(rect, Qt::AlignCenter, text_lines[i]);
+    text_cache.draw(painter, rect, Qt::AlignCenter, text_lines[i]);
   }
 
   painter.setPen(Qt::NoPen);
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "selfdrive/ui/qt/onroad/model.h"
+#include "selfdrive/ui/qt/util.h"
 
 class ModelRendererSP : public ModelRenderer {
 public:
@@ -28,4 +29,5 @@ private:
 
   // Lead status animation
   float lead_status_alpha = 0.0f;
+  StaticTextCache text_cache;
 };
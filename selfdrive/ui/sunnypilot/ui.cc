@@ -8,6 +8,7 @@
 #include "selfdrive/ui/sunnypilot/ui.h"
 
 #include "common/watchdog.h"
+#include "selfdrive/ui/qt/profiler.h"
 
 void UIStateSP::updateStatus() {
   UIState::updateStatus();
@@ -48,6 +49,8 @@ UIStateSP::UIStateSP(QObject *parent) : UIState(parent) {
 
 // This method overrides completely the update method from the parent class intentionally.
 void UIStateSP::update() {
+  UIProfiler::instance().tick(scene.started);
+  UIProfileScope profile(UIProfiler::UPDATE);
   update_sockets(this);
   update_state(this);
   updateStatus();
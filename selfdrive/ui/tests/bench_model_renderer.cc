@@ -0,0 +1,183 @@
+// Paint time of the onroad model overlay and of HUD text on the offscreen Qt platform. The
+// model is redrawn with a new frame every paint, with the cached geometry of an unchanged
+// frame, and with the per point projection update_model did before.
+//
+// usage: bench_model_renderer [--iterations N]
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <QApplication>
+#include <QImage>
+
+#include "common/timing.h"
+#include "selfdrive/ui/qt/onroad/model.h"
+#include "selfdrive/ui/qt/util.h"
+
+const int W = 2160;
+const int H = 1080;
+const int IDX_N = 33;
+
+class BenchModelRenderer : public ModelRenderer {
+public:
+  BenchModelRenderer() {
+    experimental_mode = true;
+    // the road camera seen through the default calibration, as AnnotatedCameraWidget sets it up
+    const Eigen::Matrix3f video_transform = (Eigen::Matrix3f() <<
+      1.1f, 0.0f, W / 2 - FCAM_INTRINSIC_MATRIX(0, 2) * 1.1f,
+      0.0f, 1.1f, H / 2 - FCAM_INTRINSIC_MATRIX(1, 2) * 1.1f,
+      0.0f, 0.0f, 1.0f).finished();
+    setTransform(video_transform * FCAM_INTRINSIC_MATRIX * VIEW_FROM_DEVICE);
+    clip_region = QRectF(0, 0, W, H).adjusted(-CLIP_MARGIN, -CLIP_MARGIN, CLIP_MARGIN, CLIP_MARGIN);
+  }
+
+  void paint(QPainter &p, const cereal::ModelDataV2::Reader &model, const cereal::RadarState::LeadData::Reader &lead) {
+    update_geometry(model, lead);
+    drawLaneLines(p);
+    drawPath(p, model, H);
+  }
+
+  // mapLineToPolygon before the projection was batched
+  void referenceMapLine(const cereal::XYZTData::Reader &line, float y_off, float z_off, QPolygonF *pvd, int max_idx, bool allow_invert = true) {
+    const auto line_x = line.getX(), line_y = line.getY(), line_z = line.getZ();
+    QPointF left, right;
+    pvd->clear();
+    for (int i = 0; i <= max_idx; i++) {
+      if (line_x[i] < 0) continue;
+      bool l = mapToScreen(line_x[i], line_y[i] - y_off, line_z[i] + z_off, &left);
+      bool r = mapToScreen(line_x[i], line_y[i] + y_off, line_z[i] + z_off, &right);
+      if (l && r) {
+        if (!allow_invert && pvd->size() && left.y() > pvd->back().y()) continue;
+        pvd->push_back(left);
+        pvd->push_front(right);
+      }
+    }
+  }
+
+  void referencePaint(QPainter &p, const cereal::ModelDataV2::Reader &model, const cereal::RadarState::LeadData::Reader &lead) {
+    const auto &model_position = model.getPosition();
+    float max_distance = std::clamp(*(model_position.getX().end() - 1), MIN_DRAW_DISTANCE, MAX_DRAW_DISTANCE);
+    const auto &lane_lines = model.getLaneLines();
+    int max_idx = get_path_length_idx(lane_lines[0], max_distance);
+    for (int i = 0; i < std::size(lane_line_vertices); i++) {
+      lane_line_probs[i] = model.getLaneLineProbs()[i];
+      referenceMapLine(lane_lines[i], 0.025 * lane_line_probs[i], 0, &lane_line_vertices[i], max_idx);
+    }
+    for (int i = 0; i < std::size(road_edge_vertices); i++) {
+      road_edge_stds[i] = model.getRoadEdgeStds()[i];
+      referenceMapLine(model.getRoadEdges()[i], 0.025, 0, &road_edge_vertices[i], max_idx);
+    }
+    const float lead_d = lead.getDRel() * 2.;
+    max_distance = std::clamp((float)(lead_d - fmin(lead_d * 0.35, 10.)), 0.0f, max_distance);
+    referenceMapLine(model_position, 0.9, path_offset_z, &track_vertices, get_path_length_idx(model_position, max_distance), false);
+    drawLaneLines(p);
+    // rebuilt every paint like before
+    path_brush_key = {};
+    drawPath(p, model, H);
+  }
+};
+
+static void fill_line(cereal::XYZTData::Builder line, float y, float curvature) {
+  auto x = line.initX(IDX_N), ys = line.initY(IDX_N), z = line.initZ(IDX_N);
+  for (int i = 0; i < IDX_N; ++i) {
+    // the model's quadratic spacing out to 192m
+    const float d = 192.0f * (i / (IDX_N - 1.0f)) * (i / (IDX_N - 1.0f));
+    x.set(i, d);
+    ys.set(i, y + curvature * d * d);
+    z.set(i, 0.02f * d);
+  }
+}
+
+template <class F>
+static double measure_us(int iterations, F &&f) {
+  double best = 1e9;
+  for (int i = 0; i < iterations; i += 10) {
+    const uint64_t start = nanos_since_boot();
+    for (int j = 0; j < 10; ++j) f();
+    best = std::min(best, (nanos_since_boot() - start) / 1e3 / 10);
+  }
+  return best;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = 200;
+  const option opts[] = {
+    {"iterations", required_argument, nullptr, 'n'},
+    {nullptr, 0, nullptr, 0},
+  };
+  for (int opt; (opt = getopt_long(argc, argv, "", opts, nullptr)) != -1;) {
+    switch (opt) {
+      case 'n': iterations = std::max(atoi(optarg), 10); break;
+      default:
+        fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  setenv("QT_QPA_PLATFORM", "offscreen", 0);
+  QApplication app(argc, argv);
+
+  MessageBuilder msg;
+  auto model = msg.initEvent().initModelV2();
+  fill_line(model.initPosition(), 0.0f, 2e-4f);
+  auto lane_lines = model.initLaneLines(4);
+  const float lane_y[] = {-5.4f, -1.8f, 1.8f, 5.4f};
+  for (int i = 0; i < 4; ++i) fill_line(lane_lines[i], lane_y[i], 2e-4f);
+  auto road_edges = model.initRoadEdges(2);
+  fill_line(road_edges[0], -7.0f, 2e-4f);
+  fill_line(road_edges[1], 7.0f, 2e-4f);
+  auto probs = model.initLaneLineProbs(4);
+  auto stds = model.initRoadEdgeStds(2);
+  for (int i = 0; i < 4; ++i) probs.set(i, 0.9f);
+  for (int i = 0; i < 2; ++i) stds.set(i, 0.3f);
+  auto accel = model.initAcceleration().initX(IDX_N);
+  for (int i = 0; i < IDX_N; ++i) accel.set(i, std::sin(i * 0.3f));
+
+  MessageBuilder radar_msg;
+  auto lead = radar_msg.initEvent().initRadarState().initLeadOne();
+  lead.setStatus(true);
+  lead.setDRel(60.0f);
+
+  QImage image(W, H, QImage::Format_ARGB32_Premultiplied);
+  QPainter p(&image);
+  p.setRenderHint(QPainter::Antialiasing);
+  p.setPen(Qt::NoPen);
+
+  BenchModelRenderer renderer;
+  uint32_t frame_id = 0;
+  const double new_frame = measure_us(iterations, [&]() {
+    model.setFrameId(++frame_id);
+    renderer.paint(p, model.asReader(), lead.asReader());
+  });
+  const double same_frame = measure_us(iterations, [&]() { renderer.paint(p, model.asReader(), lead.asReader()); });
+  const double reference = measure_us(iterations, [&]() { renderer.referencePaint(p, model.asReader(), lead.asReader()); });
+
+  printf("model, per paint:\n");
+  printf("  per point projection  %8.1f us\n", reference);
+  printf("  new frame             %8.1f us\n", new_frame);
+  printf("  same frame            %8.1f us\n", same_frame);
+
+  // a screen of dev UI values, most of them the same as the frame before
+  StaticTextCache text_cache;
+  p.setFont(InterFont(38, QFont::Bold));
+  p.setPen(Qt::white);
+  int frame = 0;
+  auto value = [&](int i) { return QString::number((frame / 20 + i * 7) % 150); };
+  const double text_draw = measure_us(iterations, [&]() {
+    ++frame;
+    for (int i = 0; i < 24; ++i) p.drawText(QRect(40 + (i % 4) * 400, 60 + (i / 4) * 60, 300, 50), Qt::AlignCenter, value(i));
+  });
+  const double text_cached = measure_us(iterations, [&]() {
+    ++frame;
+    for (int i = 0; i < 24; ++i) text_cache.draw(p, QRect(40 + (i % 4) * 400, 60 + (i / 4) * 60, 300, 50), Qt::AlignCenter, value(i));
+  });
+
+  printf("hud text, 24 values per paint:\n");
+  printf("  QPainter::drawText    %8.1f us\n", text_draw);
+  printf("  StaticTextCache       %8.1f us\n", text_cached);
+  return 0;
+}
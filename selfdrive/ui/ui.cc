@@ -9,6 +9,7 @@
 #include "common/swaglog.h"
 #include "common/util.h"
 #include "common/watchdog.h"
+#include "qt/profiler.h"
 #include "qt/util.h"
 #include "system/hardware/hw.h"
 
@@ -16,6 +17,7 @@
 #define BACKLIGHT_TS 10.00
 
 void update_sockets(UIState *s) {
+  UIProfileScope profile(UIProfiler::UPDATE_SOCKETS);
   s->sm->update(0);
 }
 
@@ -132,6 +134,8 @@ UIState::UIState(QObject *parent) : QObject(parent) {
 
 void UIState::update() {
 #ifndef SUNNYPILOT
+  UIProfiler::instance().tick(scene.started);
+  UIProfileScope profile(UIProfiler::UPDATE);
   update_sockets(this);
   update_state(this);
   updateStatus();
@@ -16,7 +16,7 @@ ModelFrame::ModelFrame(cl_device_id device_id, cl_context context) {
   net_input_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, MODEL_FRAME_SIZE * sizeof(float), NULL, &err));
 
   transform_init(&transform, context, device_id);
-  loadyuv_init(&loadyuv, context, device_id, MODEL_WIDTH, MODEL_HEIGHT);
+  loadyuv_init(&loadyuv, context, device_id, MODEL_WIDTH, MODEL_HEIGHT, true);
 }
 
 float* ModelFrame::prepare(cl_mem yuv_cl, int frame_width, int frame_height, int frame_stride, int frame_uv_offset, const mat3 &projection, cl_mem *output) {
@@ -32,7 +32,9 @@ float* ModelFrame::prepare(cl_mem yuv_cl, int frame_width, int frame_height, int
     clFinish(q);
     return &input_frames[0];
   } else {
-    loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, *output, true);
+    // shift the image in slot 1 to slot 0, then place the new image in slot 1
+    copy_queue(&loadyuv, q, *output, *output, MODEL_FRAME_SIZE, 0, MODEL_FRAME_SIZE);
+    loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, *output, MODEL_FRAME_SIZE);
     // NOTE: Since thneed is using a different command queue, this clFinish is needed to ensure the image is ready.
     clFinish(q);
     return NULL;
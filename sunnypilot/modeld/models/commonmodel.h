@@ -13,8 +13,8 @@
 #endif
 
 #include "common/mat.h"
-#include "sunnypilot/modeld/transforms/loadyuv.h"
-#include "sunnypilot/modeld/transforms/transform.h"
+#include "selfdrive/modeld/transforms/loadyuv.h"
+#include "selfdrive/modeld/transforms/transform.h"
 
 class ModelFrame {
 public:
@@ -1,5 +1,7 @@
 # distutils: language = c++
 
+from libcpp cimport bool
+
 from msgq.visionipc.visionipc cimport cl_device_id, cl_context, cl_mem
 
 cdef extern from "common/mat.h":
@@ -12,15 +14,17 @@ cdef extern from "common/clutil.h":
   cl_context cl_create_context(cl_device_id)
   void cl_release_context(cl_context)
 
-cdef extern from "sunnypilot/modeld_v2/models/commonmodel.h":
+cdef extern from "selfdrive/modeld/models/commonmodel.h":
   cppclass ModelFrame:
     int buf_size
+    bool cpu
     unsigned char * buffer_from_cl(cl_mem*, int);
+    unsigned char * prepare_cpu(const unsigned char*, int, int, int, int, mat3)
     cl_mem * prepare(cl_mem, int, int, int, int, mat3)
 
   cppclass DrivingModelFrame:
     int buf_size
-    DrivingModelFrame(cl_device_id, cl_context, unsigned char)
+    DrivingModelFrame(cl_device_id, cl_context, int)
 
   cppclass MonitoringModelFrame:
     int buf_size
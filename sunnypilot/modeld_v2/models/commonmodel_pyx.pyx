@@ -47,6 +47,10 @@ cdef class ModelFrame:
     cdef mat3 cprojection
     memcpy(cprojection.v, &projection[0], 9*sizeof(float))
     cdef cl_mem * data
+    if self.frame.cpu:
+      # the frame is already in input_frames, buffer_from_cl only returns it
+      self.frame.prepare_cpu(<unsigned char*>buf.buf.addr, buf.width, buf.height, buf.stride, buf.uv_offset, cprojection)
+      return CLMem.create(NULL)
     data = self.frame.prepare(buf.buf.buf_cl, buf.width, buf.height, buf.stride, buf.uv_offset, cprojection)
     return CLMem.create(data)
 
@@ -60,7 +64,8 @@ cdef class DrivingModelFrame(ModelFrame):
   cdef cppDrivingModelFrame * _frame
 
   def __cinit__(self, CLContext context, int buffer_length=2):
-    self._frame = new cppDrivingModelFrame(context.device_id, context.context, buffer_length)
+    # the input pairs the newest frame with the oldest of buffer_length frames
+    self._frame = new cppDrivingModelFrame(context.device_id, context.context, buffer_length - 1)
     self.frame = <cppModelFrame*>(self._frame)
     self.buf_size = self._frame.buf_size
 
@@ -33,7 +33,7 @@ public:
   int locationd_thread();
 
   void reset_kalman(double current_time = NAN);
-  void reset_kalman(double current_time, const Eigen::VectorXd &init_orient, const Eigen::VectorXd &init_pos, const Eigen::VectorXd &init_vel, const MatrixXdr &init_pos_R, const MatrixXdr &init_vel_R);
+  void reset_kalman(double current_time, const Eigen::Vector4d &init_orient, const Eigen::Vector3d &init_pos, const Eigen::Vector3d &init_vel, const Matrix3dr &init_pos_R, const Matrix3dr &init_vel_R);
   void reset_kalman(double current_time, const Eigen::VectorXd &init_x, const MatrixXdr &init_P);
   void finite_check(double current_time = NAN);
   void time_check(double current_time = NAN);
@@ -46,10 +46,13 @@ public:
   void observation_timings_invalid_reset();
 
   kj::ArrayPtr<capnp::byte> get_message_bytes(MessageBuilder& msg_builder,
-    bool inputsOK, bool sensorsOK, bool gpsOK, bool msgValid);
+    bool inputsOK, bool sensorsOK, bool gpsOK, bool msgValid, uint64_t log_mono_time = 0);
+  // liveLocationKalman for a cameraOdometry message. offline stamps the output with the trigger's time
+  kj::ArrayPtr<capnp::byte> handle_trigger(MessageBuilder& msg_builder, const cereal::Event::Reader& trigger,
+    bool inputsValid, bool sensorsOK, bool msgValid, bool offline = false);
   void build_live_location(cereal::LiveLocationKalman::Builder& fix);
 
-  Eigen::VectorXd get_position_geodetic();
+  Eigen::Vector3d get_position_geodetic();
   Eigen::VectorXd get_state();
   Eigen::VectorXd get_stdev();
 
@@ -67,9 +70,9 @@ public:
 private:
   std::unique_ptr<LiveKalman> kf;
 
-  Eigen::VectorXd calib;
-  MatrixXdr device_from_calib;
-  MatrixXdr calib_from_device;
+  Eigen::Vector3d calib;
+  Eigen::Matrix3d device_from_calib;
+  Eigen::Matrix3d calib_from_device;
   bool calibrated = false;
 
   double car_speed = 0.0;
@@ -94,7 +97,7 @@ private:
   float gps_variance_factor;
   float gps_vertical_variance_factor;
   double gps_time_offset;
-  Eigen::VectorXd camodo_yawrate_distribution = Eigen::Vector2d(0.0, 10.0); // mean, std
+  Eigen::Vector2d camodo_yawrate_distribution = Eigen::Vector2d(0.0, 10.0); // mean, std
 
   void configure_gnss_source(const LocalizerGnssSource &source);
 };
@@ -0,0 +1,281 @@
+// Runs the Localizer over logs without replaying them in real time.
+// Each log is read with LogReader and its events are fed to a Localizer in mono_time order,
+// with the same input gating locationd_thread gets from SubMaster. The logs are grouped by
+// route, and the segments of a route go through one Localizer in order, so the filter carries
+// over between segments like on the device. Routes are processed in parallel, one per worker
+// thread at a time, and a missing segment starts a new filter.
+//
+// usage: locationd_batch [-j THREADS] [-o OUTPUT_DIR] [--csv] LOG...
+//   LOG is an rlog path or url (.bz2/.zst ok). The liveLocationKalman events are written to
+//   OUTPUT_DIR/<log>.llk as a raw log, or as one csv row per event with --csv.
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cereal/services.h"
+#include "sunnypilot/selfdrive/locationd/locationd.h"
+#include "tools/replay/logreader.h"
+
+struct BatchConfig {
+  int threads = std::max(1U, std::thread::hardware_concurrency());
+  std::string output_dir = ".";
+  bool csv = false;
+};
+
+// alive/valid tracking of SubMaster, with the log time as the clock
+class InputTracker {
+public:
+  InputTracker(const std::string &gps_service) {
+    for (auto name : {gps_service.c_str(), "cameraOdometry", "liveCalibration", "carState", "accelerometer", "gyroscope"}) {
+      inputs.push_back({.name = name, .freq = services.at(name).frequency, .ignore_alive = name == gps_service});
+    }
+  }
+
+  void update(const std::string &name, uint64_t mono_time, bool valid) {
+    current_time = mono_time;
+    for (auto &input : inputs) {
+      if (input.name == name) {
+        input.rcv_time = mono_time;
+        input.valid = valid;
+      }
+    }
+  }
+
+  bool all(bool valid, bool alive, const std::vector<std::string> &names = {}) const {
+    for (auto &input : inputs) {
+      if (!names.empty() && std::find(names.begin(), names.end(), input.name) == names.end()) continue;
+      bool is_alive = input.freq <= 1e-5 || ((current_time - input.rcv_time) * 1e-9) < (10.0 / input.freq);
+      if ((valid && !input.valid) || (alive && !(is_alive || input.ignore_alive))) return false;
+    }
+    return true;
+  }
+
+private:
+  struct Input {
+    std::string name;
+    float freq;
+    bool ignore_alive;
+    bool valid = false;
+    uint64_t rcv_time = 0;
+  };
+  std::vector<Input> inputs;
+  uint64_t current_time = 0;
+};
+
+static const std::pair<cereal::Event::Which, const char *> INPUTS[] = {
+  {cereal::Event::Which::GPS_LOCATION_EXTERNAL, "gpsLocationExternal"},
+  {cereal::Event::Which::GPS_LOCATION, "gpsLocation"},
+  {cereal::Event::Which::CAMERA_ODOMETRY, "cameraOdometry"},
+  {cereal::Event::Which::LIVE_CALIBRATION, "liveCalibration"},
+  {cereal::Event::Which::CAR_STATE, "carState"},
+  {cereal::Event::Which::ACCELEROMETER, "accelerometer"},
+  {cereal::Event::Which::GYROSCOPE, "gyroscope"},
+};
+
+static void write_csv_header(std::ofstream &out) {
+  out << "mono_time,status,inputs_ok,sensors_ok,gps_ok,posenet_ok,device_stable,"
+         "lat,lon,alt,pos_std_x,pos_std_y,pos_std_z,v_n,v_e,v_d,roll,pitch,yaw,"
+         "calib_roll,calib_pitch,calib_yaw,yaw_rate,accel_x,accel_y,accel_z\n";
+}
+
+static void write_csv_row(std::ofstream &out, const cereal::Event::Reader &event) {
+  auto llk = event.getLiveLocationKalman();
+  char buf[64];
+  out << event.getLogMonoTime() << ',' << (int)llk.getStatus() << ',' << llk.getInputsOK() << ',' << llk.getSensorsOK() << ','
+      << llk.getGpsOK() << ',' << llk.getPosenetOK() << ',' << llk.getDeviceStable();
+  auto values = [&](const cereal::LiveLocationKalman::Measurement::Reader &m, bool stdev = false) {
+    auto v = stdev ? m.getStd() : m.getValue();
+    for (int i = 0; i < 3; ++i) {
+      snprintf(buf, sizeof(buf), ",%.9g", i < v.size() ? v[i] : NAN);
+      out << buf;
+    }
+  };
+  values(llk.getPositionGeodetic());
+  values(llk.getPositionECEF(), true);
+  values(llk.getVelocityNED());
+  values(llk.getOrientationNED());
+  values(llk.getCalibratedOrientationNED());
+  auto ang_vel = llk.getAngularVelocityCalibrated().getValue();
+  snprintf(buf, sizeof(buf), ",%.9g", ang_vel.size() == 3 ? ang_vel[2] : NAN);
+  out << buf;
+  values(llk.getAccelerationCalibrated());
+  out << '\n';
+}
+
+static std::string output_name(const std::string &log) {
+  std::string name = log;
+  for (auto prefix : {"https://", "http://", "file://"}) {
+    if (util::starts_with(name, prefix)) name = name.substr(strlen(prefix));
+  }
+  std::replace_if(name.begin(), name.end(), [](char c) { return c == '/' || c == ':' || c == '?'; }, '_');
+  name.erase(0, name.find_first_not_of('_'));
+  return name;
+}
+
+struct RouteLogs {
+  std::string name;
+  // segment number and log, in order
+  std::vector<std::pair<int, std::string>> segments;
+};
+
+// groups logs by the route name in their path or url, logs without one are a route of their own
+static std::vector<RouteLogs> group_by_route(const std::vector<std::string> &logs) {
+  static const std::regex pattern(R"((([a-z0-9]{16})[|_/])?(\d{4}-\d{2}-\d{2}--\d{2}-\d{2}-\d{2}|[0-9a-f]{8}--[0-9a-f]{10})(--|/)(\d+))");
+  std::map<std::string, RouteLogs> routes;
+  for (const auto &log : logs) {
+    std::smatch match;
+    if (std::regex_search(log, match, pattern)) {
+      const std::string name = match[2].str() + "|" + match[3].str();
+      routes[name].name = name;
+      routes[name].segments.push_back({std::stoi(match[5].str()), log});
+    } else {
+      routes[log] = {.name = log, .segments = {{0, log}}};
+    }
+  }
+
+  std::vector<RouteLogs> result;
+  for (auto &[_, route] : routes) {
+    std::stable_sort(route.segments.begin(), route.segments.end(), [](auto &l, auto &r) { return l.first < r.first; });
+    result.push_back(std::move(route));
+  }
+  return result;
+}
+
+// The Localizer and input state of a route, carried from one segment to the next
+struct RouteState {
+  std::unique_ptr<Localizer> localizer;
+  std::unique_ptr<InputTracker> inputs;
+  std::string gps_service;
+  bool filter_initialized = false;
+  int last_segment = -1;
+};
+
+// returns the number of liveLocationKalman events written, or -1 if the log couldn't be read
+static int run_log(const std::string &log, int segment, RouteState &state, const BatchConfig &config) {
+  std::vector<bool> filters(capnp::Schema::from<cereal::Event>().asStruct().getUnionFields().size(), false);
+  for (auto &[which, name] : INPUTS) filters[which] = true;
+
+  LogReader reader(filters);
+  if (!reader.load(log)) {
+    return -1;
+  }
+
+  // a gap in the route restarts the filter, the same as starting locationd on that segment
+  if (!state.localizer || segment != state.last_segment + 1) {
+    bool ublox = std::any_of(reader.events.begin(), reader.events.end(), [](const Event &e) {
+      return e.which == cereal::Event::Which::GPS_LOCATION_EXTERNAL;
+    });
+    state.gps_service = ublox ? "gpsLocationExternal" : "gpsLocation";
+    state.localizer = std::make_unique<Localizer>(ublox ? LocalizerGnssSource::UBLOX : LocalizerGnssSource::QCOM);
+    state.inputs = std::make_unique<InputTracker>(state.gps_service);
+    state.filter_initialized = false;
+  }
+  state.last_segment = segment;
+  Localizer &localizer = *state.localizer;
+  InputTracker &inputs = *state.inputs;
+
+  const std::string path = config.output_dir + "/" + output_name(log) + (config.csv ? ".csv" : ".llk");
+  std::ofstream out(path, std::ios::binary);
+  if (config.csv) write_csv_header(out);
+
+  int count = 0;
+  bool &filter_initialized = state.filter_initialized;
+  AlignedBuffer aligned_buf;
+  for (const Event &e : reader.events) {
+    auto input = std::find_if(std::begin(INPUTS), std::end(INPUTS), [&](auto &i) { return i.first == e.which; });
+    if (input == std::end(INPUTS)) continue;
+    // locationd only subscribes to one of the gps services
+    const bool is_gps = e.which == cereal::Event::Which::GPS_LOCATION || e.which == cereal::Event::Which::GPS_LOCATION_EXTERNAL;
+    if (is_gps && input->second != state.gps_service) continue;
+
+    capnp::FlatArrayMessageReader msg(e.data);
+    cereal::Event::Reader event = msg.getRoot<cereal::Event>();
+    inputs.update(input->second, e.mono_time, event.getValid());
+
+    if (filter_initialized) {
+      localizer.observation_timings_invalid_reset();
+      if (event.getValid()) {
+        localizer.handle_msg(event);
+      }
+    } else {
+      filter_initialized = inputs.all(true, true);
+    }
+
+    if (e.which == cereal::Event::Which::CAMERA_ODOMETRY) {
+      MessageBuilder msg_builder;
+      bool sensors_ok = inputs.all(true, true, {"accelerometer", "gyroscope"});
+      auto bytes = localizer.handle_trigger(msg_builder, event, inputs.all(true, false), sensors_ok, filter_initialized, true);
+      if (config.csv) {
+        capnp::FlatArrayMessageReader llk(aligned_buf.align((const char *)bytes.begin(), bytes.size()));
+        write_csv_row(out, llk.getRoot<cereal::Event>());
+      } else {
+        out.write((const char *)bytes.begin(), bytes.size());
+      }
+      count++;
+    }
+  }
+  return count;
+}
+
+int main(int argc, char *argv[]) {
+  BatchConfig config;
+  const option opts[] = {
+    {"threads", required_argument, nullptr, 'j'},
+    {"output", required_argument, nullptr, 'o'},
+    {"csv", no_argument, nullptr, 'c'},
+    {nullptr, 0, nullptr, 0},
+  };
+  for (int opt; (opt = getopt_long(argc, argv, "j:o:", opts, nullptr)) != -1;) {
+    switch (opt) {
+      case 'j': config.threads = std::max(1, atoi(optarg)); break;
+      case 'o': config.output_dir = optarg; break;
+      case 'c': config.csv = true; break;
+      default:
+        fprintf(stderr, "usage: %s [-j THREADS] [-o OUTPUT_DIR] [--csv] LOG...\n", argv[0]);
+        return 1;
+    }
+  }
+  const std::vector<std::string> logs(argv + optind, argv + argc);
+  if (logs.empty() || !util::create_directories(config.output_dir, 0775)) {
+    fprintf(stderr, "usage: %s [-j THREADS] [-o OUTPUT_DIR] [--csv] LOG...\n", argv[0]);
+    return 1;
+  }
+
+  const std::vector<RouteLogs> routes = group_by_route(logs);
+  std::atomic<size_t> next = 0;
+  std::atomic<int> failed = 0;
+  std::vector<std::thread> workers;
+  const double start = millis_since_boot();
+  for (int i = 0; i < std::min<int>(config.threads, routes.size()); ++i) {
+    workers.emplace_back([&]() {
+      for (size_t idx; (idx = next++) < routes.size();) {
+        RouteState state;
+        for (const auto &[segment, log] : routes[idx].segments) {
+          double t = millis_since_boot();
+          int count = run_log(log, segment, state, config);
+          if (count < 0) {
+            fprintf(stderr, "failed to read %s\n", log.c_str());
+            failed++;
+          } else {
+            printf("%s: %d liveLocationKalman in %.1f s\n", log.c_str(), count, (millis_since_boot() - t) / 1000.0);
+          }
+        }
+      }
+    });
+  }
+  for (auto &w : workers) w.join();
+
+  printf("%zu logs of %zu routes in %.1f s, %d failed\n", logs.size(), routes.size(), (millis_since_boot() - start) / 1000.0, failed.load());
+  return failed > 0;
+}
@@ -49,24 +49,33 @@ LiveKalman::LiveKalman() {
 
 void LiveKalman::init_state(const VectorXd &state, const VectorXd &covs_diag, double filter_time) {
   MatrixXdr covs = covs_diag.asDiagonal();
-  this->filter->init_state(get_mapvec(state), get_mapmat(covs), filter_time);
+  this->init_state(state, covs, filter_time);
 }
 
 void LiveKalman::init_state(const VectorXd &state, const MatrixXdr &covs, double filter_time) {
   this->filter->init_state(get_mapvec(state), get_mapmat(covs), filter_time);
+  this->x_cached = this->P_cached = false;
 }
 
 void LiveKalman::init_state(const VectorXd &state, double filter_time) {
   MatrixXdr covs = this->filter->covs();
-  this->filter->init_state(get_mapvec(state), get_mapmat(covs), filter_time);
+  this->init_state(state, covs, filter_time);
 }
 
-VectorXd LiveKalman::get_x() {
-  return this->filter->state();
+const LiveState &LiveKalman::get_x() {
+  if (!this->x_cached) {
+    this->x = this->filter->state();
+    this->x_cached = true;
+  }
+  return this->x;
 }
 
-MatrixXdr LiveKalman::get_P() {
-  return this->filter->covs();
+const LiveCov &LiveKalman::get_P() {
+  if (!this->P_cached) {
+    this->P = this->filter->covs();
+    this->P_cached = true;
+  }
+  return this->P;
 }
 
 double LiveKalman::get_filter_time() {
@@ -87,11 +96,22 @@ std::optional<Estimate> LiveKalman::predict_and_observe(double t, int kind, cons
     R = this->get_R(kind, meas.size());
   }
   r = this->filter->predict_and_update_batch(t, kind, get_vec_mapvec(meas), get_vec_mapmat(R));
+  this->x_cached = this->P_cached = false;
+  return r;
+}
+
+std::optional<Estimate> LiveKalman::predict_and_observe_single(double t, int kind, const double *meas, const double *R, int n) {
+  // the filter takes its batch by value, so these are the only allocations left per observation
+  std::vector<Map<VectorXd>> meas_map{Map<VectorXd>((double*)meas, n)};
+  std::vector<Map<MatrixXdr>> R_map{Map<MatrixXdr>((double*)R, n, n)};
+  std::optional<Estimate> r = this->filter->predict_and_update_batch(t, kind, std::move(meas_map), std::move(R_map));
+  this->x_cached = this->P_cached = false;
   return r;
 }
 
 void LiveKalman::predict(double t) {
   this->filter->predict(t);
+  this->x_cached = this->P_cached = false;
 }
 
 const Eigen::VectorXd &LiveKalman::get_initial_x() {
@@ -102,11 +122,11 @@ const MatrixXdr &LiveKalman::get_initial_P() {
   return this->initial_P;
 }
 
-const MatrixXdr &LiveKalman::get_fake_gps_pos_cov() {
+const Matrix3dr &LiveKalman::get_fake_gps_pos_cov() {
   return this->fake_gps_pos_cov;
 }
 
-const MatrixXdr &LiveKalman::get_fake_gps_vel_cov() {
+const Matrix3dr &LiveKalman::get_fake_gps_vel_cov() {
   return this->fake_gps_vel_cov;
 }
 
@@ -114,8 +134,7 @@ const MatrixXdr &LiveKalman::get_reset_orientation_P() {
   return this->reset_orientation_P;
 }
 
-MatrixXdr LiveKalman::H(const VectorXd &in) {
-  assert(in.size() == 6);
+Matrix<double, 3, 6, Eigen::RowMajor> LiveKalman::H(const Matrix<double, 6, 1> &in) {
   Matrix<double, 3, 6, Eigen::RowMajor> res;
   this->filter->get_extra_routine("H")((double*)in.data(), res.data());
   return res;
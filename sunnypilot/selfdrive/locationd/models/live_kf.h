@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <string>
 #include <cmath>
 #include <memory>
@@ -16,6 +17,10 @@
 
 using namespace EKFS;
 
+typedef Eigen::Matrix<double, LIVE_DIM_STATE, 1> LiveState;
+typedef Eigen::Matrix<double, LIVE_DIM_STATE_ERR, LIVE_DIM_STATE_ERR, Eigen::RowMajor> LiveCov;
+typedef Eigen::Matrix<double, 3, 3, Eigen::RowMajor> Matrix3dr;
+
 Eigen::Map<Eigen::VectorXd> get_mapvec(const Eigen::VectorXd &vec);
 Eigen::Map<MatrixXdr> get_mapmat(const MatrixXdr &mat);
 std::vector<Eigen::Map<Eigen::VectorXd>> get_vec_mapvec(const std::vector<Eigen::VectorXd> &vec_vec);
@@ -23,18 +28,33 @@ std::vector<Eigen::Map<MatrixXdr>> get_vec_mapmat(const std::vector<MatrixXdr> &
 
 class LiveKalman {
 public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   LiveKalman();
 
   void init_state(const Eigen::VectorXd &state, const Eigen::VectorXd &covs_diag, double filter_time);
   void init_state(const Eigen::VectorXd &state, const MatrixXdr &covs, double filter_time);
   void init_state(const Eigen::VectorXd &state, double filter_time);
 
-  Eigen::VectorXd get_x();
-  MatrixXdr get_P();
+  // cached until the filter changes, valid until the next predict/observe/init_state
+  const LiveState &get_x();
+  const LiveCov &get_P();
   double get_filter_time();
   std::vector<MatrixXdr> get_R(int kind, int n);
 
   std::optional<Estimate> predict_and_observe(double t, int kind, const std::vector<Eigen::VectorXd> &meas, std::vector<MatrixXdr> R = {});
+  // single fixed size measurement, mapped into the filter without copying it
+  template <int N>
+  std::optional<Estimate> predict_and_observe(double t, int kind, const Eigen::Matrix<double, N, 1> &meas) {
+    const MatrixXdr &R = this->obs_noise.at(kind);
+    assert(R.rows() == N && R.cols() == N);
+    return this->predict_and_observe_single(t, kind, meas.data(), R.data(), N);
+  }
+  template <int N>
+  std::optional<Estimate> predict_and_observe(double t, int kind, const Eigen::Matrix<double, N, 1> &meas,
+                                              const Eigen::Matrix<double, N, N, Eigen::RowMajor> &R) {
+    return this->predict_and_observe_single(t, kind, meas.data(), R.data(), N);
+  }
   std::optional<Estimate> predict_and_update_odo_speed(std::vector<Eigen::VectorXd> speed, double t, int kind);
   std::optional<Estimate> predict_and_update_odo_trans(std::vector<Eigen::VectorXd> trans, double t, int kind);
   std::optional<Estimate> predict_and_update_odo_rot(std::vector<Eigen::VectorXd> rot, double t, int kind);
@@ -42,13 +62,15 @@ public:
 
   const Eigen::VectorXd &get_initial_x();
   const MatrixXdr &get_initial_P();
-  const MatrixXdr &get_fake_gps_pos_cov();
-  const MatrixXdr &get_fake_gps_vel_cov();
+  const Matrix3dr &get_fake_gps_pos_cov();
+  const Matrix3dr &get_fake_gps_vel_cov();
   const MatrixXdr &get_reset_orientation_P();
 
-  MatrixXdr H(const Eigen::VectorXd &in);
+  Eigen::Matrix<double, 3, 6, Eigen::RowMajor> H(const Eigen::Matrix<double, 6, 1> &in);
 
 private:
+  std::optional<Estimate> predict_and_observe_single(double t, int kind, const double *meas, const double *R, int n);
+
   std::string name = "live";
 
   std::shared_ptr<EKFSym> filter;
@@ -58,9 +80,14 @@ private:
 
   Eigen::VectorXd initial_x;
   MatrixXdr initial_P;
-  MatrixXdr fake_gps_pos_cov;
-  MatrixXdr fake_gps_vel_cov;
+  Matrix3dr fake_gps_pos_cov;
+  Matrix3dr fake_gps_vel_cov;
   MatrixXdr reset_orientation_P;
   MatrixXdr Q;  // process noise
   std::unordered_map<int, MatrixXdr> obs_noise;
+
+  LiveState x;
+  LiveCov P;
+  bool x_cached = false;
+  bool P_cached = false;
 };
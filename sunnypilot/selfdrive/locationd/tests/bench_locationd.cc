@@ -0,0 +1,111 @@
+// Times the Localizer over the sensor stream of a recorded log.
+// Every input event is fed to handle_msg in log order, and every cameraOdometry also builds a
+// liveLocationKalman. Prints the time and allocations per update for each input kind.
+//
+// usage: bench_locationd [--repeat N] LOG
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/tests/alloc_counter.h"
+#include "sunnypilot/selfdrive/locationd/locationd.h"
+#include "tools/replay/logreader.h"
+
+struct Timings {
+  std::vector<double> times_us;
+  uint64_t allocs = 0;
+
+  void print(const char *name) {
+    if (times_us.empty()) return;
+    std::sort(times_us.begin(), times_us.end());
+    double sum = 0;
+    for (double t : times_us) sum += t;
+    printf("%-20s %8zu updates, avg %7.2f us, p99 %7.2f us, %6.2f allocations/update\n", name, times_us.size(),
+           sum / times_us.size(), times_us[(size_t)(0.99 * (times_us.size() - 1))], (double)allocs / times_us.size());
+  }
+};
+
+template <class F>
+static void measure(Timings &timings, F &&f) {
+  const uint64_t allocs_start = alloc_count;
+  const uint64_t start = nanos_since_boot();
+  f();
+  const uint64_t end = nanos_since_boot();
+  timings.allocs += alloc_count - allocs_start;
+  timings.times_us.push_back((end - start) / 1e3);
+}
+
+int main(int argc, char *argv[]) {
+  int repeat = 1;
+  const option opts[] = {
+    {"repeat", required_argument, nullptr, 'n'},
+    {nullptr, 0, nullptr, 0},
+  };
+  for (int opt; (opt = getopt_long(argc, argv, "", opts, nullptr)) != -1;) {
+    switch (opt) {
+      case 'n': repeat = std::max(atoi(optarg), 1); break;
+      default:
+        fprintf(stderr, "usage: %s [--repeat N] LOG\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "usage: %s [--repeat N] LOG\n", argv[0]);
+    return 1;
+  }
+
+  const std::map<cereal::Event::Which, const char *> inputs = {
+    {cereal::Event::Which::ACCELEROMETER, "accelerometer"},
+    {cereal::Event::Which::GYROSCOPE, "gyroscope"},
+    {cereal::Event::Which::CAR_STATE, "carState"},
+    {cereal::Event::Which::CAMERA_ODOMETRY, "cameraOdometry"},
+    {cereal::Event::Which::LIVE_CALIBRATION, "liveCalibration"},
+    {cereal::Event::Which::GPS_LOCATION, "gpsLocation"},
+    {cereal::Event::Which::GPS_LOCATION_EXTERNAL, "gpsLocationExternal"},
+  };
+  std::vector<bool> filters(capnp::Schema::from<cereal::Event>().asStruct().getUnionFields().size(), false);
+  for (auto &[which, name] : inputs) filters[which] = true;
+
+  LogReader reader(filters);
+  if (!reader.load(argv[optind])) {
+    fprintf(stderr, "failed to read %s\n", argv[optind]);
+    return 1;
+  }
+  bool ublox = std::any_of(reader.events.begin(), reader.events.end(), [](const Event &e) {
+    return e.which == cereal::Event::Which::GPS_LOCATION_EXTERNAL;
+  });
+
+  std::map<cereal::Event::Which, Timings> timings;
+  Timings trigger_timings;
+  for (int i = 0; i < repeat; ++i) {
+    Localizer localizer(ublox ? LocalizerGnssSource::UBLOX : LocalizerGnssSource::QCOM);
+    for (const Event &e : reader.events) {
+      if (e.which == (ublox ? cereal::Event::Which::GPS_LOCATION : cereal::Event::Which::GPS_LOCATION_EXTERNAL)) continue;
+
+      capnp::FlatArrayMessageReader msg(e.data);
+      cereal::Event::Reader event = msg.getRoot<cereal::Event>();
+      if (!event.getValid()) continue;
+
+      localizer.observation_timings_invalid_reset();
+      measure(timings[e.which], [&]() { localizer.handle_msg(event); });
+
+      if (e.which == cereal::Event::Which::CAMERA_ODOMETRY) {
+        MessageBuilder msg_builder;
+        measure(trigger_timings, [&]() { localizer.handle_trigger(msg_builder, event, true, true, true, true); });
+      }
+    }
+  }
+
+  printf("%s, %zu events, %d runs\n", argv[optind], reader.events.size(), repeat);
+  for (auto &[which, t] : timings) {
+    t.print(inputs.at(which));
+  }
+  trigger_timings.print("liveLocationKalman");
+  return 0;
+}
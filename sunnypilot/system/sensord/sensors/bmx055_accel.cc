@@ -6,7 +6,7 @@
 #include "common/timing.h"
 #include "common/util.h"
 
-BMX055_Accel::BMX055_Accel(I2CBus *bus) : I2CSensor(bus) {}
+BMX055_Accel::BMX055_Accel(SensorBus *bus) : I2CSensor(bus) {}
 
 int BMX055_Accel::init() {
   int ret = verify_chip_id(BMX055_ACCEL_I2C_REG_ID, {BMX055_ACCEL_CHIP_ID});
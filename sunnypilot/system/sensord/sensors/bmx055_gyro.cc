@@ -9,7 +9,7 @@
 #define DEG2RAD(x) ((x) * M_PI / 180.0)
 
 
-BMX055_Gyro::BMX055_Gyro(I2CBus *bus) : I2CSensor(bus) {}
+BMX055_Gyro::BMX055_Gyro(SensorBus *bus) : I2CSensor(bus) {}
 
 int BMX055_Gyro::init() {
   int ret = verify_chip_id(BMX055_GYRO_I2C_REG_ID, {BMX055_GYRO_CHIP_ID});
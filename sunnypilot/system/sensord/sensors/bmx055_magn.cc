@@ -63,7 +63,7 @@ static int16_t compensate_z(trim_data_t trim_data, int16_t mag_data_z, uint16_t
   return (int16_t)retval;
 }
 
-BMX055_Magn::BMX055_Magn(I2CBus *bus) : I2CSensor(bus) {}
+BMX055_Magn::BMX055_Magn(SensorBus *bus) : I2CSensor(bus) {}
 
 int BMX055_Magn::init() {
   uint8_t trim_x1y1[2] = {0};
@@ -57,7 +57,7 @@ class BMX055_Magn : public I2CSensor{
   bool perform_self_test();
   bool parse_xyz(uint8_t buffer[8], int16_t *x, int16_t *y, int16_t *z);
 public:
-  BMX055_Magn(I2CBus *bus);
+  BMX055_Magn(SensorBus *bus);
   int init();
   bool get_event(MessageBuilder &msg, uint64_t ts = 0);
   int shutdown();
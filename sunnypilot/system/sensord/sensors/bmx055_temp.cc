@@ -6,7 +6,7 @@
 #include "common/swaglog.h"
 #include "common/timing.h"
 
-BMX055_Temp::BMX055_Temp(I2CBus *bus) : I2CSensor(bus) {}
+BMX055_Temp::BMX055_Temp(SensorBus *bus) : I2CSensor(bus) {}
 
 int BMX055_Temp::init() {
   return verify_chip_id(BMX055_ACCEL_I2C_REG_ID, {BMX055_ACCEL_CHIP_ID}) == -1 ? -1 : 0;
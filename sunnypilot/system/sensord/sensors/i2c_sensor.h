@@ -16,16 +16,37 @@ int16_t read_12_bit(uint8_t lsb, uint8_t msb);
 int16_t read_16_bit(uint8_t lsb, uint8_t msb);
 int32_t read_20_bit(uint8_t b2, uint8_t b1, uint8_t b0);
 
+// Register access for the sensors. On the device it goes to an I2CBus, tests use an in-memory bus.
+class SensorBus {
+public:
+  virtual ~SensorBus() {}
+  virtual int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) = 0;
+  virtual int set_register(uint8_t device_address, uint register_address, uint8_t data) = 0;
+};
 
-class I2CSensor : public Sensor {
+class I2CSensorBus : public SensorBus {
 private:
   I2CBus *bus;
+
+public:
+  I2CSensorBus(I2CBus *bus) : bus(bus) {}
+  int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) override {
+    return bus->read_register(device_address, register_address, buffer, len);
+  }
+  int set_register(uint8_t device_address, uint register_address, uint8_t data) override {
+    return bus->set_register(device_address, register_address, data);
+  }
+};
+
+class I2CSensor : public Sensor {
+private:
+  SensorBus *bus;
   int gpio_nr;
   bool shared_gpio;
   virtual uint8_t get_device_address() = 0;
 
 public:
-  I2CSensor(I2CBus *bus, int gpio_nr = 0, bool shared_gpio = false);
+  I2CSensor(SensorBus *bus, int gpio_nr = 0, bool shared_gpio = false);
   ~I2CSensor();
   int read_register(uint register_address, uint8_t *buffer, uint8_t len);
   int set_register(uint register_address, uint8_t data);
@@ -8,8 +8,8 @@
 #include "common/timing.h"
 #include "common/util.h"
 
-LSM6DS3_Accel::LSM6DS3_Accel(I2CBus *bus, int gpio_nr, bool shared_gpio) :
-  I2CSensor(bus, gpio_nr, shared_gpio) {}
+LSM6DS3_Accel::LSM6DS3_Accel(SensorBus *bus, int gpio_nr, bool shared_gpio, LSM6DS3_FIFO *fifo) :
+  I2CSensor(bus, gpio_nr, shared_gpio), fifo(fifo) {}
 
 void LSM6DS3_Accel::wait_for_data_ready() {
   uint8_t drdy = 0;
@@ -216,23 +216,11 @@ fail:
   return ret;
 }
 
-bool LSM6DS3_Accel::get_event(MessageBuilder &msg, uint64_t ts) {
-
-  // INT1 shared with gyro, check STATUS_REG who triggered
-  uint8_t status_reg = 0;
-  read_register(LSM6DS3_ACCEL_I2C_REG_STAT_REG, &status_reg, sizeof(status_reg));
-  if ((status_reg & LSM6DS3_ACCEL_DRDY_XLDA) == 0) {
-    return false;
-  }
-
-  uint8_t buffer[6];
-  int len = read_register(LSM6DS3_ACCEL_I2C_REG_OUTX_L_XL, buffer, sizeof(buffer));
-  assert(len == sizeof(buffer));
-
+void LSM6DS3_Accel::build_event(MessageBuilder &msg, const int16_t raw[3], uint64_t ts) {
   float scale = 9.81 * 2.0f / (1 << 15);
-  float x = read_16_bit(buffer[0], buffer[1]) * scale;
-  float y = read_16_bit(buffer[2], buffer[3]) * scale;
-  float z = read_16_bit(buffer[4], buffer[5]) * scale;
+  float x = raw[0] * scale;
+  float y = raw[1] * scale;
+  float z = raw[2] * scale;
 
   auto event = msg.initEvent().initAccelerometer();
   event.setSource(source);
@@ -245,6 +233,36 @@ bool LSM6DS3_Accel::get_event(MessageBuilder &msg, uint64_t ts) {
   auto svec = event.initAcceleration();
   svec.setV(xyz);
   svec.setStatus(true);
+}
+
+bool LSM6DS3_Accel::get_event(MessageBuilder &msg, uint64_t ts) {
 
+  // INT1 shared with gyro, check STATUS_REG who triggered
+  uint8_t status_reg = 0;
+  read_register(LSM6DS3_ACCEL_I2C_REG_STAT_REG, &status_reg, sizeof(status_reg));
+  if ((status_reg & LSM6DS3_ACCEL_DRDY_XLDA) == 0) {
+    return false;
+  }
+
+  uint8_t buffer[6];
+  int len = read_register(LSM6DS3_ACCEL_I2C_REG_OUTX_L_XL, buffer, sizeof(buffer));
+  assert(len == sizeof(buffer));
+
+  const int16_t raw[] = {read_16_bit(buffer[0], buffer[1]), read_16_bit(buffer[2], buffer[3]), read_16_bit(buffer[4], buffer[5])};
+  build_event(msg, raw, ts);
   return true;
 }
+
+int LSM6DS3_Accel::get_events(std::deque<MessageBuilder> &msgs, uint64_t ts) {
+  if (fifo == nullptr || !fifo->enabled) {
+    return I2CSensor::get_events(msgs, ts);
+  }
+
+  fifo->drain(ts);
+  for (const auto &sample : fifo->accel) {
+    build_event(msgs.emplace_back(), sample.xyz, sample.ts);
+  }
+  int count = fifo->accel.size();
+  fifo->accel.clear();
+  return count;
+}
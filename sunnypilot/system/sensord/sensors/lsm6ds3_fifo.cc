@@ -0,0 +1,197 @@
+#include "sunnypilot/system/sensord/sensors/lsm6ds3_fifo.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/swaglog.h"
+
+LSM6DS3_FIFO::LSM6DS3_FIFO(SensorBus *bus, int batch_size) :
+  I2CSensor(bus), batch_size(batch_size), threshold(batch_size * LSM6DS3_FIFO_PATTERN_WORDS) {}
+
+int LSM6DS3_FIFO::init() {
+  uint8_t value = 0;
+
+  int ret = verify_chip_id(LSM6DS3_FIFO_I2C_REG_ID, {LSM6DS3_FIFO_CHIP_ID, LSM6DS3TRC_FIFO_CHIP_ID});
+  if (ret == -1) {
+    goto fail;
+  }
+  level_msb_mask = ret == LSM6DS3_FIFO_CHIP_ID ? 0x0F : 0x07;
+
+  // bypass mode empties the FIFO
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5, LSM6DS3_FIFO_MODE_BYPASS);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // threshold in 16 bit words
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL1, threshold & 0xFF);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL2, (threshold >> 8) & level_msb_mask);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL3, LSM6DS3_FIFO_DEC_G_XL_NONE);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5, LSM6DS3_FIFO_ODR_104HZ | LSM6DS3_FIFO_MODE_CONTINUOUS);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // the threshold interrupt replaces the data ready interrupts of accel and gyro on INT1
+  ret = read_register(LSM6DS3_FIFO_I2C_REG_INT1_CTRL, &value, 1);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  value = (value & ~LSM6DS3_FIFO_INT1_DRDY_G_XL) | LSM6DS3_FIFO_INT1_FTH;
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_INT1_CTRL, value);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  enabled = true;
+
+fail:
+  return ret;
+}
+
+int LSM6DS3_FIFO::shutdown() {
+  int ret = 0;
+
+  uint8_t value = 0;
+  ret = read_register(LSM6DS3_FIFO_I2C_REG_INT1_CTRL, &value, 1);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  value &= ~(LSM6DS3_FIFO_INT1_FTH);
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_INT1_CTRL, value);
+  if (ret < 0) {
+    LOGE("Could not disable lsm6ds3 FIFO interrupt!");
+    goto fail;
+  }
+
+  ret = set_register(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5, LSM6DS3_FIFO_MODE_BYPASS);
+  enabled = false;
+
+fail:
+  return ret;
+}
+
+int LSM6DS3_FIFO::read_status(int *words, int *pattern) {
+  // FIFO_STATUS1-4: unread words, flags, and where in the gyro/accel pattern the next word is
+  uint8_t status[4];
+  int ret = read_register(LSM6DS3_FIFO_I2C_REG_STATUS1, status, sizeof(status));
+  if (ret < 0) {
+    return ret;
+  }
+
+  if (status[1] & LSM6DS3_FIFO_STATUS2_OVER_RUN) {
+    LOGW("lsm6ds3 FIFO overrun");
+    overruns++;
+  }
+  *words = status[0] | ((status[1] & level_msb_mask) << 8);
+  *pattern = (status[2] | ((status[3] & 0x03) << 8)) % LSM6DS3_FIFO_PATTERN_WORDS;
+  return 0;
+}
+
+// Reads whole samples into buffer until the FIFO is below the threshold, which takes INT1 low again
+int LSM6DS3_FIFO::read_samples(int *samples) {
+  buffer.clear();
+  *samples = 0;
+  for (int pass = 0; pass < LSM6DS3_FIFO_MAX_PASSES; pass++) {
+    int words = 0, pattern = 0;
+    int ret = read_status(&words, &pattern);
+    if (ret < 0) {
+      return ret;
+    }
+    // samples that came in during the last read can keep the level at the threshold
+    if (pass > 0 && words < threshold) {
+      break;
+    }
+
+    // an overrun can leave a partial sample at the front, read it and drop it
+    const int skip = (LSM6DS3_FIFO_PATTERN_WORDS - pattern) % LSM6DS3_FIFO_PATTERN_WORDS;
+    const int n = std::max(words - skip, 0) / LSM6DS3_FIFO_PATTERN_WORDS;
+    if (n == 0) {
+      break;
+    }
+
+    // the register address wraps from FIFO_DATA_OUT_H back to _L, so reads stream the FIFO
+    const size_t start = buffer.size();
+    buffer.resize(start + (skip + n * LSM6DS3_FIFO_PATTERN_WORDS) * 2);
+    for (size_t offset = start; offset < buffer.size(); offset += LSM6DS3_FIFO_MAX_BURST) {
+      uint8_t len = std::min<size_t>(buffer.size() - offset, LSM6DS3_FIFO_MAX_BURST);
+      ret = read_register(LSM6DS3_FIFO_I2C_REG_DATA_OUT_L, &buffer[offset], len);
+      if (ret != len) {
+        // a short read would misalign the patterns of everything after it
+        return ret < 0 ? ret : -1;
+      }
+    }
+    buffer.erase(buffer.begin() + start, buffer.begin() + start + skip * 2);
+    *samples += n;
+  }
+  return 0;
+}
+
+int LSM6DS3_FIFO::drain(uint64_t ts) {
+  // accel and gyro both ask for the same interrupt
+  if (ts == last_drain_ts) {
+    return 0;
+  }
+
+  int samples = 0;
+  int ret = read_samples(&samples);
+  if (ret < 0) {
+    return ret;
+  }
+  if (samples == 0) {
+    return 0;
+  }
+
+  // follow the chip's actual ODR, measured between interrupts. intervals with lost samples are off
+  // by a whole sample period or more and left out
+  if (last_drain_ts != 0) {
+    const double measured = double(ts - last_drain_ts) / samples;
+    const double nominal = 1e9 / LSM6DS3_FIFO_ODR_HZ;
+    if (std::abs(measured - nominal) < nominal * 0.25) {
+      sample_period_ns += (measured - sample_period_ns) * 0.1;
+    }
+  }
+
+  // the newest sample is at the interrupt, and the batch can't start before the previous one ended
+  double period = sample_period_ns;
+  if (last_sample_ts != 0 && ts - (samples - 1) * period <= last_sample_ts) {
+    period = double(ts - last_sample_ts) / samples;
+  }
+
+  const uint8_t *data = buffer.data();
+  for (int i = 0; i < samples; i++) {
+    const uint64_t sample_ts = ts - uint64_t(std::llround((samples - 1 - i) * period));
+    const uint8_t *g = data + i * LSM6DS3_FIFO_PATTERN_WORDS * 2;
+    const uint8_t *a = g + 6;
+    gyro.push_back({sample_ts, {read_16_bit(g[0], g[1]), read_16_bit(g[2], g[3]), read_16_bit(g[4], g[5])}});
+    accel.push_back({sample_ts, {read_16_bit(a[0], a[1]), read_16_bit(a[2], a[3]), read_16_bit(a[4], a[5])}});
+  }
+
+  last_drain_ts = ts;
+  last_sample_ts = ts;
+  return samples;
+}
+
+int LSM6DS3_FIFO::flush() {
+  int samples = 0;
+  int ret = read_samples(&samples);
+
+  // the next batch can't be placed relative to this one
+  last_drain_ts = 0;
+  last_sample_ts = 0;
+  return ret < 0 ? ret : samples;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include "sunnypilot/system/sensord/sensors/i2c_sensor.h"
+
+// Address of the chip on the bus
+#define LSM6DS3_FIFO_I2C_ADDR       0x6A
+
+// Registers of the chip
+#define LSM6DS3_FIFO_I2C_REG_FIFO_CTRL1  0x06
+#define LSM6DS3_FIFO_I2C_REG_FIFO_CTRL2  0x07
+#define LSM6DS3_FIFO_I2C_REG_FIFO_CTRL3  0x08
+#define LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5  0x0A
+#define LSM6DS3_FIFO_I2C_REG_INT1_CTRL   0x0D
+#define LSM6DS3_FIFO_I2C_REG_ID          0x0F
+#define LSM6DS3_FIFO_I2C_REG_STATUS1     0x3A
+#define LSM6DS3_FIFO_I2C_REG_DATA_OUT_L  0x3E
+
+// Constants
+#define LSM6DS3_FIFO_CHIP_ID          0x69
+#define LSM6DS3TRC_FIFO_CHIP_ID       0x6A
+#define LSM6DS3_FIFO_DEC_G_XL_NONE    0b001001  // gyro and accel in the FIFO, no decimation
+#define LSM6DS3_FIFO_ODR_104HZ        (0b0100 << 3)
+#define LSM6DS3_FIFO_MODE_BYPASS      0b000
+#define LSM6DS3_FIFO_MODE_CONTINUOUS  0b110
+#define LSM6DS3_FIFO_INT1_FTH         (1 << 3)
+#define LSM6DS3_FIFO_INT1_DRDY_G_XL   0b11
+#define LSM6DS3_FIFO_STATUS2_OVER_RUN (1 << 6)
+#define LSM6DS3_FIFO_PATTERN_WORDS    6  // gyro xyz, then accel xyz
+#define LSM6DS3_FIFO_ODR_HZ           104
+#define LSM6DS3_FIFO_MAX_BURST        24   // two whole patterns, an SMBus block read is at most 32 bytes
+#define LSM6DS3_FIFO_MAX_PASSES       8
+
+// In FIFO mode the LSM6DS3 accel and gyro samples are buffered on the chip and INT1 fires at a
+// threshold of batch_size samples instead of per sample. Each interrupt then costs one status read
+// and one burst read for the whole batch, which LSM6DS3_Accel and LSM6DS3_Gyro publish.
+// The samples are timestamped back from the interrupt at the sample period measured over past
+// interrupts, since the chip's ODR is off from the nominal one by a few percent.
+// The threshold interrupt is a level and the GPIO only sees rising edges, so every interrupt has to
+// read the FIFO below the threshold, including the ones whose timestamp is thrown away.
+class LSM6DS3_FIFO : public I2CSensor {
+  uint8_t get_device_address() {return LSM6DS3_FIFO_I2C_ADDR;}
+
+  int batch_size;
+  int threshold;
+  // the LSM6DS3 counts FIFO words with 12 bits, the LSM6DS3TR-C with 11
+  uint8_t level_msb_mask = 0x07;
+  uint64_t last_drain_ts = 0;
+  uint64_t last_sample_ts = 0;
+  std::vector<uint8_t> buffer;
+
+  int read_status(int *words, int *pattern);
+  int read_samples(int *samples);
+
+public:
+  struct Sample {
+    uint64_t ts;
+    int16_t xyz[3];
+  };
+
+  LSM6DS3_FIFO(SensorBus *bus, int batch_size = 4);
+  // switches INT1 from the data ready to the FIFO threshold interrupt, after the accel and gyro init
+  int init();
+  bool get_event(MessageBuilder &msg, uint64_t ts = 0) { return false; }
+  int shutdown();
+
+  // reads the samples up to the interrupt at ts into accel and gyro, only once per interrupt
+  int drain(uint64_t ts);
+  // reads the FIFO below the threshold and drops the samples, for an interrupt without a valid timestamp
+  int flush();
+
+  std::vector<Sample> accel, gyro;
+  double sample_period_ns = 1e9 / LSM6DS3_FIFO_ODR_HZ;
+  uint64_t overruns = 0;
+};
@@ -10,8 +10,8 @@
 
 #define DEG2RAD(x) ((x) * M_PI / 180.0)
 
-LSM6DS3_Gyro::LSM6DS3_Gyro(I2CBus *bus, int gpio_nr, bool shared_gpio) :
-  I2CSensor(bus, gpio_nr, shared_gpio) {}
+LSM6DS3_Gyro::LSM6DS3_Gyro(SensorBus *bus, int gpio_nr, bool shared_gpio, LSM6DS3_FIFO *fifo) :
+  I2CSensor(bus, gpio_nr, shared_gpio), fifo(fifo) {}
 
 void LSM6DS3_Gyro::wait_for_data_ready() {
   uint8_t drdy = 0;
@@ -199,23 +199,11 @@ fail:
   return ret;
 }
 
-bool LSM6DS3_Gyro::get_event(MessageBuilder &msg, uint64_t ts) {
-
-  // INT1 shared with accel, check STATUS_REG who triggered
-  uint8_t status_reg = 0;
-  read_register(LSM6DS3_GYRO_I2C_REG_STAT_REG, &status_reg, sizeof(status_reg));
-  if ((status_reg & LSM6DS3_GYRO_DRDY_GDA) == 0) {
-    return false;
-  }
-
-  uint8_t buffer[6];
-  int len = read_register(LSM6DS3_GYRO_I2C_REG_OUTX_L_G, buffer, sizeof(buffer));
-  assert(len == sizeof(buffer));
-
+void LSM6DS3_Gyro::build_event(MessageBuilder &msg, const int16_t raw[3], uint64_t ts) {
   float scale = 8.75 / 1000.0;
-  float x = DEG2RAD(read_16_bit(buffer[0], buffer[1]) * scale);
-  float y = DEG2RAD(read_16_bit(buffer[2], buffer[3]) * scale);
-  float z = DEG2RAD(read_16_bit(buffer[4], buffer[5]) * scale);
+  float x = DEG2RAD(raw[0] * scale);
+  float y = DEG2RAD(raw[1] * scale);
+  float z = DEG2RAD(raw[2] * scale);
 
   auto event = msg.initEvent().initGyroscope();
   event.setSource(source);
@@ -228,6 +216,36 @@ bool LSM6DS3_Gyro::get_event(MessageBuilder &msg, uint64_t ts) {
   auto svec = event.initGyroUncalibrated();
   svec.setV(xyz);
   svec.setStatus(true);
+}
+
+bool LSM6DS3_Gyro::get_event(MessageBuilder &msg, uint64_t ts) {
 
+  // INT1 shared with accel, check STATUS_REG who triggered
+  uint8_t status_reg = 0;
+  read_register(LSM6DS3_GYRO_I2C_REG_STAT_REG, &status_reg, sizeof(status_reg));
+  if ((status_reg & LSM6DS3_GYRO_DRDY_GDA) == 0) {
+    return false;
+  }
+
+  uint8_t buffer[6];
+  int len = read_register(LSM6DS3_GYRO_I2C_REG_OUTX_L_G, buffer, sizeof(buffer));
+  assert(len == sizeof(buffer));
+
+  const int16_t raw[] = {read_16_bit(buffer[0], buffer[1]), read_16_bit(buffer[2], buffer[3]), read_16_bit(buffer[4], buffer[5])};
+  build_event(msg, raw, ts);
   return true;
 }
+
+int LSM6DS3_Gyro::get_events(std::deque<MessageBuilder> &msgs, uint64_t ts) {
+  if (fifo == nullptr || !fifo->enabled) {
+    return I2CSensor::get_events(msgs, ts);
+  }
+
+  fifo->drain(ts);
+  for (const auto &sample : fifo->gyro) {
+    build_event(msgs.emplace_back(), sample.xyz, sample.ts);
+  }
+  int count = fifo->gyro.size();
+  fifo->gyro.clear();
+  return count;
+}
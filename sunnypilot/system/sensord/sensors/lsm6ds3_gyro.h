@@ -1,6 +1,6 @@
 #pragma once
 
-#include "sunnypilot/system/sensord/sensors/i2c_sensor.h"
+#include "sunnypilot/system/sensord/sensors/lsm6ds3_fifo.h"
 
 // Address of the chip on the bus
 #define LSM6DS3_GYRO_I2C_ADDR       0x6A
@@ -37,9 +37,14 @@ class LSM6DS3_Gyro : public I2CSensor {
   int self_test(int test_type);
   void wait_for_data_ready();
   void read_and_avg_data(float* val_st_off);
+
+  LSM6DS3_FIFO *fifo;
+  void build_event(MessageBuilder &msg, const int16_t raw[3], uint64_t ts);
 public:
-  LSM6DS3_Gyro(I2CBus *bus, int gpio_nr = 0, bool shared_gpio = false);
+  // with an enabled fifo, the samples come from the FIFO instead of the output registers
+  LSM6DS3_Gyro(SensorBus *bus, int gpio_nr = 0, bool shared_gpio = false, LSM6DS3_FIFO *fifo = nullptr);
   int init();
   bool get_event(MessageBuilder &msg, uint64_t ts = 0);
+  int get_events(std::deque<MessageBuilder> &msgs, uint64_t ts = 0);
   int shutdown();
 };
@@ -5,7 +5,7 @@
 #include "common/swaglog.h"
 #include "common/timing.h"
 
-LSM6DS3_Temp::LSM6DS3_Temp(I2CBus *bus) : I2CSensor(bus) {}
+LSM6DS3_Temp::LSM6DS3_Temp(SensorBus *bus) : I2CSensor(bus) {}
 
 int LSM6DS3_Temp::init() {
   int ret = verify_chip_id(LSM6DS3_TEMP_I2C_REG_ID, {LSM6DS3_TEMP_CHIP_ID, LSM6DS3TRC_TEMP_CHIP_ID});
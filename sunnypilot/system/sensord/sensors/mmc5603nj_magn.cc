@@ -8,7 +8,7 @@
 #include "common/timing.h"
 #include "common/util.h"
 
-MMC5603NJ_Magn::MMC5603NJ_Magn(I2CBus *bus) : I2CSensor(bus) {}
+MMC5603NJ_Magn::MMC5603NJ_Magn(SensorBus *bus) : I2CSensor(bus) {}
 
 int MMC5603NJ_Magn::init() {
   int ret = verify_chip_id(MMC5603NJ_I2C_REG_ID, {MMC5603NJ_CHIP_ID});
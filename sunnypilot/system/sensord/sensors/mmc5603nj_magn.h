@@ -30,7 +30,7 @@ private:
   void start_measurement();
   std::vector<float> read_measurement();
 public:
-  MMC5603NJ_Magn(I2CBus *bus);
+  MMC5603NJ_Magn(SensorBus *bus);
   int init();
   bool get_event(MessageBuilder &msg, uint64_t ts = 0);
   int shutdown();
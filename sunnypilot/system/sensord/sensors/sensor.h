@@ -1,5 +1,7 @@
 #pragma once
 
+#include <deque>
+
 #include "cereal/messaging/messaging.h"
 
 class Sensor {
@@ -12,6 +14,14 @@ public:
   virtual ~Sensor() {}
   virtual int init() = 0;
   virtual bool get_event(MessageBuilder &msg, uint64_t ts = 0) = 0;
+  // appends the events since the last call, more than one for sensors read from a hardware FIFO
+  virtual int get_events(std::deque<MessageBuilder> &msgs, uint64_t ts = 0) {
+    if (!get_event(msgs.emplace_back(), ts)) {
+      msgs.pop_back();
+      return 0;
+    }
+    return 1;
+  }
   virtual bool has_interrupt_enabled() = 0;
   virtual int shutdown() = 0;
 
@@ -20,6 +20,7 @@
 #include "sunnypilot/system/sensord/sensors/bmx055_temp.h"
 #include "sunnypilot/system/sensord/sensors/constants.h"
 #include "sunnypilot/system/sensord/sensors/lsm6ds3_accel.h"
+#include "sunnypilot/system/sensord/sensors/lsm6ds3_fifo.h"
 #include "sunnypilot/system/sensord/sensors/lsm6ds3_gyro.h"
 #include "sunnypilot/system/sensord/sensors/lsm6ds3_temp.h"
 #include "sunnypilot/system/sensord/sensors/mmc5603nj_magn.h"
@@ -28,9 +29,17 @@
 
 ExitHandler do_exit;
 
-void interrupt_loop(std::vector<std::tuple<Sensor *, std::string>> sensors) {
+void interrupt_loop(std::vector<std::tuple<Sensor *, std::string>> sensors, LSM6DS3_FIFO *lsm_fifo) {
   PubMaster pm({"gyroscope", "accelerometer"});
 
+  // the FIFO threshold interrupt stays high until the FIFO is read, without a new edge in the meantime.
+  // interrupts that aren't published still read it, and a timeout catches one left high by an I2C error
+  auto flush_fifo = [&]() {
+    if (lsm_fifo && lsm_fifo->enabled && lsm_fifo->flush() < 0) {
+      LOGE("LSM6DS3 FIFO flush failed");
+    }
+  };
+
   int fd = -1;
   for (auto &[sensor, msg_name] : sensors) {
     if (sensor->has_interrupt_enabled()) {
@@ -53,6 +62,7 @@ void interrupt_loop(std::vector<std::tuple<Sensor *, std::string>> sensors) {
       return;
     } else if (err == 0) {
       LOGE("poll timed out");
+      flush_fifo();
       continue;
     }
 
@@ -66,6 +76,7 @@ void interrupt_loop(std::vector<std::tuple<Sensor *, std::string>> sensors) {
     err = HANDLE_EINTR(read(fd, evdata, sizeof(evdata)));
     if (err < 0 || err % sizeof(*evdata) != 0) {
       LOGE("error reading event data %d", err);
+      flush_fifo();
       continue;
     }
 
@@ -77,6 +88,7 @@ void interrupt_loop(std::vector<std::tuple<Sensor *, std::string>> sensors) {
 
       // we don't have a valid timestamp since the
       // time jumped, so throw out this measurement.
+      flush_fifo();
       continue;
     }
 
@@ -88,8 +100,8 @@ void interrupt_loop(std::vector<std::tuple<Sensor *, std::string>> sensors) {
         continue;
       }
 
-      MessageBuilder msg;
-      if (!sensor->get_event(msg, ts)) {
+      std::deque<MessageBuilder> msgs;
+      if (sensor->get_events(msgs, ts) == 0) {
         continue;
       }
 
@@ -97,7 +109,9 @@ void interrupt_loop(std::vector<std::tuple<Sensor *, std::string>> sensors) {
         continue;
       }
 
-      pm.send(msg_name.c_str(), msg);
+      for (auto &msg : msgs) {
+        pm.send(msg_name.c_str(), msg);
+      }
     }
   }
 }
@@ -114,7 +128,13 @@ void polling_loop(Sensor *sensor, std::string msg_name) {
   }
 }
 
-int sensor_loop(I2CBus *i2c_bus_imu) {
+int sensor_loop(SensorBus *i2c_bus_imu) {
+  // LSM6DS3 samples are batched in its FIFO, unless LSM_FIFO=0
+  std::unique_ptr<LSM6DS3_FIFO> lsm_fifo;
+  if (util::getenv("LSM_FIFO", 1) != 0) {
+    lsm_fifo = std::make_unique<LSM6DS3_FIFO>(i2c_bus_imu);
+  }
+
   // Sensor init
   std::vector<std::tuple<Sensor *, std::string>> sensors_init = {
     {new BMX055_Accel(i2c_bus_imu), "accelerometer2"},
@@ -122,8 +142,8 @@ int sensor_loop(I2CBus *i2c_bus_imu) {
     {new BMX055_Magn(i2c_bus_imu), "magnetometer"},
     {new BMX055_Temp(i2c_bus_imu), "temperatureSensor2"},
 
-    {new LSM6DS3_Accel(i2c_bus_imu, GPIO_LSM_INT), "accelerometer"},
-    {new LSM6DS3_Gyro(i2c_bus_imu, GPIO_LSM_INT, true), "gyroscope"},
+    {new LSM6DS3_Accel(i2c_bus_imu, GPIO_LSM_INT, false, lsm_fifo.get()), "accelerometer"},
+    {new LSM6DS3_Gyro(i2c_bus_imu, GPIO_LSM_INT, true, lsm_fifo.get()), "gyroscope"},
     {new LSM6DS3_Temp(i2c_bus_imu), "temperatureSensor"},
 
     {new MMC5603NJ_Magn(i2c_bus_imu), "magnetometer"},
@@ -142,6 +162,11 @@ int sensor_loop(I2CBus *i2c_bus_imu) {
     }
   }
 
+  // on failure accel and gyro keep their data ready interrupts
+  if (lsm_fifo && lsm_fifo->init() < 0) {
+    LOGE("LSM6DS3 FIFO init failed, reading samples one by one");
+  }
+
   // increase interrupt quality by pinning interrupt and process to core 1
   setpriority(PRIO_PROCESS, 0, -18);
   util::set_core_affinity({1});
@@ -154,7 +179,7 @@ int sensor_loop(I2CBus *i2c_bus_imu) {
   std::system(util::string_format("sudo su -c 'echo 1 > %s'", irq_path.c_str()).c_str());
 
   // thread for reading events via interrupts
-  threads.emplace_back(&interrupt_loop, std::ref(sensors_init));
+  threads.emplace_back(&interrupt_loop, std::ref(sensors_init), lsm_fifo.get());
 
   // wait for all threads to finish
   for (auto &t : threads) {
@@ -165,13 +190,17 @@ int sensor_loop(I2CBus *i2c_bus_imu) {
     sensor->shutdown();
     delete sensor;
   }
+  if (lsm_fifo && lsm_fifo->enabled) {
+    lsm_fifo->shutdown();
+  }
   return 0;
 }
 
 int main(int argc, char *argv[]) {
   try {
     auto i2c_bus_imu = std::make_unique<I2CBus>(I2C_BUS_IMU);
-    return sensor_loop(i2c_bus_imu.get());
+    I2CSensorBus sensor_bus(i2c_bus_imu.get());
+    return sensor_loop(&sensor_bus);
   } catch (std::exception &e) {
     LOGE("I2CBus init failed");
     return -1;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "sunnypilot/system/sensord/sensors/i2c_sensor.h"
+
+// In-memory stand-in for the I2C bus. Each device is a plain register file with auto increment,
+// read_hooks replace reads starting at a register (e.g. to model a FIFO), reads starting at a
+// failing register return an error, and every transaction is counted. Like the SMBus block read
+// of I2CBus, a read returns at most block_max bytes.
+class MockI2CBus : public SensorBus {
+public:
+  using Register = std::pair<uint8_t, uint>;
+
+  int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) override {
+    reads++;
+    if (failing.count({device_address, register_address})) {
+      return -1;
+    }
+    len = std::min(len, block_max);
+    bytes_read += len;
+    if (auto it = read_hooks.find({device_address, register_address}); it != read_hooks.end()) {
+      it->second(buffer, len);
+      return len;
+    }
+    for (int i = 0; i < len; i++) {
+      buffer[i] = registers[{device_address, register_address + i}];
+    }
+    return len;
+  }
+
+  int set_register(uint8_t device_address, uint register_address, uint8_t data) override {
+    writes++;
+    registers[{device_address, register_address}] = data;
+    return 0;
+  }
+
+  std::map<Register, uint8_t> registers;
+  std::map<Register, std::function<void(uint8_t *buffer, uint8_t len)>> read_hooks;
+  std::set<Register> failing;
+  uint8_t block_max = 32;  // I2C_SMBUS_BLOCK_MAX
+  int reads = 0;
+  int writes = 0;
+  int bytes_read = 0;
+};
@@ -0,0 +1,249 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <cmath>
+#include <deque>
+#include <random>
+
+#include "sunnypilot/system/sensord/sensors/lsm6ds3_fifo.h"
+#include "sunnypilot/system/sensord/tests/mock_i2c_bus.h"
+
+// The chip's side of the FIFO on the mock bus: samples go in as gyro xyz then accel xyz words,
+// the status registers report the unread words and where the next one is in that pattern.
+// INT1 is the threshold level, seen by the GPIO only on its rising edge.
+class FakeFIFO {
+public:
+  FakeFIFO(MockI2CBus &bus, int threshold) : threshold(threshold) {
+    bus.read_hooks[{LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_STATUS1}] = [this](uint8_t *buffer, uint8_t len) {
+      REQUIRE(len == 4);
+      buffer[0] = words.size() & 0xFF;
+      buffer[1] = ((words.size() >> 8) & level_msb_mask) | (overrun ? LSM6DS3_FIFO_STATUS2_OVER_RUN : 0);
+      buffer[2] = pattern & 0xFF;
+      buffer[3] = pattern >> 8;
+      overrun = false;
+    };
+    bus.read_hooks[{LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_DATA_OUT_L}] = [this](uint8_t *buffer, uint8_t len) {
+      REQUIRE(len % 2 == 0);
+      REQUIRE(len / 2 <= words.size());
+      for (int i = 0; i < len / 2; i++) {
+        uint16_t word = words.front();
+        buffer[i * 2] = word & 0xFF;
+        buffer[i * 2 + 1] = word >> 8;
+        pop();
+      }
+      if (on_data_read) {
+        on_data_read();
+        on_data_read = nullptr;
+      }
+    };
+  }
+
+  // gyro is n, n + 1, n + 2 and accel the negated values
+  void push(int16_t n) {
+    for (int16_t v : {n, int16_t(n + 1), int16_t(n + 2), int16_t(-n), int16_t(-n - 1), int16_t(-n - 2)}) {
+      words.push_back(v);
+    }
+  }
+
+  // the chip drops the oldest words when full
+  void drop(int count) {
+    for (int i = 0; i < count; i++) pop();
+    overrun = true;
+  }
+
+  // true when INT1 went high since the last call
+  bool edge() {
+    const bool rising = level() && !int1;
+    int1 = level();
+    return rising;
+  }
+
+  std::deque<uint16_t> words;
+  uint8_t level_msb_mask = 0x07;
+  // runs once after the next FIFO data read
+  std::function<void()> on_data_read;
+
+private:
+  bool level() const { return words.size() >= threshold; }
+  void pop() {
+    words.pop_front();
+    pattern = (pattern + 1) % LSM6DS3_FIFO_PATTERN_WORDS;
+    int1 = int1 && level();
+  }
+
+  const size_t threshold;
+  bool int1 = false;
+
+  int pattern = 0;
+  bool overrun = false;
+};
+
+static void require_sample(const LSM6DS3_FIFO &fifo, size_t i, int16_t n) {
+  REQUIRE(fifo.gyro[i].xyz[0] == n);
+  REQUIRE(fifo.gyro[i].xyz[2] == n + 2);
+  REQUIRE(fifo.accel[i].xyz[0] == -n);
+  REQUIRE(fifo.accel[i].xyz[2] == -n - 2);
+  REQUIRE(fifo.accel[i].ts == fifo.gyro[i].ts);
+}
+
+TEST_CASE("LSM6DS3_FIFO") {
+  MockI2CBus bus;
+  FakeFIFO chip(bus, 4 * LSM6DS3_FIFO_PATTERN_WORDS);
+  LSM6DS3_FIFO fifo(&bus, 4);
+  auto reg = [&](uint address) -> uint8_t & { return bus.registers[std::make_pair(LSM6DS3_FIFO_I2C_ADDR, address)]; };
+
+  // data ready interrupts of accel and gyro are on
+  reg(LSM6DS3_FIFO_I2C_REG_ID) = LSM6DS3TRC_FIFO_CHIP_ID;
+  reg(LSM6DS3_FIFO_I2C_REG_INT1_CTRL) = LSM6DS3_FIFO_INT1_DRDY_G_XL;
+  REQUIRE(fifo.init() == 0);
+  REQUIRE(fifo.enabled);
+  REQUIRE(reg(LSM6DS3_FIFO_I2C_REG_INT1_CTRL) == LSM6DS3_FIFO_INT1_FTH);
+  REQUIRE(reg(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL1) == 4 * LSM6DS3_FIFO_PATTERN_WORDS);
+  REQUIRE(reg(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL5) == (LSM6DS3_FIFO_ODR_104HZ | LSM6DS3_FIFO_MODE_CONTINUOUS));
+
+  SECTION("a batch is read in bursts of two samples, between two status reads") {
+    uint64_t ts = 1e9;
+    for (int batch = 0; batch < 10; batch++) {
+      for (int i = 0; i < 4; i++) chip.push(batch * 4 + i);
+      ts += 4 * 1e9 / LSM6DS3_FIFO_ODR_HZ;
+      bus.reads = 0;
+      REQUIRE(fifo.drain(ts) == 4);
+      REQUIRE(bus.reads == 1 + 2 + 1);
+
+      // the second sensor on the same interrupt doesn't touch the bus
+      REQUIRE(fifo.drain(ts) == 0);
+      REQUIRE(bus.reads == 1 + 2 + 1);
+    }
+    REQUIRE(fifo.gyro.size() == 40);
+    for (int i = 0; i < 40; i++) require_sample(fifo, i, i);
+    REQUIRE(fifo.gyro.back().ts == ts);
+  }
+
+  SECTION("a backlog is read in bursts of whole samples") {
+    for (int i = 0; i < 50; i++) chip.push(i);
+    bus.reads = 0;
+    REQUIRE(fifo.drain(1e9) == 50);
+    REQUIRE(bus.reads == 1 + 25 + 1);
+    REQUIRE(chip.words.empty());
+    for (int i = 0; i < 50; i++) require_sample(fifo, i, i);
+  }
+
+  SECTION("a short read is an error") {
+    for (int i = 0; i < 4; i++) chip.push(i);
+    bus.block_max = 12;
+    REQUIRE(fifo.drain(1e9) < 0);
+    REQUIRE(fifo.gyro.empty());
+  }
+
+  SECTION("a partial sample after an overrun is dropped") {
+    for (int i = 0; i < 5; i++) chip.push(i);
+    chip.drop(2);
+    chip.words.push_back(1000);  // first word of a sample still being written
+    REQUIRE(fifo.drain(1e9) == 4);
+    REQUIRE(fifo.overruns == 1);
+    REQUIRE(chip.words.size() == 1);
+    for (int i = 0; i < 4; i++) require_sample(fifo, i, i + 1);
+  }
+
+  SECTION("timestamps follow the chip's actual ODR") {
+    // 3% slow, the interrupt comes 20-200us after the sample that crossed the threshold
+    const double period = 1e9 / (LSM6DS3_FIFO_ODR_HZ * 0.97);
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> latency(20e3, 200e3);
+
+    std::vector<double> sample_times;
+    double t = 1e9;
+    for (int batch = 0; batch < 200; batch++) {
+      for (int i = 0; i < 4; i++) {
+        t += period;
+        chip.push(sample_times.size());
+        sample_times.push_back(t);
+      }
+      REQUIRE(fifo.drain(t + latency(gen)) == 4);
+    }
+
+    REQUIRE(std::abs(fifo.sample_period_ns - period) < 20e3);
+    double max_error = 0;
+    for (size_t i = 0; i < sample_times.size(); i++) {
+      if (i > 0) REQUIRE(fifo.gyro[i].ts > fifo.gyro[i - 1].ts);
+      if (i >= 200) max_error = std::max(max_error, std::abs(fifo.gyro[i].ts - sample_times[i]));
+    }
+    REQUIRE(max_error < 300e3);
+  }
+
+  SECTION("samples that come in during the read are read too") {
+    for (int i = 0; i < 4; i++) chip.push(i);
+    REQUIRE(chip.edge());
+    chip.on_data_read = [&]() { for (int i = 4; i < 8; i++) chip.push(i); };
+    REQUIRE(fifo.drain(1e9) == 8);
+    REQUIRE(chip.words.empty());
+    for (int i = 0; i < 8; i++) require_sample(fifo, i, i);
+
+    // INT1 went low, so the next batch raises it again
+    for (int i = 8; i < 12; i++) chip.push(i);
+    REQUIRE(chip.edge());
+  }
+
+  SECTION("a skipped interrupt doesn't stop the batches") {
+    const double period = 1e9 / LSM6DS3_FIFO_ODR_HZ;
+    uint64_t ts = 1e9;
+    int published = 0;
+    bool skip = true;
+    for (int i = 0; i < 40; i++) {
+      chip.push(i);
+      ts += period;
+      if (!chip.edge()) continue;
+
+      // the interrupt loop throws out an interrupt after a time jump, but still reads the FIFO
+      if (skip) {
+        REQUIRE(fifo.flush() == 4);
+        skip = false;
+      } else {
+        published += fifo.drain(ts);
+      }
+    }
+    REQUIRE(published == 36);
+    REQUIRE(fifo.gyro.size() == 36);
+    for (int i = 0; i < 36; i++) require_sample(fifo, i, i + 4);
+  }
+
+  SECTION("a FIFO left high by an I2C error is read on the next poll timeout") {
+    for (int i = 0; i < 4; i++) chip.push(i);
+    REQUIRE(chip.edge());
+    bus.failing.insert({LSM6DS3_FIFO_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_DATA_OUT_L});
+    REQUIRE(fifo.drain(1e9) < 0);
+    bus.failing.clear();
+
+    // no new edge while INT1 stays high
+    for (int i = 4; i < 8; i++) chip.push(i);
+    REQUIRE(!chip.edge());
+
+    REQUIRE(fifo.flush() == 8);
+    for (int i = 8; i < 12; i++) chip.push(i);
+    REQUIRE(chip.edge());
+    REQUIRE(fifo.drain(2e9) == 4);
+    for (int i = 0; i < 4; i++) require_sample(fifo, i, i + 8);
+  }
+}
+
+TEST_CASE("LSM6DS3_FIFO with the 12 bit FIFO level of the LSM6DS3") {
+  MockI2CBus bus;
+  const int batch_size = 350;
+  FakeFIFO chip(bus, batch_size * LSM6DS3_FIFO_PATTERN_WORDS);
+  chip.level_msb_mask = 0x0F;
+  LSM6DS3_FIFO fifo(&bus, batch_size);
+  auto reg = [&](uint address) -> uint8_t & { return bus.registers[std::make_pair(LSM6DS3_FIFO_I2C_ADDR, address)]; };
+
+  reg(LSM6DS3_FIFO_I2C_REG_ID) = LSM6DS3_FIFO_CHIP_ID;
+  REQUIRE(fifo.init() == 0);
+  const int threshold = batch_size * LSM6DS3_FIFO_PATTERN_WORDS;
+  REQUIRE(threshold > 0x7FF);
+  REQUIRE(reg(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL1) == (threshold & 0xFF));
+  REQUIRE(reg(LSM6DS3_FIFO_I2C_REG_FIFO_CTRL2) == (threshold >> 8));
+
+  for (int i = 0; i < batch_size; i++) chip.push(i);
+  REQUIRE(chip.edge());
+  REQUIRE(fifo.drain(1e9) == batch_size);
+  REQUIRE(chip.words.empty());
+  for (int i = 0; i < batch_size; i++) require_sample(fifo, i, i);
+}
@@ -0,0 +1,120 @@
+#include "system/camerad/cameras/luma_histogram.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Consecutive samples go to different tables, so an increment never waits on the one before it
+// when neighbouring pixels have the same value.
+struct PartialHistograms {
+  uint32_t h[4][256] = {};
+
+  // eight samples packed in a general purpose register, extracting them there avoids a round trip
+  // through memory
+  inline void add8(uint64_t s) {
+    h[0][s & 0xff]++;
+    h[1][(s >> 8) & 0xff]++;
+    h[2][(s >> 16) & 0xff]++;
+    h[3][(s >> 24) & 0xff]++;
+    h[0][(s >> 32) & 0xff]++;
+    h[1][(s >> 40) & 0xff]++;
+    h[2][(s >> 48) & 0xff]++;
+    h[3][s >> 56]++;
+  }
+};
+
+// Handles 16 samples at a time of a row with x_skip 1 or 2 and returns how many samples it took.
+// The vectors deinterleave the samples and sum them, the bins are counted from the packed lanes.
+// The loads never read past the rect, which may end at the end of the buffer.
+int row_simd(const uint8_t *row, int width, int x_skip, PartialHistograms &ph, uint64_t &sum) {
+  const int bytes = 16 * x_skip;
+  int x = 0;
+#if defined(__aarch64__)
+  uint32x4_t acc = vdupq_n_u32(0);
+  for (; x + bytes <= width; x += bytes) {
+    uint8x16_t v = x_skip == 1 ? vld1q_u8(row + x) : vld2q_u8(row + x).val[0];
+    acc = vpadalq_u16(acc, vpaddlq_u8(v));
+    ph.add8(vgetq_lane_u64(vreinterpretq_u64_u8(v), 0));
+    ph.add8(vgetq_lane_u64(vreinterpretq_u64_u8(v), 1));
+  }
+  sum += vaddvq_u32(acc);
+#elif defined(__x86_64__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i even = _mm_set1_epi16(0x00ff);
+  __m128i acc = zero;
+  for (; x + bytes <= width; x += bytes) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(row + x));
+    if (x_skip == 2) {
+      __m128i hi = _mm_loadu_si128((const __m128i *)(row + x + 16));
+      v = _mm_packus_epi16(_mm_and_si128(v, even), _mm_and_si128(hi, even));
+    }
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    ph.add8(_mm_cvtsi128_si64(v));
+    ph.add8(_mm_cvtsi128_si64(_mm_unpackhi_epi64(v, v)));
+  }
+  sum += (uint64_t)_mm_cvtsi128_si64(acc) + (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc));
+#else
+  (void)row, (void)ph, (void)sum;
+#endif
+  return x / x_skip;
+}
+
+}  // namespace
+
+void luma_histogram(const uint8_t *y, int stride, const Rect &rect, int x_skip, int y_skip, LumaStats *stats) {
+  PartialHistograms ph;
+  uint64_t sum = 0;
+  uint32_t count = 0;
+  const int samples_per_row = (rect.w + x_skip - 1) / x_skip;
+
+  for (int r = rect.y; r < rect.y + rect.h; r += y_skip) {
+    const uint8_t *row = y + (size_t)r * stride + rect.x;
+    int i = (x_skip == 1 || x_skip == 2) ? row_simd(row, rect.w, x_skip, ph, sum) : 0;
+    for (; i < samples_per_row; ++i) {
+      uint8_t lum = row[i * x_skip];
+      ph.h[i & 3][lum]++;
+      sum += lum;
+    }
+    count += samples_per_row;
+  }
+
+  for (int i = 0; i < 256; ++i) {
+    stats->hist[i] = ph.h[0][i] + ph.h[1][i] + ph.h[2][i] + ph.h[3][i];
+  }
+  stats->count = count;
+  stats->sum = sum;
+}
+
+static int highest_with_count_above(const uint32_t *hist, uint32_t target) {
+  uint32_t cur = 0;
+  int lum = 255;
+  for (; lum >= 0; lum--) {
+    cur += hist[lum];
+    if (cur >= target) break;
+  }
+  return lum;
+}
+
+int LumaStats::percentile(float p) const {
+  return highest_with_count_above(hist, (uint32_t)(count * (1.0f - p)));
+}
+
+int LumaStats::median() const {
+  return highest_with_count_above(hist, count / 2);
+}
+
+float LumaStats::fraction_below(int lo) const {
+  uint32_t n = 0;
+  for (int i = 0; i <= lo && i < 256; ++i) n += hist[i];
+  return count ? (float)n / count : 0.0f;
+}
+
+float LumaStats::fraction_above(int hi) const {
+  uint32_t n = 0;
+  for (int i = hi < 0 ? 0 : hi; i < 256; ++i) n += hist[i];
+  return count ? (float)n / count : 0.0f;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/util.h"
+
+// Luminance statistics of a subsampled rectangle of a Y plane, for auto exposure.
+struct LumaStats {
+  uint32_t hist[256];
+  uint32_t count;
+  uint64_t sum;
+
+  float mean() const { return count ? (float)sum / count : 0.0f; }
+  // highest luminance with at least count * (1 - p) pixels at or above it, median() is percentile(0.5)
+  int percentile(float p) const;
+  int median() const;
+  // fraction of pixels at or below lo and at or above hi
+  float fraction_below(int lo) const;
+  float fraction_above(int hi) const;
+};
+
+// Samples every x_skip-th pixel of every y_skip-th row of rect. Rows are stride bytes apart.
+// The common x_skip of 1 and 2 are vectorized with NEON on aarch64 and SSE2 on x86_64.
+void luma_histogram(const uint8_t *y, int stride, const Rect &rect, int x_skip, int y_skip, LumaStats *stats);
@@ -8,6 +8,7 @@
 
 #include "common/util.h"
 #include "system/camerad/cameras/camera_common.h"
+#include "system/camerad/cameras/luma_histogram.h"
 
 #define W 240
 #define H 160
@@ -82,3 +83,34 @@ TEST_CASE("camera.test_calculate_exposure_value") {
 
   delete[] fb_y;
 }
+
+TEST_CASE("camera.test_luma_histogram") {
+  // odd rects and skips exercise the vector loops and the scalar tails
+  uint8_t *fb_y = new uint8_t[W*H];
+  for (int i = 0; i < W*H; i++) fb_y[i] = (i * 7919) % 251 + (i % 5);
+
+  for (int x_skip = 1; x_skip <= 4; x_skip++) {
+    for (int y_skip = 1; y_skip <= 4; y_skip++) {
+      for (Rect rect : {(Rect){0, 0, W, H}, (Rect){3, 5, 101, 77}, (Rect){W-67, H-9, 67, 9}, (Rect){1, 1, 31, 2}}) {
+        uint32_t hist[256] = {0};
+        uint32_t count = 0;
+        uint64_t sum = 0;
+        for (int y = rect.y; y < rect.y + rect.h; y += y_skip) {
+          for (int x = rect.x; x < rect.x + rect.w; x += x_skip) {
+            hist[fb_y[y*W + x]]++;
+            count++;
+            sum += fb_y[y*W + x];
+          }
+        }
+
+        LumaStats stats;
+        luma_histogram(fb_y, W, rect, x_skip, y_skip, &stats);
+        REQUIRE(stats.count == count);
+        REQUIRE(stats.sum == sum);
+        REQUIRE(memcmp(stats.hist, hist, sizeof(hist)) == 0);
+      }
+    }
+  }
+
+  delete[] fb_y;
+}
@@ -52,6 +52,12 @@ MessagesWidget::MessagesWidget(QWidget *parent) : menu(new QMenu(this)), QWidget
     view->updateBytesSectionSize();
     updateTitle();
   });
+  auto rows_changed = [this]() {
+    view->updateBytesSectionSize();
+    updateTitle();
+  };
+  QObject::connect(model, &MessageListModel::rowsInserted, rows_changed);
+  QObject::connect(model, &MessageListModel::rowsRemoved, rows_changed);
   QObject::connect(view->selectionModel(), &QItemSelectionModel::currentChanged, [=](const QModelIndex &current, const QModelIndex &previous) {
     if (current.isValid() && current.row() < model->items_.size()) {
       const auto &id = model->items_[current.row()].id;
@@ -113,10 +119,8 @@ void MessagesWidget::updateTitle() {
 }
 
 void MessagesWidget::selectMessage(const MessageId &msg_id) {
-  auto it = std::find_if(model->items_.cbegin(), model->items_.cend(),
-                         [&msg_id](auto &item) { return item.id == msg_id; });
-  if (it != model->items_.cend()) {
-    view->setCurrentIndex(model->index(std::distance(model->items_.cbegin(), it), 0));
+  if (int row = model->row(msg_id); row != -1) {
+    view->setCurrentIndex(model->index(row, 0));
   }
 }
 
@@ -212,7 +216,11 @@ QVariant MessageListModel::data(const QModelIndex &index, int role) const {
 }
 
 void MessageListModel::setFilterStrings(const QMap<int, QString> &filters) {
-  filters_ = filters;
+  filters_.clear();
+  for (auto it = filters.cbegin(); it != filters.cend(); ++it) {
+    filters_.push_back(compileFilter(it.key(), it.value()));
+  }
+  dynamic_filters_ = filters.count(Column::FREQ) || filters.count(Column::COUNT) || filters.count(Column::DATA);
   filterAndSort();
 }
 
@@ -229,30 +237,32 @@ void MessageListModel::dbcModified() {
   filterAndSort();
 }
 
-void MessageListModel::sortItems(std::vector<MessageListModel::Item> &items) {
-  auto compare = [this](const auto &l, const auto &r) {
+bool MessageListModel::lessThan(const Item &l, const Item &r) const {
+  auto compare = [this](const Item &l, const Item &r) {
     switch (sort_column) {
       case Column::NAME: return std::tie(l.name, l.id) < std::tie(r.name, r.id);
       case Column::SOURCE: return std::tie(l.id.source, l.id.address) < std::tie(r.id.source, r.id.address);
       case Column::ADDRESS: return std::tie(l.id.address, l.id.source) < std::tie(r.id.address, r.id.source);
       case Column::NODE: return std::tie(l.node, l.id) < std::tie(r.node, r.id);
-      case Column::FREQ: return std::tie(can->lastMessage(l.id).freq, l.id) < std::tie(can->lastMessage(r.id).freq, r.id);
-      case Column::COUNT: return std::tie(can->lastMessage(l.id).count, l.id) < std::tie(can->lastMessage(r.id).count, r.id);
+      case Column::FREQ:
+      case Column::COUNT: return std::tie(l.sort_key, l.id) < std::tie(r.sort_key, r.id);
       default: return false; // Default case to suppress compiler warning
     }
   };
-
-  if (sort_order == Qt::DescendingOrder)
-    std::stable_sort(items.rbegin(), items.rend(), compare);
-  else
-    std::stable_sort(items.begin(), items.end(), compare);
+  return sort_order == Qt::DescendingOrder ? compare(r, l) : compare(l, r);
 }
 
-static bool parseRange(const QString &filter, uint32_t value, int base = 10) {
+MessageListModel::Filter MessageListModel::compileFilter(int column, const QString &text) {
+  Filter filter = {.column = column, .text = text};
+  if (column != Column::SOURCE && column != Column::ADDRESS && column != Column::FREQ && column != Column::COUNT) {
+    return filter;
+  }
+
   // Parse out filter string into a range (e.g. "1" -> {1, 1}, "1-3" -> {1, 3}, "1-" -> {1, inf})
+  const int base = column == Column::ADDRESS ? 16 : 10;
   unsigned int min = std::numeric_limits<unsigned int>::min();
   unsigned int max = std::numeric_limits<unsigned int>::max();
-  auto s = filter.split('-');
+  auto s = text.split('-');
   bool ok = s.size() >= 1 && s.size() <= 2;
   if (ok && !s[0].isEmpty()) min = s[0].toUInt(&ok, base);
   if (ok && s.size() == 1) {
@@ -260,52 +270,34 @@ static bool parseRange(const QString &filter, uint32_t value, int base = 10) {
   } else if (ok && s.size() == 2 && !s[1].isEmpty()) {
     max = s[1].toUInt(&ok, base);
   }
-  return ok && value >= min && value <= max;
+  filter.valid_range = ok;
+  filter.min = min;
+  filter.max = max;
+  return filter;
 }
 
-bool MessageListModel::match(const MessageListModel::Item &item) {
-  if (filters_.isEmpty())
-    return true;
-
-  bool match = true;
-  const auto &data = can->lastMessage(item.id);
-  for (auto it = filters_.cbegin(); it != filters_.cend() && match; ++it) {
-    const QString &txt = it.value();
-    switch (it.key()) {
+bool MessageListModel::match(const MessageListModel::Item &item) const {
+  return std::all_of(filters_.cbegin(), filters_.cend(), [&item](const Filter &f) {
+    switch (f.column) {
       case Column::NAME: {
-        match = item.name.contains(txt, Qt::CaseInsensitive);
-        if (!match) {
-          const auto m = dbc()->msg(item.id);
-          match = m && std::any_of(m->sigs.cbegin(), m->sigs.cend(),
-                                   [&txt](const auto &s) { return s->name.contains(txt, Qt::CaseInsensitive); });
-        }
-        break;
+        if (item.name.contains(f.text, Qt::CaseInsensitive)) return true;
+        const auto m = dbc()->msg(item.id);
+        return m && std::any_of(m->sigs.cbegin(), m->sigs.cend(),
+                                [&f](const auto &s) { return s->name.contains(f.text, Qt::CaseInsensitive); });
       }
-      case Column::SOURCE:
-        match = parseRange(txt, item.id.source);
-        break;
+      case Column::SOURCE: return f.inRange(item.id.source);
       case Column::ADDRESS:
-        match = toHexString(item.id.address).contains(txt, Qt::CaseInsensitive);
-        match = match || parseRange(txt, item.id.address, 16);
-        break;
-      case Column::NODE:
-        match = item.node.contains(txt, Qt::CaseInsensitive);
-        break;
-      case Column::FREQ:
-        match = parseRange(txt, data.freq);
-        break;
-      case Column::COUNT:
-        match = parseRange(txt, data.count);
-        break;
-      case Column::DATA:
-        match = utils::toHex(data.dat).contains(txt, Qt::CaseInsensitive);
-        break;
+        return toHexString(item.id.address).contains(f.text, Qt::CaseInsensitive) || f.inRange(item.id.address);
+      case Column::NODE: return item.node.contains(f.text, Qt::CaseInsensitive);
+      case Column::FREQ: return f.inRange(can->lastMessage(item.id).freq);
+      case Column::COUNT: return f.inRange(can->lastMessage(item.id).count);
+      case Column::DATA: return utils::toHex(can->lastMessage(item.id).dat).contains(f.text, Qt::CaseInsensitive);
+      default: return true;
     }
-  }
-  return match;
+  });
 }
 
-bool MessageListModel::filterAndSort() {
+bool MessageListModel::filterAndSort(bool resort) {
   // merge CAN and DBC messages
   std::vector<MessageId> all_messages;
   all_messages.reserve(can->lastMessages().size() + dbc_messages_.size());
@@ -316,7 +308,7 @@ bool MessageListModel::filterAndSort() {
   }
   all_messages.insert(all_messages.end(), dbc_msgs.begin(), dbc_msgs.end());
 
-  // filter and sort
+  // filter
   std::vector<Item> items;
   items.reserve(all_messages.size());
   for (const auto &id : all_messages) {
@@ -325,37 +317,154 @@ bool MessageListModel::filterAndSort() {
       Item item = {.id = id,
                   .name = msg ? msg->name : UNTITLED,
                   .node = msg ? msg->transmitter : QString()};
+      if (dynamicSortColumn()) {
+        const auto &data = can->lastMessage(id);
+        item.sort_key = sort_column == Column::FREQ ? data.freq : data.count;
+      }
       if (match(item))
-        items.emplace_back(item);
+        items.emplace_back(std::move(item));
+    }
+  }
+  return updateItems(items, resort);
+}
+
+// Takes items_ to the new set of matched items with row removals, moves and insertions, so
+// the view keeps its selection and scroll position. Only rows whose sort key changed move.
+bool MessageListModel::updateItems(std::vector<Item> &items, bool resort) {
+  std::unordered_map<MessageId, Item *> matched;
+  matched.reserve(items.size());
+  for (auto &item : items) matched[item.id] = &item;
+
+  std::vector<int> removed;
+  for (int row = 0; row < items_.size(); ++row) {
+    if (!matched.count(items_[row].id)) removed.push_back(row);
+  }
+  const size_t added_count = std::count_if(items.cbegin(), items.cend(), [this](auto &item) { return !rows_.count(item.id); });
+  // a new filter or stream changes most rows, one reset is cheaper than that many row signals
+  const size_t MAX_ROW_CHANGES = 64;
+  if (items_.empty() || removed.size() + added_count > std::max(MAX_ROW_CHANGES, items_.size() / 2)) {
+    return resetItems(items);
+  }
+
+  // drop the rows no longer matched, a run at a time from the bottom
+  for (int i = removed.size() - 1; i >= 0;) {
+    int first = i;
+    while (first > 0 && removed[first - 1] == removed[first] - 1) --first;
+    beginRemoveRows({}, removed[first], removed[i]);
+    items_.erase(items_.begin() + removed[first], items_.begin() + removed[i] + 1);
+    endRemoveRows();
+    i = first - 1;
+  }
+
+  // move the rows whose sort key or name changed
+  std::vector<Item> moved;
+  for (auto &item : items_) {
+    const Item &next = *matched.at(item.id);
+    if (resort || item.sort_key != next.sort_key || !(item == next)) {
+      moved.push_back(next);
+    }
+  }
+  if (!moved.empty()) {
+    emit layoutAboutToBeChanged();
+    const QModelIndexList persistent = persistentIndexList();
+    std::vector<MessageId> persistent_ids;
+    for (const auto &index : persistent) persistent_ids.push_back(items_[index.row()].id);
+
+    if (moved.size() > items_.size() / 4) {
+      for (auto &item : items_) item = *matched.at(item.id);
+      std::sort(items_.begin(), items_.end(), [this](auto &l, auto &r) { return lessThan(l, r); });
+    } else {
+      std::unordered_map<MessageId, int> moved_ids;
+      for (int i = 0; i < moved.size(); ++i) moved_ids[moved[i].id] = i;
+      items_.erase(std::remove_if(items_.begin(), items_.end(), [&](auto &item) { return moved_ids.count(item.id); }), items_.end());
+      for (auto &item : moved) {
+        auto it = std::lower_bound(items_.begin(), items_.end(), item, [this](auto &l, auto &r) { return lessThan(l, r); });
+        items_.insert(it, std::move(item));
+      }
     }
+    updateRows();
+
+    QModelIndexList to;
+    for (int i = 0; i < persistent.size(); ++i) {
+      to.push_back(index(rows_.at(persistent_ids[i]), persistent[i].column()));
+    }
+    changePersistentIndexList(persistent, to);
+    emit layoutChanged();
+  }
+
+  // insert the new rows, a run at a time where they land next to each other
+  std::vector<Item> added;
+  added.reserve(added_count);
+  for (auto &item : items) {
+    if (!rows_.count(item.id)) added.push_back(item);
+  }
+  auto less = [this](auto &l, auto &r) { return lessThan(l, r); };
+  std::sort(added.begin(), added.end(), less);
+  for (auto it = added.begin(); it != added.end();) {
+    const int row = std::lower_bound(items_.begin(), items_.end(), *it, less) - items_.begin();
+    auto last = row < items_.size() ? std::lower_bound(it, added.end(), items_[row], less) : added.end();
+    beginInsertRows({}, row, row + (last - it) - 1);
+    items_.insert(items_.begin() + row, std::make_move_iterator(it), std::make_move_iterator(last));
+    endInsertRows();
+    it = last;
   }
-  sortItems(items);
 
+  if (!removed.empty() || !added.empty()) updateRows();
+  return !removed.empty() || !moved.empty() || !added.empty();
+}
+
+bool MessageListModel::resetItems(std::vector<Item> &items) {
+  std::sort(items.begin(), items.end(), [this](auto &l, auto &r) { return lessThan(l, r); });
   if (items_ != items) {
     beginResetModel();
     items_ = std::move(items);
+    updateRows();
     endResetModel();
     return true;
   }
+  // same rows in the same order, only the sort keys are new
+  items_ = std::move(items);
   return false;
 }
 
+void MessageListModel::updateRows() {
+  rows_.clear();
+  rows_.reserve(items_.size());
+  for (int row = 0; row < items_.size(); ++row) {
+    rows_[items_[row].id] = row;
+  }
+}
+
 void MessageListModel::msgsReceived(const std::set<MessageId> *new_msgs, bool has_new_ids) {
-  if (has_new_ids || ((filters_.count(Column::FREQ) || filters_.count(Column::COUNT) || filters_.count(Column::DATA)) &&
-                      ++sort_threshold_ == settings.fps)) {
-    sort_threshold_ = 0;
-    if (filterAndSort()) return;
+  // values that change while streaming are re-filtered and re-sorted once a second
+  const bool refresh = ++sort_threshold_ >= settings.fps;
+  if (refresh) sort_threshold_ = 0;
+  if (has_new_ids || (refresh && (dynamic_filters_ || dynamicSortColumn()))) {
+    filterAndSort();
   }
 
-  // Update viewport
-  emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
+  // Update viewport: the rows that received messages, and all of them once a second since rows go inactive silently
+  int first = 0, last = rowCount() - 1;
+  if (new_msgs && !refresh) {
+    first = rowCount();
+    last = -1;
+    for (const auto &id : *new_msgs) {
+      if (auto it = rows_.find(id); it != rows_.end()) {
+        first = std::min(first, it->second);
+        last = std::max(last, it->second);
+      }
+    }
+  }
+  if (first <= last) {
+    emit dataChanged(index(first, Column::FREQ), index(last, Column::DATA));
+  }
 }
 
 void MessageListModel::sort(int column, Qt::SortOrder order) {
   if (column != Column::DATA) {
     sort_column = column;
     sort_order = order;
-    filterAndSort();
+    filterAndSort(true);
   }
 }
 
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <optional>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include <QAbstractTableModel>
@@ -38,26 +39,50 @@ public:
   void setFilterStrings(const QMap<int, QString> &filters);
   void showInactivemessages(bool show);
   void msgsReceived(const std::set<MessageId> *new_msgs, bool has_new_ids);
-  bool filterAndSort();
+  bool filterAndSort(bool resort = false);
   void dbcModified();
+  // row of the message, -1 if it isn't listed
+  int row(const MessageId &id) const {
+    auto it = rows_.find(id);
+    return it != rows_.end() ? it->second : -1;
+  }
 
   struct Item {
     MessageId id;
     QString name;
     QString node;
+    // freq or count at the time the item was placed, when sorted by one of them
+    double sort_key = 0;
     bool operator==(const Item &other) const {
       return id == other.id && name == other.name && node == other.node;
     }
   };
+  // A filter string, parsed when it is edited. Numeric columns take a value or a range
+  // ("1", "1-3", "1-"), in hex for the address.
+  struct Filter {
+    int column;
+    QString text;
+    bool valid_range = false;
+    uint32_t min = 0;
+    uint32_t max = 0;
+    bool inRange(uint32_t value) const { return valid_range && value >= min && value <= max; }
+  };
+  static Filter compileFilter(int column, const QString &text);
   std::vector<Item> items_;
   bool show_inactive_messages = true;
 
 private:
-  void sortItems(std::vector<MessageListModel::Item> &items);
-  bool match(const MessageListModel::Item &id);
-
-  QMap<int, QString> filters_;
+  bool lessThan(const Item &l, const Item &r) const;
+  bool match(const Item &item) const;
+  bool dynamicSortColumn() const { return sort_column == Column::FREQ || sort_column == Column::COUNT; }
+  bool resetItems(std::vector<Item> &items);
+  bool updateItems(std::vector<Item> &items, bool resort);
+  void updateRows();
+
+  std::vector<Filter> filters_;
+  bool dynamic_filters_ = false;
   std::set<MessageId> dbc_messages_;
+  std::unordered_map<MessageId, int> rows_;
   int sort_column = 0;
   Qt::SortOrder sort_order = Qt::AscendingOrder;
   int sort_threshold_ = 0;
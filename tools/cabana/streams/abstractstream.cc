@@ -1,5 +1,6 @@
 #include "tools/cabana/streams/abstractstream.h"
 
+#include <iterator>
 #include <limits>
 #include <utility>
 
@@ -117,8 +118,8 @@ void AbstractStream::updateEvent(const MessageId &id, double sec, const uint8_t
 
 const std::vector<const CanEvent *> &AbstractStream::events(const MessageId &id) const {
   static std::vector<const CanEvent *> empty_events;
-  auto it = events_.find(id);
-  return it != events_.end() ? it->second : empty_events;
+  auto it = events_->events_map.find(id);
+  return it != events_->events_map.end() ? it->second : empty_events;
 }
 
 const CanData &AbstractStream::lastMessage(const MessageId &id) const {
@@ -146,9 +147,9 @@ void AbstractStream::updateLastMsgsTo(double sec) {
   current_sec_ = sec;
   uint64_t last_ts = toMonoTime(sec);
   std::unordered_map<MessageId, CanData> msgs;
-  msgs.reserve(events_.size());
+  msgs.reserve(events_->events_map.size());
 
-  for (const auto &[id, ev] : events_) {
+  for (const auto &[id, ev] : events_->events_map) {
     auto it = std::upper_bound(ev.begin(), ev.end(), last_ts, CompareCanEvent());
     if (it != ev.begin()) {
       auto &m = msgs[id];
@@ -188,8 +189,12 @@ void AbstractStream::waitForSeekFinshed() {
 }
 
 const CanEvent *AbstractStream::newEvent(uint64_t mono_time, const cereal::CanData::Reader &c) {
+  return newEvent(event_buffer_.get(), mono_time, c);
+}
+
+const CanEvent *AbstractStream::newEvent(MonotonicBuffer *buffer, uint64_t mono_time, const cereal::CanData::Reader &c) {
   auto dat = c.getDat();
-  CanEvent *e = (CanEvent *)event_buffer_->allocate(sizeof(CanEvent) + sizeof(uint8_t) * dat.size());
+  CanEvent *e = (CanEvent *)buffer->allocate(sizeof(CanEvent) + sizeof(uint8_t) * dat.size());
   e->src = c.getSrc();
   e->address = c.getAddress();
   e->mono_time = mono_time;
@@ -210,17 +215,51 @@ void AbstractStream::mergeEvents(const std::vector<const CanEvent *> &events) {
   if (!events.empty()) {
     for (const auto &[id, new_e] : msg_events) {
       if (!new_e.empty()) {
-        auto &e = events_[id];
+        auto &e = events_->events_map[id];
         auto pos = std::upper_bound(e.cbegin(), e.cend(), new_e.front()->mono_time, CompareCanEvent());
         e.insert(pos, new_e.cbegin(), new_e.cend());
       }
     }
-    auto pos = std::upper_bound(all_events_.cbegin(), all_events_.cend(), events.front()->mono_time, CompareCanEvent());
-    all_events_.insert(pos, events.cbegin(), events.cend());
+    auto &all_events = events_->all_events;
+    auto pos = std::upper_bound(all_events.cbegin(), all_events.cend(), events.front()->mono_time, CompareCanEvent());
+    all_events.insert(pos, events.cbegin(), events.cend());
     emit eventsMerged(msg_events);
   }
 }
 
+std::shared_ptr<CanEventsIndex> AbstractStream::mergeIndex(const CanEventsIndex &index, const MessageEventsMap &new_events_map,
+                                                           const std::vector<const CanEvent *> &new_events) {
+  // a single pass into the new vectors, new events go after existing ones with the same time
+  auto merge = [](const std::vector<const CanEvent *> &events, const std::vector<const CanEvent *> &new_e, std::vector<const CanEvent *> &out) {
+    out.reserve(events.size() + new_e.size());
+    std::merge(events.cbegin(), events.cend(), new_e.cbegin(), new_e.cend(), std::back_inserter(out),
+               [](const CanEvent *l, const CanEvent *r) { return l->mono_time < r->mono_time; });
+  };
+
+  auto merged = std::make_shared<CanEventsIndex>();
+  merged->events_map.reserve(index.events_map.size() + new_events_map.size());
+  for (const auto &[id, e] : index.events_map) {
+    auto it = new_events_map.find(id);
+    if (it == new_events_map.end()) {
+      merged->events_map.emplace(id, e);
+    } else {
+      merge(e, it->second, merged->events_map[id]);
+    }
+  }
+  for (const auto &[id, new_e] : new_events_map) {
+    if (!index.events_map.count(id)) {
+      merged->events_map.emplace(id, new_e);
+    }
+  }
+  merge(index.all_events, new_events, merged->all_events);
+  return merged;
+}
+
+void AbstractStream::swapEvents(std::shared_ptr<CanEventsIndex> index, const MessageEventsMap &new_events) {
+  events_ = std::move(index);
+  emit eventsMerged(new_events);
+}
+
 std::pair<CanEventIter, CanEventIter> AbstractStream::eventsInRange(const MessageId &id, std::optional<std::pair<double, double>> time_range) const {
   const auto &events = can->events(id);
   if (!time_range) return {events.begin(), events.end()};
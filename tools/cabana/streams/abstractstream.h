@@ -56,6 +56,13 @@ struct CompareCanEvent {
 typedef std::unordered_map<MessageId, std::vector<const CanEvent *>> MessageEventsMap;
 using CanEventIter = std::vector<const CanEvent *>::const_iterator;
 
+// The events by message and in time order. A live stream adds to its index in place. A replay stream
+// builds each new index off the GUI thread and shares it with the GUI, so that one is never changed.
+struct CanEventsIndex {
+  MessageEventsMap events_map;
+  std::vector<const CanEvent *> all_events;
+};
+
 class AbstractStream : public QObject {
   Q_OBJECT
 
@@ -84,8 +91,8 @@ public:
 
   inline const std::unordered_map<MessageId, CanData> &lastMessages() const { return last_msgs; }
   bool isMessageActive(const MessageId &id) const;
-  inline const MessageEventsMap &eventsMap() const { return events_; }
-  inline const std::vector<const CanEvent *> &allEvents() const { return all_events_; }
+  inline const MessageEventsMap &eventsMap() const { return events_->events_map; }
+  inline const std::vector<const CanEvent *> &allEvents() const { return events_->all_events; }
   const CanData &lastMessage(const MessageId &id) const;
   const std::vector<const CanEvent *> &events(const MessageId &id) const;
   std::pair<CanEventIter, CanEventIter> eventsInRange(const MessageId &id, std::optional<std::pair<double, double>> time_range) const;
@@ -110,10 +117,15 @@ public:
 
 protected:
   void mergeEvents(const std::vector<const CanEvent *> &events);
+  // Replaces the events with an index merged off the GUI thread, new_events are the events it added.
+  void swapEvents(std::shared_ptr<CanEventsIndex> index, const MessageEventsMap &new_events);
+  // Returns a new index with the sorted new_events merged into the events of index.
+  static std::shared_ptr<CanEventsIndex> mergeIndex(const CanEventsIndex &index, const MessageEventsMap &new_events_map,
+                                                    const std::vector<const CanEvent *> &new_events);
   const CanEvent *newEvent(uint64_t mono_time, const cereal::CanData::Reader &c);
+  static const CanEvent *newEvent(MonotonicBuffer *buffer, uint64_t mono_time, const cereal::CanData::Reader &c);
   void updateEvent(const MessageId &id, double sec, const uint8_t *data, uint8_t size);
   void waitForSeekFinshed();
-  std::vector<const CanEvent *> all_events_;
   double current_sec_ = 0;
   std::optional<std::pair<double, double>> time_range_;
 
@@ -122,7 +134,7 @@ private:
   void updateLastMsgsTo(double sec);
   void updateMasks();
 
-  MessageEventsMap events_;
+  std::shared_ptr<CanEventsIndex> events_ = std::make_shared<CanEventsIndex>();
   std::unordered_map<MessageId, CanData> last_msgs;
   std::unique_ptr<MonotonicBuffer> event_buffer_;
 
@@ -95,8 +95,8 @@ void LiveStream::timerEvent(QTimerEvent *event) {
       lastest_event_ts = std::max(lastest_event_ts, last_received_ts);
       received_events_.clear();
     }
-    if (!all_events_.empty()) {
-      begin_event_ts = all_events_.front()->mono_time;
+    if (!allEvents().empty()) {
+      begin_event_ts = allEvents().front()->mono_time;
       updateEvents();
       return;
     }
@@ -106,10 +106,11 @@ void LiveStream::timerEvent(QTimerEvent *event) {
 
 void LiveStream::updateEvents() {
   static double prev_speed = 1.0;
+  const auto &all_events = allEvents();
 
   if (first_update_ts == 0) {
     first_update_ts = nanos_since_boot();
-    first_event_ts = current_event_ts = all_events_.back()->mono_time;
+    first_event_ts = current_event_ts = all_events.back()->mono_time;
   }
 
   if (paused_ || prev_speed != speed_) {
@@ -120,10 +121,10 @@ void LiveStream::updateEvents() {
   }
 
   uint64_t last_ts = post_last_event && speed_ == 1.0
-                       ? all_events_.back()->mono_time
+                       ? all_events.back()->mono_time
                        : first_event_ts + (nanos_since_boot() - first_update_ts) * speed_;
-  auto first = std::upper_bound(all_events_.cbegin(), all_events_.cend(), current_event_ts, CompareCanEvent());
-  auto last = std::upper_bound(first, all_events_.cend(), last_ts, CompareCanEvent());
+  auto first = std::upper_bound(all_events.cbegin(), all_events.cend(), current_event_ts, CompareCanEvent());
+  auto last = std::upper_bound(first, all_events.cend(), last_ts, CompareCanEvent());
 
   for (auto it = first; it != last; ++it) {
     const CanEvent *e = *it;
@@ -5,6 +5,7 @@
 #include <QGridLayout>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QtConcurrent>
 
 #include "common/timing.h"
 #include "common/util.h"
@@ -24,26 +25,85 @@ ReplayStream::ReplayStream(QObject *parent) : AbstractStream(parent) {
   });
 }
 
-void ReplayStream::mergeSegments() {
-  auto event_data = replay->getEventData();
+ReplayStream::~ReplayStream() {
+  replay.reset();
+  if (merge_thread_.joinable()) {
+    {
+      std::lock_guard lk(merge_lock_);
+      exit_merge_ = true;
+    }
+    merge_cv_.notify_one();
+    merge_thread_.join();
+  }
+}
+
+void ReplayStream::mergeThread() {
+  std::unique_lock lk(merge_lock_);
+  while (true) {
+    merge_cv_.wait(lk, [this]() { return exit_merge_ || pending_event_data_; });
+    if (exit_merge_) break;
+
+    auto event_data = std::move(pending_event_data_);
+    lk.unlock();
+    mergeSegments(event_data);
+    lk.lock();
+  }
+}
+
+void ReplayStream::mergeSegments(const std::shared_ptr<SegmentManager::EventData> &event_data) {
+  struct SegmentEvents {
+    std::shared_ptr<Segment> segment;
+    std::unique_ptr<MonotonicBuffer> buffer;
+    std::vector<const CanEvent *> events;
+    MessageEventsMap events_map;
+  };
+  std::vector<SegmentEvents> blocks;
   for (const auto &[n, seg] : event_data->segments) {
-    if (!processed_segments.count(n)) {
-      processed_segments.insert(n);
-
-      std::vector<const CanEvent *> new_events;
-      new_events.reserve(seg->log->events.size());
-      for (const Event &e : seg->log->events) {
-        if (e.which == cereal::Event::Which::CAN) {
-          capnp::FlatArrayMessageReader reader(e.data);
-          auto event = reader.getRoot<cereal::Event>();
-          for (const auto &c : event.getCan()) {
-            new_events.push_back(newEvent(e.mono_time, c));
-          }
+    if (processed_segments.insert(n).second) {
+      blocks.push_back({.segment = seg});
+    }
+  }
+  if (blocks.empty()) return;
+
+  QtConcurrent::blockingMap(blocks, [](SegmentEvents &b) {
+    b.buffer = std::make_unique<MonotonicBuffer>(1024 * 1024);
+    b.events.reserve(b.segment->log->events.size());
+    for (const Event &e : b.segment->log->events) {
+      if (e.which == cereal::Event::Which::CAN) {
+        capnp::FlatArrayMessageReader reader(e.data);
+        auto event = reader.getRoot<cereal::Event>();
+        for (const auto &c : event.getCan()) {
+          b.events.push_back(newEvent(b.buffer.get(), e.mono_time, c));
         }
       }
-      mergeEvents(new_events);
     }
+    for (auto e : b.events) {
+      b.events_map[{.source = e->src, .address = e->address}].push_back(e);
+    }
+  });
+
+  // the segments are in order and don't overlap
+  MessageEventsMap new_events;
+  std::vector<const CanEvent *> new_all_events;
+  for (auto &b : blocks) {
+    if (b.events.empty()) continue;
+
+    for (auto &[id, e] : b.events_map) {
+      auto &all = new_events[id];
+      all.insert(std::upper_bound(all.cbegin(), all.cend(), e.front()->mono_time, CompareCanEvent()), e.cbegin(), e.cend());
+    }
+    auto pos = std::upper_bound(new_all_events.cbegin(), new_all_events.cend(), b.events.front()->mono_time, CompareCanEvent());
+    new_all_events.insert(pos, b.events.cbegin(), b.events.cend());
+    event_buffers_.push_back(std::move(b.buffer));
   }
+  if (new_events.empty()) return;
+
+  // The GUI keeps reading the previous index until it swaps in the new one, neither is changed after this
+  auto index = mergeIndex(*merged_index_, new_events, new_all_events);
+  merged_index_ = index;
+  QMetaObject::invokeMethod(this, [this, index = std::move(index), new_events = std::move(new_events)]() mutable {
+    swapEvents(std::move(index), new_events);
+  }, Qt::QueuedConnection);
 }
 
 bool ReplayStream::loadRoute(const QString &route, const QString &data_dir, uint32_t replay_flags, bool auto_source) {
@@ -58,8 +118,17 @@ bool ReplayStream::loadRoute(const QString &route, const QString &data_dir, uint
     emit seekedTo(sec);
     waitForSeekFinshed();
   };
-  replay->onQLogLoaded = [this](std::shared_ptr<LogReader> qlog) { emit qLogLoaded(qlog); };
-  replay->onSegmentsMerged = [this]() { QMetaObject::invokeMethod(this, &ReplayStream::mergeSegments, Qt::BlockingQueuedConnection); };
+  replay->onQLogLoaded = [this](int segment, std::shared_ptr<LogReader> qlog) { emit qLogLoaded(segment, qlog); };
+  replay->onSegmentsMerged = [this]() {
+    {
+      std::lock_guard lk(merge_lock_);
+      pending_event_data_ = replay->getEventData();
+    }
+    merge_cv_.notify_one();
+  };
+  if (!merge_thread_.joinable()) {
+    merge_thread_ = std::thread(&ReplayStream::mergeThread, this);
+  }
 
   bool success = replay->load();
   if (!success) {
@@ -2,8 +2,11 @@
 
 #include <QCheckBox>
 #include <algorithm>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <thread>
 #include <vector>
 
 #include "common/prefix.h"
@@ -17,6 +20,7 @@ class ReplayStream : public AbstractStream {
 
 public:
   ReplayStream(QObject *parent);
+  ~ReplayStream();
   void start() override { replay->start(); }
   bool loadRoute(const QString &route, const QString &data_dir, uint32_t replay_flags = REPLAY_FLAG_NONE, bool auto_source = false);
   bool eventFilter(const Event *event);
@@ -35,12 +39,23 @@ public:
   void pause(bool pause) override;
 
 signals:
-  void qLogLoaded(std::shared_ptr<LogReader> qlog);
+  void qLogLoaded(int segment, std::shared_ptr<LogReader> qlog);
 
 private:
-  void mergeSegments();
+  void mergeThread();
+  void mergeSegments(const std::shared_ptr<SegmentManager::EventData> &event_data);
   std::unique_ptr<Replay> replay = nullptr;
+
+  // CAN events are extracted and merged in merge_thread_, the GUI thread only swaps in the new index
+  std::thread merge_thread_;
+  std::mutex merge_lock_;
+  std::condition_variable merge_cv_;
+  std::shared_ptr<SegmentManager::EventData> pending_event_data_;
+  bool exit_merge_ = false;
+  // owned by merge_thread_
   std::set<int> processed_segments;
+  std::vector<std::unique_ptr<MonotonicBuffer>> event_buffers_;
+  std::shared_ptr<const CanEventsIndex> merged_index_ = std::make_shared<CanEventsIndex>();
   std::unique_ptr<OpenpilotPrefix> op_prefix;
 };
 
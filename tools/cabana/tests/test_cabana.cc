@@ -1,9 +1,12 @@
 
 #undef INFO
+#include <QCoreApplication>
 #include <QDir>
+#include <QPersistentModelIndex>
 
 #include "catch2/catch.hpp"
 #include "tools/cabana/dbc/dbcmanager.h"
+#include "tools/cabana/messageswidget.h"
 
 const std::string TEST_RLOG_URL = "https://commadataci.blob.core.windows.net/openpilotci/0c94aa1e1296d7c6/2021-05-05--19-48-37/0/rlog.bz2";
 
@@ -155,3 +158,123 @@ TEST_CASE("parse_opendbc") {
   INFO(errors.join("\n").toStdString());
   REQUIRE(errors.empty());
 }
+
+TEST_CASE("MessageListModel::compileFilter") {
+  auto range = MessageListModel::compileFilter(MessageListModel::Column::SOURCE, "1-3");
+  REQUIRE(range.valid_range);
+  REQUIRE((!range.inRange(0) && range.inRange(1) && range.inRange(3) && !range.inRange(4)));
+
+  auto open_range = MessageListModel::compileFilter(MessageListModel::Column::COUNT, "10-");
+  REQUIRE((!open_range.inRange(9) && open_range.inRange(std::numeric_limits<uint32_t>::max())));
+
+  auto address = MessageListModel::compileFilter(MessageListModel::Column::ADDRESS, "1a0");
+  REQUIRE((address.inRange(0x1a0) && !address.inRange(0x1a1)));
+
+  REQUIRE(!MessageListModel::compileFilter(MessageListModel::Column::FREQ, "abc").valid_range);
+  REQUIRE(!MessageListModel::compileFilter(MessageListModel::Column::SOURCE, "1-2-3").valid_range);
+  REQUIRE(!MessageListModel::compileFilter(MessageListModel::Column::NAME, "1").valid_range);
+}
+
+// A stream fed from the test, its messages reach lastMessages() on update()
+class TestStream : public AbstractStream {
+public:
+  TestStream(QObject *parent) : AbstractStream(parent) {}
+  QString routeName() const override { return "test"; }
+  void start() override {}
+  void send(uint32_t address, int count) {
+    const uint8_t dat[8] = {};
+    for (int i = 0; i < count; ++i) updateEvent({.source = 0, .address = address}, current_sec_, dat, sizeof(dat));
+  }
+  void update() {
+    emit privateUpdateLastMsgsSignal();
+    QCoreApplication::processEvents();
+  }
+};
+
+TEST_CASE("MessageListModel incremental updates") {
+  QObject parent;
+  TestStream stream(&parent);
+  can = &stream;
+  MessageListModel model(&parent);
+  int resets = 0, layouts = 0, inserts = 0, removes = 0;
+  QObject::connect(&model, &MessageListModel::modelReset, [&]() { resets++; });
+  QObject::connect(&model, &MessageListModel::layoutChanged, [&]() { layouts++; });
+  QObject::connect(&model, &MessageListModel::rowsInserted, [&]() { inserts++; });
+  QObject::connect(&model, &MessageListModel::rowsRemoved, [&]() { removes++; });
+
+  auto require_sorted = [&]() {
+    for (int i = 0; i < model.items_.size(); ++i) {
+      const auto &id = model.items_[i].id;
+      REQUIRE(model.row(id) == i);
+      if (i > 0) {
+        const auto &prev = model.items_[i - 1].id;
+        const auto l = std::make_pair(can->lastMessage(prev).count, prev), r = std::make_pair(can->lastMessage(id).count, id);
+        REQUIRE(l > r);
+      }
+    }
+  };
+
+  // 100 messages, address n sent n + 1 times, most sent first
+  model.sort(MessageListModel::Column::COUNT, Qt::DescendingOrder);
+  for (uint32_t address = 0; address < 100; ++address) stream.send(address, address + 1);
+  stream.update();
+  model.filterAndSort();
+  REQUIRE(model.rowCount() == 100);
+  require_sorted();
+
+  const MessageId tracked_id = {.source = 0, .address = 42};
+  QPersistentModelIndex tracked = model.index(model.row(tracked_id), MessageListModel::Column::NAME);
+  resets = 0;
+
+  SECTION("rows whose count changed move, the others stay") {
+    stream.send(10, 200);
+    stream.send(42, 5);
+    stream.update();
+    model.filterAndSort();
+    REQUIRE((resets == 0 && layouts == 1 && inserts == 0 && removes == 0));
+    REQUIRE(model.items_[0].id.address == 10);
+    require_sorted();
+    REQUIRE(tracked.row() == model.row(tracked_id));
+
+    // nothing changed, nothing moves
+    model.filterAndSort();
+    REQUIRE(layouts == 1);
+  }
+
+  SECTION("new messages are inserted at their rows") {
+    stream.send(200, 50);
+    stream.send(201, 1);
+    stream.send(202, 1000);
+    stream.update();
+    model.filterAndSort();
+    REQUIRE((resets == 0 && inserts > 0 && removes == 0));
+    REQUIRE(model.rowCount() == 103);
+    REQUIRE(model.items_[0].id.address == 202);
+    require_sorted();
+    REQUIRE(tracked.row() == model.row(tracked_id));
+  }
+
+  SECTION("messages no longer matched are removed") {
+    model.setFilterStrings({{MessageListModel::Column::COUNT, "3-"}});
+    REQUIRE((resets == 0 && removes > 0));
+    REQUIRE(model.rowCount() == 98);
+    REQUIRE(model.row({.source = 0, .address = 1}) == -1);
+    require_sorted();
+    REQUIRE(tracked.row() == model.row(tracked_id));
+  }
+
+  SECTION("changing most rows resets the model") {
+    model.setFilterStrings({{MessageListModel::Column::COUNT, "90-"}});
+    REQUIRE(resets == 1);
+    REQUIRE(model.rowCount() == 11);
+    require_sorted();
+  }
+
+  SECTION("a new sort order keeps the rows") {
+    model.sort(MessageListModel::Column::ADDRESS, Qt::AscendingOrder);
+    REQUIRE((resets == 0 && layouts == 1));
+    for (int i = 0; i < model.rowCount(); ++i) REQUIRE(model.items_[i].id.address == i);
+    REQUIRE(tracked.row() == 42);
+  }
+  can = nullptr;
+}
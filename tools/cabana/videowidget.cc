@@ -4,17 +4,22 @@
 
 #include <QAction>
 #include <QActionGroup>
+#include <QDataStream>
 #include <QMenu>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QSaveFile>
 #include <QStyleOptionSlider>
 #include <QVBoxLayout>
 #include <QtConcurrent>
 
 #include "tools/cabana/tools/routeinfo.h"
+#include "tools/replay/filereader.h"
 
 const int MIN_VIDEO_HEIGHT = 100;
 const int THUMBNAIL_MARGIN = 3;
+const int THUMBNAIL_HEIGHT = MIN_VIDEO_HEIGHT - THUMBNAIL_MARGIN * 2;
+const qint32 THUMBNAIL_CACHE_VERSION = 1;
 
 static const QColor timeline_colors[] = {
   [(int)TimelineType::None] = QColor(111, 143, 175),
@@ -164,6 +169,7 @@ QWidget *VideoWidget::createCameraWidget() {
     if (index != -1) cam_widget->setStreamType((VisionStreamType)camera_tab->tabData(index).toInt());
   });
   QObject::connect(static_cast<ReplayStream*>(can), &ReplayStream::qLogLoaded, cam_widget, &StreamCameraView::parseQLog, Qt::QueuedConnection);
+  cam_widget->loadThumbnailCache();
   slider->installEventFilter(this);
   return w;
 }
@@ -331,21 +337,99 @@ StreamCameraView::StreamCameraView(std::string stream_name, VisionStreamType str
   connect(fade_animation, &QPropertyAnimation::valueChanged, this, QOverload<>::of(&StreamCameraView::update));
 }
 
-void StreamCameraView::parseQLog(std::shared_ptr<LogReader> qlog) {
-  std::mutex mutex;
-  QtConcurrent::blockingMap(qlog->events.cbegin(), qlog->events.cend(), [this, &mutex](const Event &e) {
-    if (e.which == cereal::Event::Which::THUMBNAIL) {
-      capnp::FlatArrayMessageReader reader(e.data);
-      auto thumb_data = reader.getRoot<cereal::Event>().getThumbnail();
-      auto image_data = thumb_data.getThumbnail();
-      if (QPixmap thumb; thumb.loadFromData(image_data.begin(), image_data.size(), "jpeg")) {
-        QPixmap generated_thumb = generateThumbnail(thumb, can->toSeconds(thumb_data.getTimestampEof()));
-        std::lock_guard lock(mutex);
-        thumbnails[thumb_data.getTimestampEof()] = generated_thumb;
-        big_thumbnails[thumb_data.getTimestampEof()] = thumb;
+StreamCameraView::~StreamCameraView() {
+  thumbnail_futures.waitForFinished();
+}
+
+static std::string thumbnailCacheFile(const std::string &route, int segment) {
+  return cacheFilePath("thumbnails|" + route + "|" + std::to_string(segment));
+}
+
+static QMap<uint64_t, QImage> readThumbnailCache(const std::string &file) {
+  QMap<uint64_t, QImage> thumbnails;
+  QFile f(QString::fromStdString(file));
+  if (!f.open(QIODevice::ReadOnly)) return thumbnails;
+
+  QDataStream in(&f);
+  qint32 version = 0;
+  quint32 size = 0;
+  in >> version >> size;
+  for (quint32 i = 0; version == THUMBNAIL_CACHE_VERSION && i < size && in.status() == QDataStream::Ok; ++i) {
+    quint64 ts;
+    QImage thumb;
+    in >> ts >> thumb;
+    thumbnails[ts] = thumb;
+  }
+  if (version != THUMBNAIL_CACHE_VERSION || in.status() != QDataStream::Ok) thumbnails.clear();
+  return thumbnails;
+}
+
+static void writeThumbnailCache(const std::string &file, const QMap<uint64_t, QImage> &thumbnails) {
+  QSaveFile f(QString::fromStdString(file));
+  if (f.open(QIODevice::WriteOnly)) {
+    QDataStream out(&f);
+    out << THUMBNAIL_CACHE_VERSION << (quint32)thumbnails.size();
+    for (auto it = thumbnails.cbegin(); it != thumbnails.cend(); ++it) {
+      out << (quint64)it.key() << it.value();
+    }
+    f.commit();
+  }
+}
+
+void StreamCameraView::loadThumbnailCache() {
+  auto replay = getReplay();
+  if (!replay || replay->hasFlag(REPLAY_FLAG_NO_FILE_CACHE)) return;
+
+  std::vector<std::string> files;
+  for (const auto &[n, _] : replay->route().segments()) {
+    files.push_back(thumbnailCacheFile(replay->route().name(), n));
+  }
+  thumbnail_futures.addFuture(QtConcurrent::run([this, files]() {
+    QMap<uint64_t, QImage> cached;
+    for (const auto &file : files) {
+      auto thumbs = readThumbnailCache(file);
+      for (auto it = thumbs.cbegin(); it != thumbs.cend(); ++it) cached[it.key()] = it.value();
+    }
+    if (!cached.isEmpty()) {
+      QMetaObject::invokeMethod(this, [=]() { addThumbnails(cached, {}); }, Qt::QueuedConnection);
+    }
+  }));
+}
+
+void StreamCameraView::parseQLog(int segment, std::shared_ptr<LogReader> qlog) {
+  auto replay = getReplay();
+  const std::string route = replay->route().name();
+  const bool file_cache = !replay->hasFlag(REPLAY_FLAG_NO_FILE_CACHE);
+
+  thumbnail_futures.addFuture(QtConcurrent::run([=]() {
+    std::mutex mutex;
+    QMap<uint64_t, QImage> small, big;
+    QtConcurrent::blockingMap(qlog->events.cbegin(), qlog->events.cend(), [&](const Event &e) {
+      if (e.which == cereal::Event::Which::THUMBNAIL) {
+        capnp::FlatArrayMessageReader reader(e.data);
+        auto thumb_data = reader.getRoot<cereal::Event>().getThumbnail();
+        auto image_data = thumb_data.getThumbnail();
+        if (QImage thumb; thumb.loadFromData(image_data.begin(), image_data.size(), "jpeg")) {
+          QImage scaled = thumb.scaledToHeight(THUMBNAIL_HEIGHT, Qt::SmoothTransformation);
+          std::lock_guard lock(mutex);
+          small[thumb_data.getTimestampEof()] = scaled;
+          big[thumb_data.getTimestampEof()] = thumb;
+        }
       }
+    });
+    if (small.isEmpty()) return;
+
+    if (file_cache) {
+      writeThumbnailCache(thumbnailCacheFile(route, segment), small);
     }
-  });
+    QMetaObject::invokeMethod(this, [=]() { addThumbnails(small, big); }, Qt::QueuedConnection);
+  }));
+}
+
+void StreamCameraView::addThumbnails(const QMap<uint64_t, QImage> &small, const QMap<uint64_t, QImage> &big) {
+  for (auto it = small.cbegin(); it != small.cend(); ++it) thumbnails[it.key()] = it.value();
+  for (auto it = big.cbegin(); it != big.cend(); ++it) big_thumbnails[it.key()] = it.value();
+  if (!big.isEmpty()) scaled_thumbnails.clear();
   update();
 }
 
@@ -369,25 +453,23 @@ void StreamCameraView::paintGL() {
   }
 }
 
-QPixmap StreamCameraView::generateThumbnail(QPixmap thumb, double seconds) {
-  QPixmap scaled = thumb.scaledToHeight(MIN_VIDEO_HEIGHT - THUMBNAIL_MARGIN * 2, Qt::SmoothTransformation);
-  QPainter p(&scaled);
-  p.setPen(QPen(palette().color(QPalette::BrightText), 2));
-  p.drawRect(scaled.rect());
-  if (auto alert = getReplay()->findAlertAtTime(seconds)) {
-    p.setFont(QFont(font().family(), 10));
-    drawAlert(p, scaled.rect(), *alert);
-  }
-  return scaled;
-}
-
 void StreamCameraView::drawScrubThumbnail(QPainter &p) {
   p.fillRect(rect(), Qt::black);
-  auto it = big_thumbnails.lowerBound(can->toMonoTime(thumbnail_dispaly_time));
-  if (it != big_thumbnails.end()) {
-    QPixmap scaled_thumb = it.value().scaled(rect().size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    QRect thumb_rect(rect().center() - scaled_thumb.rect().center(), scaled_thumb.size());
-    p.drawPixmap(thumb_rect.topLeft(), scaled_thumb);
+  // thumbnails loaded from the cache stand in until the qlog is decoded
+  const auto &source = big_thumbnails.isEmpty() ? thumbnails : big_thumbnails;
+  auto it = source.lowerBound(can->toMonoTime(thumbnail_dispaly_time));
+  if (it != source.end()) {
+    if (scaled_size != size()) {
+      scaled_thumbnails.clear();
+      scaled_size = size();
+    }
+    QImage *scaled_thumb = scaled_thumbnails.object(it.key());
+    if (!scaled_thumb) {
+      scaled_thumb = new QImage(it.value().scaled(rect().size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+      scaled_thumbnails.insert(it.key(), scaled_thumb);
+    }
+    QRect thumb_rect(rect().center() - scaled_thumb->rect().center(), scaled_thumb->size());
+    p.drawImage(thumb_rect.topLeft(), *scaled_thumb);
     drawTime(p, thumb_rect, thumbnail_dispaly_time);
   }
 }
@@ -395,14 +477,21 @@ void StreamCameraView::drawScrubThumbnail(QPainter &p) {
 void StreamCameraView::drawThumbnail(QPainter &p) {
   auto it = thumbnails.lowerBound(can->toMonoTime(thumbnail_dispaly_time));
   if (it != thumbnails.end()) {
-    const QPixmap &thumb = it.value();
+    const QImage &thumb = it.value();
     auto [min_sec, max_sec] = can->timeRange().value_or(std::make_pair(can->minSeconds(), can->maxSeconds()));
     int pos = (thumbnail_dispaly_time - min_sec) * width() / (max_sec - min_sec);
     int x = std::clamp(pos - thumb.width() / 2, THUMBNAIL_MARGIN, width() - thumb.width() - THUMBNAIL_MARGIN + 1);
     int y = height() - thumb.height() - THUMBNAIL_MARGIN;
-
-    p.drawPixmap(x, y, thumb);
-    drawTime(p, QRect{x, y, thumb.width(), thumb.height()}, thumbnail_dispaly_time);
+    QRect thumb_rect{x, y, thumb.width(), thumb.height()};
+
+    p.drawImage(x, y, thumb);
+    p.setPen(QPen(palette().color(QPalette::BrightText), 2));
+    p.drawRect(thumb_rect);
+    if (auto alert = getReplay()->findAlertAtTime(can->toSeconds(it.key()))) {
+      p.setFont(QFont(font().family(), 10));
+      drawAlert(p, thumb_rect, *alert);
+    }
+    drawTime(p, thumb_rect, thumbnail_dispaly_time);
   }
 }
 
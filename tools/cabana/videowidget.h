@@ -5,7 +5,10 @@
 #include <string>
 #include <utility>
 
+#include <QCache>
 #include <QFrame>
+#include <QFutureSynchronizer>
+#include <QImage>
 #include <QPropertyAnimation>
 #include <QSlider>
 #include <QToolBar>
@@ -35,20 +38,27 @@ class StreamCameraView : public CameraWidget {
 
 public:
   StreamCameraView(std::string stream_name, VisionStreamType stream_type, QWidget *parent = nullptr);
+  ~StreamCameraView();
   void paintGL() override;
   void showPausedOverlay() { fade_animation->start(); }
-  void parseQLog(std::shared_ptr<LogReader> qlog);
+  void parseQLog(int segment, std::shared_ptr<LogReader> qlog);
+  void loadThumbnailCache();
 
 private:
-  QPixmap generateThumbnail(QPixmap thumbnail, double seconds);
+  void addThumbnails(const QMap<uint64_t, QImage> &small, const QMap<uint64_t, QImage> &big);
   void drawAlert(QPainter &p, const QRect &rect, const Timeline::Entry &alert);
   void drawThumbnail(QPainter &p);
   void drawScrubThumbnail(QPainter &p);
   void drawTime(QPainter &p, const QRect &rect, double seconds);
 
   QPropertyAnimation *fade_animation;
-  QMap<uint64_t, QPixmap> big_thumbnails;
-  QMap<uint64_t, QPixmap> thumbnails;
+  // decoded and scaled on the thread pool, thumbnails are cached on disk per segment
+  QFutureSynchronizer<void> thumbnail_futures;
+  QMap<uint64_t, QImage> big_thumbnails;
+  QMap<uint64_t, QImage> thumbnails;
+  // big thumbnails scaled to scaled_size for scrubbing
+  QCache<uint64_t, QImage> scaled_thumbnails{32};
+  QSize scaled_size;
   double thumbnail_dispaly_time = -1;
   friend class VideoWidget;
 };
@@ -1,13 +1,10 @@
 #include "tools/replay/replay.h"
 
 #include <capnp/dynamic.h>
-#include <csignal>
 #include "cereal/services.h"
 #include "common/params.h"
 #include "tools/replay/util.h"
 
-static void interrupt_sleep_handler(int signal) {}
-
 // Helper function to notify events with safety checks
 template <typename Callback, typename... Args>
 void notifyEvent(Callback &callback, Args &&...args) {
@@ -17,8 +14,6 @@ void notifyEvent(Callback &callback, Args &&...args) {
 Replay::Replay(const std::string &route, std::vector<std::string> allow, std::vector<std::string> block,
                SubMaster *sm, uint32_t flags, const std::string &data_dir, bool auto_source)
     : sm_(sm), flags_(flags), seg_mgr_(std::make_unique<SegmentManager>(route, flags, data_dir, auto_source)) {
-  std::signal(SIGUSR1, interrupt_sleep_handler);
-
   if (!(flags_ & REPLAY_FLAG_ALL_SERVICES)) {
     block.insert(block.end(), {"uiDebug", "userBookmark"});
   }
@@ -82,11 +77,10 @@ bool Replay::load() {
 }
 
 void Replay::interruptStream(const std::function<bool()> &update_fn) {
-  if (stream_thread_.joinable() && stream_thread_id) {
-    pthread_kill(stream_thread_id, SIGUSR1);  // Interrupt sleep in stream thread
-  }
+  // set the flag first, the stream thread checks it after reset() drops pending interrupts
+  interrupt_requested_ = true;
+  clock_.interrupt();  // Interrupt sleep in stream thread
   {
-    interrupt_requested_ = true;
     std::unique_lock lock(stream_lock_);
     events_ready_ = update_fn();
     interrupt_requested_ = user_paused_;
@@ -206,8 +200,12 @@ void Replay::startStream(const std::shared_ptr<Segment> segment) {
     camera_server_ = std::make_unique<CameraServer>(camera_size);
   }
 
-  timeline_.initialize(seg_mgr_->route_, route_start_ts_, !(flags_ & REPLAY_FLAG_NO_FILE_CACHE),
-                       [this](std::shared_ptr<LogReader> log) { notifyEvent(onQLogLoaded, log); });
+  // without a qlog listener a cached timeline doesn't need the qlogs at all
+  std::function<void(int, std::shared_ptr<LogReader>)> qlog_callback;
+  if (onQLogLoaded) {
+    qlog_callback = [this](int segment, std::shared_ptr<LogReader> log) { notifyEvent(onQLogLoaded, segment, log); };
+  }
+  timeline_.initialize(seg_mgr_->route_, route_start_ts_, !(flags_ & REPLAY_FLAG_NO_FILE_CACHE), qlog_callback);
 
   stream_thread_ = std::thread(&Replay::streamThread, this);
 }
@@ -250,7 +248,6 @@ void Replay::publishFrame(const Event *e) {
 }
 
 void Replay::streamThread() {
-  stream_thread_id = pthread_self();
   std::unique_lock lk(stream_lock_);
 
   while (true) {
@@ -287,9 +284,7 @@ void Replay::streamThread() {
 
 std::vector<Event>::const_iterator Replay::publishEvents(std::vector<Event>::const_iterator first,
                                                          std::vector<Event>::const_iterator last) {
-  uint64_t evt_start_ts = cur_mono_time_;
-  uint64_t loop_start_ts = nanos_since_boot();
-  double prev_replay_speed = speed_;
+  clock_.reset(cur_mono_time_, speed_);
 
   for (; !interrupt_requested_ && first != last; ++first) {
     const Event &evt = *first;
@@ -306,21 +301,7 @@ std::vector<Event>::const_iterator Replay::publishEvents(std::vector<Event>::con
     // Skip events if socket is not present
     if (!sockets_[evt.which]) continue;
 
-    const uint64_t current_nanos = nanos_since_boot();
-    const int64_t time_diff = (evt.mono_time - evt_start_ts) / speed_ - (current_nanos - loop_start_ts);
-
-    // Reset timestamps for potential synchronization issues:
-    // - A negative time_diff may indicate slow execution or system wake-up,
-    // - A time_diff exceeding 1 second suggests a skipped segment.
-    if ((time_diff < -1e9 || time_diff >= 1e9) || speed_ != prev_replay_speed) {
-      evt_start_ts = evt.mono_time;
-      loop_start_ts = current_nanos;
-      prev_replay_speed = speed_;
-    } else if (time_diff > 0) {
-      precise_nano_sleep(time_diff, interrupt_requested_);
-    }
-
-    if (interrupt_requested_) break;
+    if (!clock_.waitUntil(evt.mono_time, speed_) || interrupt_requested_) break;
 
     if (evt.eidx_segnum == -1) {
       publishMessage(&evt);
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "tools/replay/camera.h"
+#include "tools/replay/replay_clock.h"
 #include "tools/replay/seg_mgr.h"
 #include "tools/replay/timeline.h"
 
@@ -52,6 +53,7 @@ public:
   inline double maxSeconds() const { return max_seconds_; }
   inline void setSpeed(float speed) { speed_ = speed; }
   inline float getSpeed() const { return speed_; }
+  inline ReplayClock::Stats clockStats() { return clock_.stats(); }
   inline const std::string &carFingerprint() const { return car_fingerprint_; }
   inline const std::shared_ptr<std::vector<Timeline::Entry>> getTimeline() const { return timeline_.getEntries(); }
   inline const std::optional<Timeline::Entry> findAlertAtTime(double sec) const { return timeline_.findAlertAtTime(sec); }
@@ -62,7 +64,7 @@ public:
   std::function<void()> onSegmentsMerged = nullptr;
   std::function<void(double)> onSeeking = nullptr;
   std::function<void(double)> onSeekedTo = nullptr;
-  std::function<void(std::shared_ptr<LogReader>)> onQLogLoaded = nullptr;
+  std::function<void(int, std::shared_ptr<LogReader>)> onQLogLoaded = nullptr;
 
 private:
   void setupServices(const std::vector<std::string> &allow, const std::vector<std::string> &block);
@@ -80,7 +82,7 @@ private:
   std::unique_ptr<SegmentManager> seg_mgr_;
   Timeline timeline_;
 
-  pthread_t stream_thread_id = 0;
+  ReplayClock clock_;
   std::thread stream_thread_;
   std::mutex stream_lock_;
   bool user_paused_ = false;
@@ -0,0 +1,141 @@
+#include "tools/replay/replay_clock.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <iterator>
+
+#ifdef __APPLE__
+#include <chrono>
+#else
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+#include "common/timing.h"
+
+ReplayClock::ReplayClock(uint64_t quantum_ns) : quantum_ns_(quantum_ns) {
+#ifndef __APPLE__
+  timer_fd_ = timerfd_create(CLOCK_BOOTTIME, TFD_CLOEXEC);
+  event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  assert(timer_fd_ >= 0 && event_fd_ >= 0);
+#endif
+}
+
+ReplayClock::~ReplayClock() {
+#ifndef __APPLE__
+  close(timer_fd_);
+  close(event_fd_);
+#endif
+}
+
+void ReplayClock::reset(uint64_t log_ts, float speed) {
+  restart(log_ts, speed);
+#ifdef __APPLE__
+  std::lock_guard lk(lock_);
+  interrupted_ = false;
+#else
+  uint64_t count;
+  while (read(event_fd_, &count, sizeof(count)) == sizeof(count)) {}
+#endif
+}
+
+void ReplayClock::restart(uint64_t log_ts, float speed) {
+  log_start_ts_ = log_ts;
+  wall_start_ts_ = nanos_since_boot();
+  awake_until_ = 0;
+  speed_ = speed;
+}
+
+bool ReplayClock::waitUntil(uint64_t log_ts, float speed) {
+  events_.fetch_add(1, std::memory_order_relaxed);
+  if (speed != speed_) {
+    // keeps a pending interrupt, it was meant for this run
+    restart(log_ts, speed);
+    return true;
+  }
+
+  const uint64_t deadline = wall_start_ts_ + (int64_t)(log_ts - log_start_ts_) / speed_;
+  if (deadline <= awake_until_) {
+    return true;  // due with the previous wakeup
+  }
+
+  uint64_t now = nanos_since_boot();
+  const int64_t time_diff = deadline - now;
+  // Restart pacing from this event:
+  // - A negative time_diff may indicate slow execution or system wake-up,
+  // - A time_diff exceeding 1 second suggests a skipped segment.
+  if (time_diff < -1e9 || time_diff >= 1e9) {
+    log_start_ts_ = log_ts;
+    wall_start_ts_ = now;
+    awake_until_ = now + quantum_ns_;
+    return true;
+  }
+
+  if (time_diff > (int64_t)quantum_ns_) {
+    if (!sleepUntil(deadline)) return false;
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    now = nanos_since_boot();
+  }
+  addLag(now - deadline);
+  awake_until_ = std::max(now, deadline) + quantum_ns_;
+  return true;
+}
+
+void ReplayClock::interrupt() {
+#ifdef __APPLE__
+  {
+    std::lock_guard lk(lock_);
+    interrupted_ = true;
+  }
+  cv_.notify_all();
+#else
+  uint64_t one = 1;
+  [[maybe_unused]] ssize_t ret = write(event_fd_, &one, sizeof(one));
+#endif
+}
+
+bool ReplayClock::sleepUntil(uint64_t deadline) {
+#ifdef __APPLE__
+  auto wake_time = std::chrono::steady_clock::now() + std::chrono::nanoseconds(deadline - nanos_since_boot());
+  std::unique_lock lk(lock_);
+  return !cv_.wait_until(lk, wake_time, [this]() { return interrupted_; });
+#else
+  struct itimerspec its = {};
+  its.it_value.tv_sec = deadline / 1000000000;
+  its.it_value.tv_nsec = deadline % 1000000000;
+  timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &its, nullptr);
+
+  // the interrupt stays signaled until the next reset, so following waits return right away too
+  struct pollfd fds[] = {{.fd = timer_fd_, .events = POLLIN}, {.fd = event_fd_, .events = POLLIN}};
+  while (true) {
+    int ret = poll(fds, std::size(fds), -1);
+    if (ret < 0 && errno == EINTR) continue;
+    if (ret < 0 || (fds[1].revents & POLLIN)) return false;
+    if (fds[0].revents & POLLIN) {
+      uint64_t expirations;
+      [[maybe_unused]] ssize_t n = read(timer_fd_, &expirations, sizeof(expirations));
+      return true;
+    }
+  }
+#endif
+}
+
+void ReplayClock::addLag(int64_t lag_ns) {
+  lag_ns = std::max<int64_t>(lag_ns, 0);
+  avg_lag_ns_.store(avg_lag_ns_.load(std::memory_order_relaxed) * 0.99 + lag_ns * 0.01, std::memory_order_relaxed);
+  if (lag_ns > max_lag_ns_.load(std::memory_order_relaxed)) {
+    max_lag_ns_.store(lag_ns, std::memory_order_relaxed);
+  }
+}
+
+ReplayClock::Stats ReplayClock::stats() {
+  return {
+    .events = events_.load(std::memory_order_relaxed),
+    .wakeups = wakeups_.load(std::memory_order_relaxed),
+    .avg_lag_ms = avg_lag_ns_.load(std::memory_order_relaxed) / 1e6,
+    .max_lag_ms = max_lag_ns_.exchange(0, std::memory_order_relaxed) / 1e6,
+  };
+}
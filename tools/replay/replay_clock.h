@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef __APPLE__
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// Paces replay against the boot clock. Events due within one quantum of the last wakeup are
+// published with it instead of sleeping again, sleeps go to absolute deadlines so wakeup latency
+// doesn't accumulate, and interrupt() wakes a sleep from any thread without a signal.
+class ReplayClock {
+public:
+  struct Stats {
+    uint64_t events;
+    uint64_t wakeups;
+    double avg_lag_ms;  // moving average of how late events were due when they were published
+    double max_lag_ms;  // since the previous call to stats()
+  };
+
+  explicit ReplayClock(uint64_t quantum_ns = DEFAULT_QUANTUM_NS);
+  ~ReplayClock();
+
+  // starts pacing at log time log_ts from now, and drops interrupts from before. An interrupt()
+  // racing with it can be dropped too, so callers set their own stop flag before interrupt() and
+  // check it after reset()
+  void reset(uint64_t log_ts, float speed);
+  // waits until log_ts is due, returns false if interrupted
+  bool waitUntil(uint64_t log_ts, float speed);
+  void interrupt();
+  Stats stats();
+
+  static constexpr uint64_t DEFAULT_QUANTUM_NS = 1000000;
+
+private:
+  void restart(uint64_t log_ts, float speed);
+  bool sleepUntil(uint64_t deadline);
+  void addLag(int64_t lag_ns);
+
+  const uint64_t quantum_ns_;
+  uint64_t log_start_ts_ = 0;
+  uint64_t wall_start_ts_ = 0;
+  uint64_t awake_until_ = 0;
+  float speed_ = 1.0;
+
+#ifdef __APPLE__
+  std::mutex lock_;
+  std::condition_variable cv_;
+  bool interrupted_ = false;
+#else
+  int timer_fd_ = -1;
+  int event_fd_ = -1;
+#endif
+
+  std::atomic<uint64_t> events_ = 0;
+  std::atomic<uint64_t> wakeups_ = 0;
+  std::atomic<double> avg_lag_ns_ = 0;
+  std::atomic<int64_t> max_lag_ns_ = 0;
+};
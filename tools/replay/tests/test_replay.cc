@@ -1,5 +1,9 @@
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch.hpp"
+#include <random>
+
+#include <unistd.h>
+
 #include "tools/replay/replay.h"
 
 const std::string TEST_RLOG_URL = "https://commadataci.blob.core.windows.net/openpilotci/0c94aa1e1296d7c6/2021-05-05--19-48-37/0/rlog.bz2";
@@ -15,3 +19,266 @@ TEST_CASE("LogReader") {
     REQUIRE(log.events.size() > 0);
   }
 }
+
+// a random drive with engagements, bookmarks and alerts of each status, the event data is kept in buffers
+static std::vector<Event> random_drive(std::mt19937 &gen, int count, std::vector<kj::Array<capnp::word>> &buffers) {
+  const char *alerts[] = {nullptr, "a", "b"};
+  std::vector<Event> events;
+  bool enabled = false;
+  const char *alert = nullptr;
+  std::string text2;
+  auto status = cereal::SelfdriveState::AlertStatus::NORMAL;
+  for (int i = 0; i < count; ++i) {
+    if (gen() % 20 == 0) enabled = !enabled;
+    if (gen() % 15 == 0) {
+      alert = alerts[gen() % 3];
+      status = (cereal::SelfdriveState::AlertStatus)(gen() % 3);
+      text2 = std::string(gen() % 2, 'x');
+    }
+
+    const uint64_t mono_time = 1000 + i * 10'000'000ULL;
+    MessageBuilder msg;
+    auto evt = msg.initEvent();
+    evt.setLogMonoTime(mono_time);
+    if (gen() % 50 == 0) {
+      evt.initUserBookmark();
+    } else {
+      auto cs = evt.initSelfdriveState();
+      cs.setEnabled(enabled);
+      if (alert) {
+        cs.setAlertSize(cereal::SelfdriveState::AlertSize::SMALL);
+        cs.setAlertStatus(status);
+        cs.setAlertText1(alert);
+        cs.setAlertText2(text2);
+      }
+    }
+    buffers.push_back(capnp::messageToFlatArray(msg));
+    events.emplace_back(evt.which(), mono_time, buffers.back().asPtr());
+  }
+  return events;
+}
+
+TEST_CASE("Timeline") {
+  // a random drive, split into segments anywhere has to give the same timeline as the whole drive
+  std::mt19937 gen(GENERATE(1, 2, 3, 4, 5));
+  std::vector<kj::Array<capnp::word>> buffers;
+  const std::vector<Event> events = random_drive(gen, 500, buffers);
+
+  std::vector<Timeline::Entry> expected;
+  std::optional<size_t> engaged_idx, alert_idx;
+  Timeline::appendSegment(expected, engaged_idx, alert_idx, Timeline::parseEvents(events, 1000));
+
+  std::vector<Timeline::Entry> entries;
+  engaged_idx = alert_idx = std::nullopt;
+  for (size_t begin = 0; begin < events.size();) {
+    size_t end = std::min(events.size(), begin + gen() % 60);
+    std::vector<Event> segment(events.begin() + begin, events.begin() + end);
+    Timeline::appendSegment(entries, engaged_idx, alert_idx, Timeline::parseEvents(segment, 1000));
+    begin = end;
+  }
+
+  REQUIRE(entries.size() == expected.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    REQUIRE(entries[i].start_time == expected[i].start_time);
+    REQUIRE(entries[i].end_time == expected[i].end_time);
+    REQUIRE(entries[i].type == expected[i].type);
+    REQUIRE(entries[i].text1 == expected[i].text1);
+    REQUIRE(entries[i].text2 == expected[i].text2);
+  }
+}
+
+static std::vector<Timeline::Entry> random_timeline(std::mt19937 &gen) {
+  std::vector<kj::Array<capnp::word>> buffers;
+  std::vector<Timeline::Entry> entries;
+  std::optional<size_t> engaged_idx, alert_idx;
+  Timeline::appendSegment(entries, engaged_idx, alert_idx, Timeline::parseEvents(random_drive(gen, 2000, buffers), 1000));
+  return entries;
+}
+
+static void require_equal(const std::vector<Timeline::Entry> &entries, const std::vector<Timeline::Entry> &expected, double offset = 0) {
+  REQUIRE(entries.size() == expected.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    REQUIRE(entries[i].start_time == expected[i].start_time + offset);
+    REQUIRE(entries[i].end_time == expected[i].end_time + offset);
+    REQUIRE(entries[i].type == expected[i].type);
+    REQUIRE(entries[i].text1 == expected[i].text1);
+    REQUIRE(entries[i].text2 == expected[i].text2);
+  }
+}
+
+TEST_CASE("Timeline cache") {
+  std::mt19937 gen(1);
+  const auto expected = random_timeline(gen);
+  REQUIRE(expected.size() > 0);
+
+  char cache_file[] = "/tmp/timeline_cache_XXXXXX";
+  close(mkstemp(cache_file));
+  const uint64_t route_start_ts = 5e9;
+  Timeline().saveCache(cache_file, route_start_ts, expected);
+  const std::string data = util::read_file(cache_file);
+
+  SECTION("round trip") {
+    Timeline timeline;
+    REQUIRE(timeline.loadCache(cache_file, route_start_ts));
+    require_equal(*timeline.getEntries(), expected);
+  }
+  SECTION("times move with the start of the route") {
+    Timeline timeline;
+    REQUIRE(timeline.loadCache(cache_file, route_start_ts - 2e9));
+    require_equal(*timeline.getEntries(), expected, 2.0);
+  }
+  SECTION("a missing file is rejected") {
+    Timeline timeline;
+    REQUIRE_FALSE(timeline.loadCache(std::string(cache_file) + ".missing", route_start_ts));
+    REQUIRE(timeline.getEntries()->empty());
+  }
+  SECTION("a truncated file is rejected") {
+    for (size_t size = 0; size < data.size(); size += 1 + size / 16) {
+      INFO("size " << size);
+      util::write_file(cache_file, data.data(), size, O_WRONLY | O_CREAT | O_TRUNC);
+      Timeline timeline;
+      REQUIRE_FALSE(timeline.loadCache(cache_file, route_start_ts));
+      REQUIRE(timeline.getEntries()->empty());
+    }
+  }
+  SECTION("a corrupt file is rejected") {
+    // version, start ts and count, then the first entry's times and type
+    auto corrupt = [&](size_t offset, uint32_t value) {
+      std::string bad = data;
+      memcpy(bad.data() + offset, &value, sizeof(value));
+      util::write_file(cache_file, bad.data(), bad.size(), O_WRONLY | O_CREAT | O_TRUNC);
+      Timeline timeline;
+      bool loaded = timeline.loadCache(cache_file, route_start_ts);
+      REQUIRE(timeline.getEntries()->empty() == !loaded);
+      return loaded;
+    };
+    REQUIRE_FALSE(corrupt(0, 0));                 // version
+    REQUIRE_FALSE(corrupt(12, UINT32_MAX));       // count
+    REQUIRE_FALSE(corrupt(12, expected.size() + 1));
+    REQUIRE_FALSE(corrupt(32, 99));               // type
+    REQUIRE_FALSE(corrupt(36, UINT32_MAX));       // length of text1
+  }
+  unlink(cache_file);
+}
+
+TEST_CASE("Timeline lookups") {
+  std::mt19937 gen(GENERATE(1, 2, 3));
+  const auto entries = random_timeline(gen);
+
+  char cache_file[] = "/tmp/timeline_cache_XXXXXX";
+  close(mkstemp(cache_file));
+  Timeline timeline;
+  timeline.saveCache(cache_file, 1000, entries);
+  REQUIRE(timeline.loadCache(cache_file, 1000));
+  unlink(cache_file);
+
+  // the linear searches the binary searches replaced
+  auto linear_find = [&](double cur_ts, FindFlag flag) -> std::optional<uint64_t> {
+    for (const auto &entry : entries) {
+      if (entry.type == TimelineType::Engaged) {
+        if (flag == FindFlag::nextEngagement && entry.start_time > cur_ts) {
+          return entry.start_time;
+        } else if (flag == FindFlag::nextDisEngagement && entry.end_time > cur_ts) {
+          return entry.end_time;
+        }
+      } else if (entry.start_time > cur_ts) {
+        if ((flag == FindFlag::nextUserBookmark && entry.type == TimelineType::UserBookmark) ||
+            (flag == FindFlag::nextInfo && entry.type == TimelineType::AlertInfo) ||
+            (flag == FindFlag::nextWarning && entry.type == TimelineType::AlertWarning) ||
+            (flag == FindFlag::nextCritical && entry.type == TimelineType::AlertCritical)) {
+          return entry.start_time;
+        }
+      }
+    }
+    return std::nullopt;
+  };
+  auto linear_alert = [&](double target_time) -> std::optional<Timeline::Entry> {
+    for (const auto &entry : entries) {
+      if (entry.start_time > target_time) break;
+      if (entry.end_time >= target_time && entry.type >= TimelineType::AlertInfo && entry.type <= TimelineType::AlertCritical) {
+        return entry;
+      }
+    }
+    return std::nullopt;
+  };
+
+  // the entries' own times hit the boundaries, the random ones fall in between
+  std::vector<double> times = {-1.0, 1e6};
+  for (const auto &entry : entries) {
+    times.insert(times.end(), {entry.start_time, entry.end_time});
+  }
+  std::uniform_real_distribution<double> dist(-1.0, entries.back().end_time + 1.0);
+  for (int i = 0; i < 1000; ++i) {
+    times.push_back(dist(gen));
+  }
+
+  const FindFlag flags[] = {FindFlag::nextEngagement, FindFlag::nextDisEngagement, FindFlag::nextUserBookmark,
+                            FindFlag::nextInfo, FindFlag::nextWarning, FindFlag::nextCritical};
+  for (double t : times) {
+    INFO("time " << t);
+    for (auto flag : flags) {
+      REQUIRE(timeline.find(t, flag) == linear_find(t, flag));
+    }
+    auto alert = timeline.findAlertAtTime(t);
+    auto expected = linear_alert(t);
+    REQUIRE(alert.has_value() == expected.has_value());
+    if (alert) {
+      REQUIRE(alert->start_time == expected->start_time);
+      REQUIRE(alert->text1 == expected->text1);
+    }
+  }
+}
+
+TEST_CASE("ReplayClock") {
+  const uint64_t start_ts = 1000 * 1e9;
+  ReplayClock clock;
+
+  SECTION("events within a quantum share a wakeup") {
+    clock.reset(start_ts, 1.0);
+    const uint64_t begin = nanos_since_boot();
+    for (int i = 1; i <= 100; ++i) {
+      // ten events 0.05ms apart every 10ms
+      REQUIRE(clock.waitUntil(start_ts + (i / 10) * 10e6 + (i % 10) * 0.05e6, 1.0));
+    }
+    const double elapsed_ms = (nanos_since_boot() - begin) / 1e6;
+    REQUIRE(elapsed_ms >= 99);
+    REQUIRE(elapsed_ms < 150);
+    auto stats = clock.stats();
+    REQUIRE(stats.events == 100);
+    REQUIRE(stats.wakeups <= 10);
+  }
+
+  SECTION("speed scales the pacing") {
+    clock.reset(start_ts, 10.0);
+    const uint64_t begin = nanos_since_boot();
+    REQUIRE(clock.waitUntil(start_ts + 500e6, 10.0));
+    const double elapsed_ms = (nanos_since_boot() - begin) / 1e6;
+    REQUIRE(elapsed_ms >= 49);
+    REQUIRE(elapsed_ms < 100);
+  }
+
+  SECTION("interrupt wakes a sleep until the next reset") {
+    clock.reset(start_ts, 1.0);
+    std::thread t([&]() {
+      util::sleep_for(20);
+      clock.interrupt();
+    });
+    const uint64_t begin = nanos_since_boot();
+    REQUIRE_FALSE(clock.waitUntil(start_ts + 900e6, 1.0));
+    REQUIRE((nanos_since_boot() - begin) / 1e6 < 500);
+    REQUIRE_FALSE(clock.waitUntil(start_ts + 900e6, 1.0));
+    t.join();
+
+    clock.reset(start_ts, 1.0);
+    REQUIRE(clock.waitUntil(start_ts + 5e6, 1.0));
+  }
+
+  SECTION("a speed change keeps a pending interrupt") {
+    clock.reset(start_ts, 1.0);
+    clock.interrupt();
+    REQUIRE(clock.waitUntil(start_ts, 2.0));
+    const uint64_t begin = nanos_since_boot();
+    REQUIRE_FALSE(clock.waitUntil(start_ts + 900e6, 2.0));
+    REQUIRE((nanos_since_boot() - begin) / 1e6 < 100);
+  }
+}
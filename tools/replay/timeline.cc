@@ -1,9 +1,19 @@
 #include "tools/replay/timeline.h"
 
 #include <algorithm>
-#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
 
 #include "cereal/gen/cpp/log.capnp.h"
+#include "common/util.h"
+#include "tools/replay/filereader.h"
+
+// qlogs are small, more threads would mostly add concurrent downloads
+const int MAX_TIMELINE_THREADS = 8;
+const uint32_t TIMELINE_CACHE_VERSION = 1;
 
 Timeline::~Timeline() {
   should_exit_.store(true);
@@ -13,97 +23,295 @@ Timeline::~Timeline() {
 }
 
 void Timeline::initialize(const Route &route, uint64_t route_start_ts, bool local_cache,
-                          std::function<void(std::shared_ptr<LogReader>)> callback) {
+                          std::function<void(int, std::shared_ptr<LogReader>)> callback) {
   thread_ = std::thread(&Timeline::buildTimeline, this, route, route_start_ts, local_cache, callback);
 }
 
 std::optional<uint64_t> Timeline::find(double cur_ts, FindFlag flag) const {
-  for (const auto &entry : *getEntries()) {
-    if (entry.type == TimelineType::Engaged) {
-      if (flag == FindFlag::nextEngagement && entry.start_time > cur_ts) {
-        return entry.start_time;
-      } else if (flag == FindFlag::nextDisEngagement && entry.end_time > cur_ts) {
-        return entry.end_time;
-      }
-    } else if (entry.start_time > cur_ts) {
-      if ((flag == FindFlag::nextUserBookmark && entry.type == TimelineType::UserBookmark) ||
-          (flag == FindFlag::nextInfo && entry.type == TimelineType::AlertInfo) ||
-          (flag == FindFlag::nextWarning && entry.type == TimelineType::AlertWarning) ||
-          (flag == FindFlag::nextCritical && entry.type == TimelineType::AlertCritical)) {
-        return entry.start_time;
-      }
-    }
+  auto snapshot = std::atomic_load(&snapshot_);
+  const auto &entries = *snapshot->entries;
+  // first entry of the type starting (or ending) after cur_ts, the entries of one type don't overlap
+  auto next = [&](TimelineType type, bool end) -> std::optional<uint64_t> {
+    const auto &idx = snapshot->by_type[(int)type];
+    auto it = std::upper_bound(idx.begin(), idx.end(), cur_ts, [&](double t, uint32_t i) {
+      return t < (end ? entries[i].end_time : entries[i].start_time);
+    });
+    if (it == idx.end()) return std::nullopt;
+    return end ? entries[*it].end_time : entries[*it].start_time;
+  };
+
+  switch (flag) {
+    case FindFlag::nextEngagement: return next(TimelineType::Engaged, false);
+    case FindFlag::nextDisEngagement: return next(TimelineType::Engaged, true);
+    case FindFlag::nextUserBookmark: return next(TimelineType::UserBookmark, false);
+    case FindFlag::nextInfo: return next(TimelineType::AlertInfo, false);
+    case FindFlag::nextWarning: return next(TimelineType::AlertWarning, false);
+    case FindFlag::nextCritical: return next(TimelineType::AlertCritical, false);
   }
   return std::nullopt;
 }
 
 std::optional<Timeline::Entry> Timeline::findAlertAtTime(double target_time) const {
-  for (const auto &entry : *getEntries()) {
-    if (entry.start_time > target_time) break;
-    if (entry.end_time >= target_time && entry.type >= TimelineType::AlertInfo) {
-      return entry;
-    }
+  auto snapshot = std::atomic_load(&snapshot_);
+  const auto &entries = *snapshot->entries;
+  // alerts follow each other without overlapping, so their end times are sorted too
+  const auto &alerts = snapshot->alerts;
+  auto it = std::lower_bound(alerts.begin(), alerts.end(), target_time, [&](uint32_t i, double t) {
+    return entries[i].end_time < t;
+  });
+  if (it != alerts.end() && entries[*it].start_time <= target_time) {
+    return entries[*it];
   }
   return std::nullopt;
 }
 
 void Timeline::buildTimeline(const Route &route, uint64_t route_start_ts, bool local_cache,
-                             std::function<void(std::shared_ptr<LogReader>)> callback) {
-  std::optional<size_t> current_engaged_idx, current_alert_idx;
+                             std::function<void(int, std::shared_ptr<LogReader>)> callback) {
+  const std::vector<std::pair<int, SegmentFile>> segments(route.segments().begin(), route.segments().end());
+  std::string cache_file;
+  if (local_cache) {
+    std::string key = "timeline|" + route.name();
+    for (const auto &[n, files] : segments) {
+      key += "|" + std::to_string(n) + ":" + getUrlWithoutQuery(files.qlog);
+    }
+    cache_file = cacheFilePath(key);
+  }
+
+  const bool cached = !cache_file.empty() && loadCache(cache_file, route_start_ts);
+  if (cached && !callback) return;
+
+  std::vector<bool> filters(capnp::Schema::from<cereal::Event>().asStruct().getUnionFields().size(), false);
+  for (auto which : {cereal::Event::Which::SELFDRIVE_STATE, cereal::Event::Which::CONTROLS_STATE,
+                     cereal::Event::Which::USER_BOOKMARK, cereal::Event::Which::THUMBNAIL}) {
+    filters[which] = true;
+  }
+
+  // segments finish out of order, they are appended to the timeline in order as soon as they can be
+  std::mutex lock;
+  std::vector<std::optional<SegmentEntries>> results(segments.size());
+  size_t merged = 0;
+  bool complete = true;
+  std::vector<Entry> entries;
+  std::optional<size_t> engaged_idx, alert_idx;
 
-  for (const auto &segment : route.segments()) {
-    if (should_exit_) break;
+  std::atomic<size_t> next = 0;
+  auto worker = [&]() {
+    for (size_t i; (i = next++) < segments.size() && !should_exit_;) {
+      auto log = std::make_shared<LogReader>(filters);
+      bool success = log->load(segments[i].second.qlog, &should_exit_, local_cache, 0, 3) && !log->events.empty();
+      if (should_exit_) break;
 
-    auto log = std::make_shared<LogReader>();
-    if (!log->load(segment.second.qlog, &should_exit_, local_cache, 0, 3) || log->events.empty()) {
-      continue;  // Skip if log loading fails or no events
+      if (!cached) {
+        auto seg = success ? parseEvents(log->events, route_start_ts) : SegmentEntries{};
+        std::lock_guard lk(lock);
+        complete &= success;
+        results[i] = std::move(seg);
+        size_t last_merged = merged;
+        for (; merged < results.size() && results[merged]; ++merged) {
+          appendSegment(entries, engaged_idx, alert_idx, std::move(*results[merged]));
+        }
+        if (merged != last_merged) {
+          publish(entries);
+        }
+      }
+      if (success && callback) {
+        callback(segments[i].first, log);  // Notify the callback once the log is processed
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const size_t num_threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, MAX_TIMELINE_THREADS);
+  for (size_t i = 0; i < std::min(num_threads, segments.size()); ++i) {
+    workers.emplace_back(worker);
+  }
+  for (auto &w : workers) w.join();
+
+  if (!cached && complete && !should_exit_ && !cache_file.empty()) {
+    saveCache(cache_file, route_start_ts, entries);
+  }
+}
+
+void Timeline::publish(std::vector<Entry> entries) {
+  auto snapshot = std::make_shared<Snapshot>();
+  for (uint32_t i = 0; i < entries.size(); ++i) {
+    snapshot->by_type[(int)entries[i].type].push_back(i);
+    if (entries[i].type >= TimelineType::AlertInfo && entries[i].type <= TimelineType::AlertCritical) {
+      snapshot->alerts.push_back(i);
     }
+  }
+  snapshot->entries = std::make_shared<std::vector<Entry>>(std::move(entries));
+  std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
 
-    for (const Event &e : log->events) {
-      double seconds = (e.mono_time - route_start_ts) / 1e9;
-      if (e.which == cereal::Event::Which::SELFDRIVE_STATE) {
-        capnp::FlatArrayMessageReader reader(e.data);
-        auto cs = reader.getRoot<cereal::Event>().getSelfdriveState();
-        updateEngagementStatus(cs, current_engaged_idx, seconds);
-        updateAlertStatus(cs, current_alert_idx, seconds);
-      } else if (e.which == cereal::Event::Which::USER_BOOKMARK) {
-        staging_entries_.emplace_back(Entry{seconds, seconds, TimelineType::UserBookmark});
+Timeline::SegmentEntries Timeline::parseEvents(const std::vector<Event> &events, uint64_t route_start_ts) {
+  SegmentEntries seg;
+  for (const Event &e : events) {
+    double seconds = (e.mono_time - route_start_ts) / 1e9;
+    if (e.which == cereal::Event::Which::SELFDRIVE_STATE) {
+      capnp::FlatArrayMessageReader reader(e.data);
+      auto cs = reader.getRoot<cereal::Event>().getSelfdriveState();
+      updateEngagementStatus(seg.entries, cs, seg.engaged_idx, seconds);
+      updateAlertStatus(seg.entries, cs, seg.alert_idx, seconds);
+      if (!seg.first_update) {
+        seg.first_update = seconds;
+        seg.first_engaged = seg.engaged_idx;
+        seg.first_alert = seg.alert_idx;
       }
+    } else if (e.which == cereal::Event::Which::USER_BOOKMARK) {
+      seg.entries.emplace_back(Entry{seconds, seconds, TimelineType::UserBookmark});
     }
+  }
+  return seg;
+}
+
+void Timeline::appendSegment(std::vector<Entry> &entries, std::optional<size_t> &engaged_idx,
+                             std::optional<size_t> &alert_idx, SegmentEntries &&seg) {
+  if (!seg.first_update) {
+    // nothing to close or continue, the open entries stay open
+    std::move(seg.entries.begin(), seg.entries.end(), std::back_inserter(entries));
+    return;
+  }
+
+  // the first selfdriveState of the segment ends the open entries or continues them
+  std::optional<size_t> join_engaged, join_alert;
+  if (engaged_idx) {
+    entries[*engaged_idx].end_time = *seg.first_update;
+    join_engaged = seg.first_engaged;
+  }
+  if (alert_idx) {
+    Entry &open = entries[*alert_idx];
+    open.end_time = *seg.first_update;
+    if (seg.first_alert) {
+      const Entry &first = seg.entries[*seg.first_alert];
+      if (first.type == open.type && first.text1 == open.text1 && first.text2 == open.text2) {
+        join_alert = seg.first_alert;
+      }
+    }
+  }
+
+  std::vector<size_t> index(seg.entries.size());
+  for (size_t i = 0; i < seg.entries.size(); ++i) {
+    if (i == join_engaged) {
+      index[i] = *engaged_idx;
+    } else if (i == join_alert) {
+      index[i] = *alert_idx;
+    } else {
+      index[i] = entries.size();
+      entries.push_back(std::move(seg.entries[i]));
+      continue;
+    }
+    entries[index[i]].end_time = seg.entries[i].end_time;
+  }
+  engaged_idx = seg.engaged_idx ? std::optional(index[*seg.engaged_idx]) : std::nullopt;
+  alert_idx = seg.alert_idx ? std::optional(index[*seg.alert_idx]) : std::nullopt;
+}
 
-    // Sort and finalize the timeline entries
-    auto entries = std::make_shared<std::vector<Entry>>(staging_entries_);
-    std::sort(entries->begin(), entries->end(), [](auto &a, auto &b) { return a.start_time < b.start_time; });
-    std::atomic_store(&timeline_entries_, std::move(entries));
+bool Timeline::loadCache(const std::string &cache_file, uint64_t route_start_ts) {
+  std::string data = util::read_file(cache_file);
+  const char *p = data.data(), *end = data.data() + data.size();
+  auto read = [&](void *dst, size_t size) {
+    if (end - p < (ptrdiff_t)size) return false;
+    memcpy(dst, p, size);
+    p += size;
+    return true;
+  };
+  auto read_string = [&](std::string &s) {
+    uint32_t len = 0;
+    if (!read(&len, sizeof(len)) || end - p < (ptrdiff_t)len) return false;
+    s.assign(p, len);
+    p += len;
+    return true;
+  };
+
+  uint32_t version = 0, count = 0;
+  uint64_t cached_start_ts = 0;
+  if (!read(&version, sizeof(version)) || version != TIMELINE_CACHE_VERSION ||
+      !read(&cached_start_ts, sizeof(cached_start_ts)) || !read(&count, sizeof(count))) {
+    return false;
+  }
+
+  // a truncated or corrupt file can't hold that many entries, even with empty texts
+  const size_t min_entry_size = sizeof(Entry::start_time) + sizeof(Entry::end_time) + sizeof(int32_t) + 2 * sizeof(uint32_t);
+  if (count > (size_t)(end - p) / min_entry_size) {
+    return false;
+  }
+
+  // the entries are relative to the start of the route when it was cached
+  const double offset = (int64_t)(cached_start_ts - route_start_ts) / 1e9;
+  std::vector<Entry> entries(count);
+  for (auto &e : entries) {
+    int32_t type = 0;
+    if (!read(&e.start_time, sizeof(e.start_time)) || !read(&e.end_time, sizeof(e.end_time)) || !read(&type, sizeof(type)) ||
+        type < 0 || type > (int)TimelineType::UserBookmark || !read_string(e.text1) || !read_string(e.text2)) {
+      return false;
+    }
+    e.type = (TimelineType)type;
+    e.start_time += offset;
+    e.end_time += offset;
+  }
+  publish(std::move(entries));
+  return true;
+}
+
+void Timeline::saveCache(const std::string &cache_file, uint64_t route_start_ts, const std::vector<Entry> &entries) const {
+  std::string data;
+  auto write = [&](const void *src, size_t size) { data.append((const char *)src, size); };
+  auto write_string = [&](const std::string &s) {
+    uint32_t len = s.size();
+    write(&len, sizeof(len));
+    data += s;
+  };
+
+  uint32_t count = entries.size();
+  write(&TIMELINE_CACHE_VERSION, sizeof(TIMELINE_CACHE_VERSION));
+  write(&route_start_ts, sizeof(route_start_ts));
+  write(&count, sizeof(count));
+  for (const auto &e : entries) {
+    int32_t type = (int32_t)e.type;
+    write(&e.start_time, sizeof(e.start_time));
+    write(&e.end_time, sizeof(e.end_time));
+    write(&type, sizeof(type));
+    write_string(e.text1);
+    write_string(e.text2);
+  }
 
-    callback(log);  // Notify the callback once the log is processed
+  // readers never see a partial file
+  const std::string tmp_file = cache_file + ".tmp";
+  std::ofstream fs(tmp_file, std::ios::binary | std::ios::out);
+  fs.write(data.data(), data.size());
+  fs.close();
+  if (!fs || std::rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+    rWarning("failed to write timeline cache %s", cache_file.c_str());
   }
 }
 
-void Timeline::updateEngagementStatus(const cereal::SelfdriveState::Reader &cs, std::optional<size_t> &idx, double seconds) {
-  if (idx) staging_entries_[*idx].end_time = seconds;
+void Timeline::updateEngagementStatus(std::vector<Entry> &entries, const cereal::SelfdriveState::Reader &cs,
+                                      std::optional<size_t> &idx, double seconds) {
+  if (idx) entries[*idx].end_time = seconds;
   if (cs.getEnabled()) {
     if (!idx) {
-      idx = staging_entries_.size();
-      staging_entries_.emplace_back(Entry{seconds, seconds, TimelineType::Engaged});
+      idx = entries.size();
+      entries.emplace_back(Entry{seconds, seconds, TimelineType::Engaged});
     }
   } else {
     idx.reset();
   }
 }
 
-void Timeline::updateAlertStatus(const cereal::SelfdriveState::Reader &cs, std::optional<size_t> &idx, double seconds) {
+void Timeline::updateAlertStatus(std::vector<Entry> &entries, const cereal::SelfdriveState::Reader &cs,
+                                 std::optional<size_t> &idx, double seconds) {
   static auto alert_types = std::array{TimelineType::AlertInfo, TimelineType::AlertWarning, TimelineType::AlertCritical};
 
-  Entry *entry = idx ? &staging_entries_[*idx] : nullptr;
+  Entry *entry = idx ? &entries[*idx] : nullptr;
   if (entry) entry->end_time = seconds;
   if (cs.getAlertSize() != cereal::SelfdriveState::AlertSize::NONE) {
     auto type = alert_types[(int)cs.getAlertStatus()];
     std::string text1 = cs.getAlertText1().cStr();
     std::string text2 = cs.getAlertText2().cStr();
     if (!entry || entry->type != type || entry->text1 != text1 || entry->text2 != text2) {
-      idx = staging_entries_.size();
-      staging_entries_.emplace_back(Entry{seconds, seconds, type, text1, text2});  // Start a new entry
+      idx = entries.size();
+      entries.emplace_back(Entry{seconds, seconds, type, text1, text2});  // Start a new entry
     }
   } else {
     idx.reset();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <optional>
 #include <thread>
@@ -20,27 +21,49 @@ public:
     std::string text2;
   };
 
-  Timeline() : timeline_entries_(std::make_shared<std::vector<Entry>>()) {}
+  // Entries of one segment. The ones started by its first selfdriveState and the ones still open at
+  // its end are marked, so they can be joined with entries that continue across segment boundaries.
+  struct SegmentEntries {
+    std::vector<Entry> entries;
+    std::optional<double> first_update;
+    std::optional<size_t> first_engaged, first_alert;
+    std::optional<size_t> engaged_idx, alert_idx;
+  };
+
+  Timeline() : snapshot_(std::make_shared<Snapshot>()) {}
   ~Timeline();
 
+  // The qlogs are loaded in parallel and the callback gets the segment number and a LogReader that
+  // only holds the events the timeline uses and thumbnails. A finished timeline is cached per route when local_cache is set.
   void initialize(const Route &route, uint64_t route_start_ts, bool local_cache,
-                  std::function<void(std::shared_ptr<LogReader>)> callback);
+                  std::function<void(int, std::shared_ptr<LogReader>)> callback);
   std::optional<uint64_t> find(double cur_ts, FindFlag flag) const;
   std::optional<Entry> findAlertAtTime(double target_time) const;
-  const std::shared_ptr<std::vector<Entry>> getEntries() const { return std::atomic_load(&timeline_entries_); }
+  const std::shared_ptr<std::vector<Entry>> getEntries() const { return std::atomic_load(&snapshot_)->entries; }
+
+  static SegmentEntries parseEvents(const std::vector<Event> &events, uint64_t route_start_ts);
+  // appends the next segment, engaged_idx and alert_idx are the entries still open in entries
+  static void appendSegment(std::vector<Entry> &entries, std::optional<size_t> &engaged_idx,
+                            std::optional<size_t> &alert_idx, SegmentEntries &&seg);
+  // publishes the cached timeline, false if the file is missing, from another version or corrupt
+  bool loadCache(const std::string &cache_file, uint64_t route_start_ts);
+  void saveCache(const std::string &cache_file, uint64_t route_start_ts, const std::vector<Entry> &entries) const;
 
 private:
+  // sorted entries, with the position of each type's entries for the lookups
+  struct Snapshot {
+    std::shared_ptr<std::vector<Entry>> entries = std::make_shared<std::vector<Entry>>();
+    std::array<std::vector<uint32_t>, (int)TimelineType::UserBookmark + 1> by_type;
+    std::vector<uint32_t> alerts;
+  };
+
   void buildTimeline(const Route &route, uint64_t route_start_ts, bool local_cache,
-                     std::function<void(std::shared_ptr<LogReader>)> callback);
-  void updateEngagementStatus(const cereal::SelfdriveState::Reader &cs, std::optional<size_t> &idx, double seconds);
-  void updateAlertStatus(const cereal::SelfdriveState::Reader &cs, std::optional<size_t> &idx, double seconds);
+                     std::function<void(int, std::shared_ptr<LogReader>)> callback);
+  void publish(std::vector<Entry> entries);
+  static void updateEngagementStatus(std::vector<Entry> &entries, const cereal::SelfdriveState::Reader &cs, std::optional<size_t> &idx, double seconds);
+  static void updateAlertStatus(std::vector<Entry> &entries, const cereal::SelfdriveState::Reader &cs, std::optional<size_t> &idx, double seconds);
 
   std::thread thread_;
   std::atomic<bool> should_exit_ = false;
-
-  // Temporarily holds entries before they are sorted and finalized
-  std::vector<Entry> staging_entries_;
-
-  // Final sorted timeline entries
-  std::shared_ptr<std::vector<Entry>> timeline_entries_;
+  std::shared_ptr<const Snapshot> snapshot_;
 };
@@ -362,25 +362,6 @@ std::string decompressZST(const std::byte *in, size_t in_size, std::atomic<bool>
   return {};
 }
 
-void precise_nano_sleep(int64_t nanoseconds, std::atomic<bool> &interrupt_requested) {
-  struct timespec req, rem;
-  req.tv_sec = nanoseconds / 1000000000;
-  req.tv_nsec = nanoseconds % 1000000000;
-  while (!interrupt_requested) {
-#ifdef __APPLE__
-    int ret = nanosleep(&req, &rem);
-    if (ret == 0 || errno != EINTR)
-      break;
-#else
-    int ret = clock_nanosleep(CLOCK_MONOTONIC, 0, &req, &rem);
-    if (ret == 0 || ret != EINTR)
-      break;
-#endif
-    // Retry sleep if interrupted by a signal
-    req = rem;
-  }
-}
-
 std::string sha256(const std::string &str) {
   unsigned char hash[SHA256_DIGEST_LENGTH];
   SHA256_CTX sha256;